@@ -0,0 +1,86 @@
+#include "Benchmark.h"
+
+#include <memory>
+
+#include "Models/CfgModel.h"
+#include "Models/EnvModel.h"
+#include "Models/RegionBoxModel.h"
+#include "Models/Vizmo.h"
+#include "Utilities/MPUtils.h"
+#include "Utilities/VizmoExceptions.h"
+
+#ifdef PMPCfg
+#include "MotionPlanning/VizmoTraits.h"
+#elif defined(PMPState)
+#include "MotionPlanning/VizmoStateTraits.h"
+#endif
+
+VizmoProblem*& GetVizmoProblem();
+
+namespace {
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief avoid [regions] [checks]: checks per second of the avoid region
+  ///        validity checker with the region tree, against the same checker
+  ///        testing every region. Random boxes are added to the environment
+  ///        as avoid regions, and random cfgs of the first robot are checked.
+  ///        The XML file must define both checkers, as VizmoExamples.xml does.
+  void
+  AvoidBenchmark(const vector<string>& _args) {
+    size_t numRegions = stoul(Benchmark::Arg(_args, 0, "100"));
+    size_t numChecks = stoul(Benchmark::Arg(_args, 1, "10000"));
+
+    EnvModel* env = GetVizmo().GetEnv();
+    if(!env)
+      throw ParseException(WHERE, "The avoid benchmark needs an environment "
+          "(-e).");
+
+    //Boxes a tenth of the environment across, anywhere within it
+    const Point3d& center = env->GetCenter();
+    double radius = env->GetRadius(), half = radius / 20;
+    for(size_t i = 0; i < numRegions; ++i) {
+      Point3d c;
+      for(size_t j = 0; j < 3; ++j)
+        c[j] = center[j] + radius * (2 * DRand() - 1);
+      EnvModel::RegionModelPtr r(new RegionBoxModel(
+          make_pair(c[0] - half, c[0] + half),
+          make_pair(c[1] - half, c[1] + half),
+          make_pair(c[2] - half, c[2] + half)));
+      r->SetType(RegionModel::AVOID);
+      env->AddAvoidRegion(r);
+    }
+
+    vector<CfgModel> cfgs(numChecks);
+    for(auto& c : cfgs)
+      c.GetRandomCfg(env->GetEnvironment());
+
+    auto broadPhase = GetVizmoProblem()->GetValidityChecker(
+        "AvoidRegionValidity");
+    auto reference = GetVizmoProblem()->GetValidityChecker(
+        "AvoidRegionValidityReference");
+
+    //The region tree is built on the first check, so it is not timed.
+    broadPhase->IsValid(cfgs.front(), "vizmo-bench");
+
+    size_t validBroadPhase = 0, validReference = 0;
+    double referenceTime = Benchmark::Seconds([&]() {
+        for(auto& c : cfgs)
+          validReference += reference->IsValid(c, "vizmo-bench");
+      });
+    double broadPhaseTime = Benchmark::Seconds([&]() {
+        for(auto& c : cfgs)
+          validBroadPhase += broadPhase->IsValid(c, "vizmo-bench");
+      });
+
+    Benchmark::Report("avoid", "regions", env->GetAvoidRegions().size(), "");
+    Benchmark::Report("avoid", "reference", numChecks / referenceTime,
+        "checks/s");
+    Benchmark::Report("avoid", "broad phase", numChecks / broadPhaseTime,
+        "checks/s");
+    if(validBroadPhase != validReference)
+      Benchmark::Report("avoid", "disagreements",
+          double(validReference) - double(validBroadPhase), "");
+  }
+
+  Benchmark::Registration avoid("avoid", "[regions] [checks]", AvoidBenchmark);
+}
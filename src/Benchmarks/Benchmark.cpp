@@ -0,0 +1,129 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <limits>
+#include <map>
+
+#ifdef __APPLE__
+  #include <GLUT/glut.h>
+  #include <OpenGL/glu.h>
+#else
+  #include <glut.h>
+  #include <GL/glu.h>
+#endif
+
+#include <unistd.h>
+
+#include "Models/EnvModel.h"
+#include "Models/Vizmo.h"
+#include "Utilities/VizmoExceptions.h"
+
+namespace Benchmark {
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief The registered subcommands and their usage lines, by name.
+  static map<string, pair<string, Command>>&
+  Commands() {
+    static map<string, pair<string, Command>> commands;
+    return commands;
+  }
+
+
+  Registration::
+  Registration(const string& _name, const string& _usage, Command _command) {
+    Commands()[_name] = make_pair(_usage, _command);
+  }
+
+
+  bool
+  Run(const string& _name, const vector<string>& _args) {
+    auto command = Commands().find(_name);
+    if(command == Commands().end())
+      return false;
+    command->second.second(_args);
+    return true;
+  }
+
+
+  void
+  PrintUsage(ostream& _os) {
+    for(const auto& command : Commands())
+      _os << "  " << command.first << " " << command.second.first << endl;
+  }
+
+
+  double
+  Seconds(const function<void()>& _f, size_t _repeats) {
+    typedef chrono::steady_clock Clock;
+    double fastest = numeric_limits<double>::max();
+    for(size_t i = 0; i < max(_repeats, size_t(1)); ++i) {
+      Clock::time_point start = Clock::now();
+      _f();
+      chrono::duration<double> elapsed = Clock::now() - start;
+      fastest = min(fastest, elapsed.count());
+    }
+    return fastest;
+  }
+
+
+  size_t
+  ResidentBytes() {
+    size_t pages = 0, resident = 0;
+    ifstream statm("/proc/self/statm");
+    statm >> pages >> resident;
+    return resident * sysconf(_SC_PAGESIZE);
+  }
+
+
+  void
+  Report(const string& _benchmark, const string& _case, double _value,
+      const string& _unit) {
+    cout << _benchmark << "\t" << _case << "\t" << _value << "\t" << _unit
+         << endl;
+  }
+
+
+  string
+  Arg(const vector<string>& _args, size_t _i, const string& _default) {
+    if(_i < _args.size())
+      return _args[_i];
+    if(_default.empty())
+      throw ParseException(WHERE, "Missing argument " + to_string(_i + 1) +
+          ".");
+    return _default;
+  }
+
+
+  void
+  CreateContext(int _width, int _height) {
+    glutInitDisplayMode(GLUT_RGBA | GLUT_DOUBLE | GLUT_DEPTH);
+    glutInitWindowSize(_width, _height);
+    glutCreateWindow("vizmo-bench");
+    glutHideWindow();
+
+    glViewport(0, 0, _width, _height);
+    glEnable(GL_DEPTH_TEST);
+    glClearColor(1, 1, 1, 1);
+  }
+
+
+  void
+  AimCamera() {
+    //Look at the whole environment from outside of it
+    EnvModel* env = GetVizmo().GetEnv();
+    Point3d center = env ? env->GetCenter() : Point3d();
+    double radius = env && env->GetRadius() > 0 ? env->GetRadius() : 1;
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    GLint viewport[4];
+    glGetIntegerv(GL_VIEWPORT, viewport);
+    gluPerspective(60, double(viewport[2]) / viewport[3], radius / 100,
+        radius * 10);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+    gluLookAt(center[0], center[1], center[2] + 2.5 * radius,
+        center[0], center[1], center[2], 0, 1, 0);
+  }
+}
@@ -0,0 +1,74 @@
+#ifndef BENCHMARK_H_
+#define BENCHMARK_H_
+
+#include <functional>
+#include <iostream>
+#include <string>
+#include <vector>
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief   Shared pieces of the vizmo-bench driver.
+/// \details Each benchmark is a subcommand registered from its own source file.
+///          It times a current code path against a reference copy of the path
+///          it replaced and prints one tab-separated line per measurement:
+///          benchmark, case, value, and unit. The driver loads the environment
+///          through the Vizmo singleton, as the GUI does, before running a
+///          subcommand.
+////////////////////////////////////////////////////////////////////////////////
+namespace Benchmark {
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief A subcommand, given its positional arguments.
+  /// \throws ParseException on bad arguments.
+  typedef function<void(const vector<string>&)> Command;
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Registers a subcommand during static initialization.
+  struct Registration {
+    Registration(const string& _name, const string& _usage, Command _command);
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Run a registered subcommand.
+  /// \return False if no subcommand has that name.
+  bool Run(const string& _name, const vector<string>& _args);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Print the usage line of every subcommand.
+  void PrintUsage(ostream& _os);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Time a function on the wall clock.
+  /// \param[in] _repeats The number of runs.
+  /// \return The fastest run, in seconds.
+  double Seconds(const function<void()>& _f, size_t _repeats = 1);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the resident memory of the process, in bytes.
+  size_t ResidentBytes();
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Print a measurement.
+  void Report(const string& _benchmark, const string& _case, double _value,
+      const string& _unit);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Get a positional argument, or a default if there are too few.
+  /// \throws ParseException if there is no default and the argument is missing.
+  string Arg(const vector<string>& _args, size_t _i,
+      const string& _default = "");
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Open a hidden GL window. Models that upload textures or buffers
+  ///        need this before they are loaded.
+  /// \param[in] _width The window width in pixels.
+  /// \param[in] _height The window height in pixels.
+  void CreateContext(int _width, int _height);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Aim the camera at the whole loaded environment.
+  void AimCamera();
+}
+
+#endif
@@ -0,0 +1,80 @@
+#include <iostream>
+using namespace std;
+
+#ifdef __APPLE__
+  #include <GLUT/glut.h>
+#else
+  #include <glut.h>
+#endif
+
+#include <QApplication>
+
+#include "Benchmark.h"
+#include "Models/Vizmo.h"
+#include "Utilities/PMPLExceptions.h"
+
+static void
+Usage(const char* _name) {
+  cerr << "Usage: " << _name << " [-e env] [-x xml] [-m map] [-p path] "
+       << "[-d debug] benchmark [args...]\n\nBenchmarks:" << endl;
+  Benchmark::PrintUsage(cerr);
+  exit(1);
+}
+
+
+int
+main(int _argc, char** _argv) {
+  // Initialize glut and Qt before getopt so that they can strip their options.
+  glutInit(&_argc, _argv);
+  QApplication app(_argc, _argv);
+
+  //parse command line args
+  string xml = "Examples/VizmoExamples.xml";
+  bool hasEnv = false;
+  char arg;
+  opterr = 0;
+  while((arg = getopt(_argc, _argv, "+e:x:m:p:d:")) != -1) {
+    switch(arg) {
+      case 'e':
+        GetVizmo().SetEnvFileName(optarg);
+        hasEnv = true;
+        break;
+      case 'x':
+        xml = optarg;
+        break;
+      case 'm':
+        GetVizmo().SetMapFileName(optarg);
+        break;
+      case 'p':
+        GetVizmo().SetPathFileName(optarg);
+        break;
+      case 'd':
+        GetVizmo().SetDebugFileName(optarg);
+        break;
+      default:
+        Usage(_argv[0]);
+    }
+  }
+  if(optind >= _argc)
+    Usage(_argv[0]);
+
+  string name = _argv[optind];
+  vector<string> args(_argv + optind + 1, _argv + _argc);
+
+  // Textures and buffers are uploaded while loading, so the GL context comes
+  // first. Benchmarks of single files run without an environment.
+  Benchmark::CreateContext(800, 600);
+  GetVizmo().SetXMLFileName(xml);
+  if(hasEnv && !GetVizmo().InitModels())
+    return 1;
+
+  try {
+    if(!Benchmark::Run(name, args))
+      Usage(_argv[0]);
+  }
+  catch(PMPLException& _e) {
+    cerr << _e.what() << endl;
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,225 @@
+#include "Benchmark.h"
+
+#include <cmath>
+#include <memory>
+
+#ifdef __APPLE__
+  #include <GLUT/glut.h>
+#else
+  #include <glut.h>
+#endif
+
+#include <containers/sequential/graph/graph.h>
+
+#include "IModel.h"
+#include "ModelFactory.h"
+
+#include "Models/PolyhedronModel.h"
+#include "Utilities/VizmoExceptions.h"
+
+namespace {
+
+  typedef PolyhedronModel::PtVector PtVector;
+  typedef PolyhedronModel::TriVector TriVector;
+
+  /// The mesh graph of the reference wire frame, with the triangles on either
+  /// side of each edge.
+  typedef stapl::sequential::graph<stapl::UNDIRECTED, stapl::NONMULTIEDGES,
+      int, Vector<int, 2>> ModelGraph;
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief The edges of a mesh as the reference wire frame found them: one
+  ///        find_edge per triangle side in a stapl graph.
+  void
+  BuildModelGraph(IModel* _model, ModelGraph& _graph) {
+    const PtVector& points = _model->GetVertices();
+    const TriVector& tris = _model->GetTriP();
+
+    for(size_t i = 0; i < points.size(); ++i)
+      _graph.add_vertex(i, i);
+
+    for(size_t i = 0; i < tris.size(); ++i) {
+      for(size_t j = 0; j < 3; ++j) {
+        int a = tris[i][j];
+        int b = tris[i][(j+1)%3];
+        ModelGraph::vertex_iterator vit;
+        ModelGraph::adj_edge_iterator eit;
+        ModelGraph::edge_descriptor eid(a, b);
+        if(_graph.find_edge(eid, vit, eit))
+          (*eit).property()[1] = i;
+        else
+          _graph.add_edge(a, b, Vector<int, 2>(i, -1));
+      }
+    }
+  }
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief The display lists of a mesh loaded the way PolyhedronModel did
+  ///        before its vertex arrays: the solid, wired, and normal lines
+  ///        compiled from immediate-mode doubles.
+  struct ReferenceMesh {
+
+    ReferenceMesh(const string& _filename) {
+      unique_ptr<IModel> model(CreateModelLoader(_filename, false));
+      if(!model)
+        throw BuildException(WHERE, "File '" + _filename + "' does not exist.");
+
+      bool isObj = _filename.substr(_filename.rfind('.')) == ".obj" &&
+          !model->GetNormals().empty();
+
+      const PtVector& points = model->GetVertices();
+      const TriVector& tris = model->GetTriP();
+      vector<Vector3d> norms;
+      norms.reserve(tris.size());
+      for(auto& tri : tris) {
+        Vector3d v1 = points[tri[1]] - points[tri[0]];
+        Vector3d v2 = points[tri[2]] - points[tri[0]];
+        norms.emplace_back((v1 % v2).normalize());
+      }
+
+      m_solidID = glGenLists(1);
+      glNewList(m_solidID, GL_COMPILE);
+      glBegin(GL_TRIANGLES);
+      if(isObj) {
+        const vector<Vector3d>& normals = model->GetNormals();
+        const vector<Vector2d>& textures = model->GetTextureCoords();
+        const TriVector& triN = model->GetTriN();
+        const TriVector& triT = model->GetTriT();
+        for(size_t i = 0; i < tris.size(); ++i)
+          for(size_t j = 0; j < 3; ++j) {
+            if(!textures.empty())
+              glTexCoord2dv(textures[triT[i][j]]);
+            glNormal3dv(normals[triN[i][j]]);
+            glVertex3dv(points[tris[i][j]]);
+          }
+      }
+      else
+        for(size_t i = 0; i < tris.size(); ++i) {
+          glNormal3dv(norms[i]);
+          for(size_t j = 0; j < 3; ++j)
+            glVertex3dv(points[tris[i][j]]);
+        }
+      glEnd();
+      glEndList();
+
+      m_normalsID = glGenLists(1);
+      glNewList(m_normalsID, GL_COMPILE);
+      glBegin(GL_LINES);
+      for(size_t i = 0; i < tris.size(); ++i) {
+        Point3d center = (points[tris[i][0]] + points[tris[i][1]] +
+            points[tris[i][2]]) / 3;
+        glVertex3dv(center);
+        glVertex3dv(center + norms[i]);
+      }
+      glEnd();
+      glEndList();
+
+      ModelGraph graph;
+      BuildModelGraph(model.get(), graph);
+      m_wiredID = glGenLists(1);
+      glNewList(m_wiredID, GL_COMPILE);
+      glBegin(GL_LINES);
+      for(auto eit = graph.edges_begin(); eit != graph.edges_end(); ++eit) {
+        int tril = (*eit).property()[0];
+        int trir = (*eit).property()[1];
+        if(tril == -1 || trir == -1 ||
+            1 - fabs(norms[tril] * norms[trir]) > 1e-3) {
+          glVertex3dv(points[(*eit).source()]);
+          glVertex3dv(points[(*eit).target()]);
+        }
+      }
+      glEnd();
+      glEndList();
+    }
+
+    ~ReferenceMesh() {
+      glDeleteLists(m_solidID, 1);
+      glDeleteLists(m_wiredID, 1);
+      glDeleteLists(m_normalsID, 1);
+    }
+
+    GLuint m_solidID, m_wiredID, m_normalsID;
+  };
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Time loading a mesh and the memory it holds once loaded.
+  template <typename MeshType>
+  void
+  Load(const string& _case, const string& _filename, size_t _repeats,
+      const function<MeshType*()>& _load) {
+    //Each load is dropped before the next, so the mesh cache never hits.
+    double seconds = Benchmark::Seconds([&]() {
+        unique_ptr<MeshType> mesh(_load());
+        glFinish();
+      }, _repeats);
+    Benchmark::Report("mesh", _case + " load", 1000 * seconds, "ms");
+
+    size_t before = Benchmark::ResidentBytes();
+    unique_ptr<MeshType> mesh(_load());
+    glFinish();
+    Benchmark::Report("mesh", _case + " memory",
+        double(Benchmark::ResidentBytes() - before) / (1 << 10), "KiB");
+  }
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief mesh file [repeats]: load time and memory of a mesh as display
+  ///        lists against PolyhedronModel's vertex arrays. The file should
+  ///        not be part of a loaded environment, or PolyhedronModel shares
+  ///        its geometry instead of loading it.
+  void
+  MeshBenchmark(const vector<string>& _args) {
+    string filename = Benchmark::Arg(_args, 0);
+    size_t repeats = stoul(Benchmark::Arg(_args, 1, "10"));
+
+    Load<ReferenceMesh>("display lists", filename, repeats,
+        [&]() {return new ReferenceMesh(filename);});
+    Load<PolyhedronModel>("vertex arrays", filename, repeats,
+        [&]() {
+          return new PolyhedronModel(filename, GMSPolyhedron::COMAdjust::COM);
+        });
+  }
+
+  Benchmark::Registration mesh("mesh", "file [repeats]", MeshBenchmark);
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Exposes the edge table of PolyhedronModel's wire frame.
+  struct EdgeTable : public PolyhedronModel {
+    using PolyhedronModel::MeshEdge;
+    using PolyhedronModel::BuildEdges;
+  };
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief edges file [repeats]: time to find the wire-frame edges of a mesh,
+  ///        with a stapl graph against the sorted edge table.
+  void
+  EdgesBenchmark(const vector<string>& _args) {
+    string filename = Benchmark::Arg(_args, 0);
+    size_t repeats = stoul(Benchmark::Arg(_args, 1, "10"));
+
+    unique_ptr<IModel> model(CreateModelLoader(filename, false));
+    if(!model)
+      throw BuildException(WHERE, "File '" + filename + "' does not exist.");
+    Benchmark::Report("edges", "triangles", model->GetTriP().size(), "");
+
+    double graph = Benchmark::Seconds([&]() {
+        ModelGraph g;
+        BuildModelGraph(model.get(), g);
+      }, repeats);
+
+    vector<EdgeTable::MeshEdge> edges;
+    double table = Benchmark::Seconds([&]() {
+        EdgeTable::BuildEdges(model.get(), edges);
+      }, repeats);
+
+    Benchmark::Report("edges", "edges", edges.size(), "");
+    Benchmark::Report("edges", "stapl graph", 1000 * graph, "ms");
+    Benchmark::Report("edges", "sorted table", 1000 * table, "ms");
+  }
+
+  Benchmark::Registration edges("edges", "file [repeats]", EdgesBenchmark);
+}
@@ -0,0 +1,161 @@
+#include "Benchmark.h"
+
+#include <fstream>
+#include <memory>
+#include <sstream>
+
+#include <QThreadPool>
+
+#include "Models/CfgModel.h"
+#include "Models/DebugModel.h"
+#include "Models/EdgeModel.h"
+#include "Models/MapModel.h"
+#include "Models/PathModel.h"
+#include "Models/Vizmo.h"
+#include "Utilities/VizmoExceptions.h"
+
+namespace {
+
+  typedef MapModel<CfgModel, EdgeModel> Map;
+
+  /*--------------------------- Serial References ----------------------------*/
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Read a .map file with stream extraction on one thread, as
+  ///        MapModel did before the parallel parser.
+  void
+  ReadMapSerial(const string& _filename) {
+    Map map;
+    Map::RGraph* graph = map.GetGraph();
+
+    ifstream ifs(_filename);
+    string s;
+    GoToNext(ifs);
+    getline(ifs, s);
+    getline(ifs, s);
+
+    size_t numVertices, numEdges;
+    Map::VID maxVID;
+    if(!(ifs >> numVertices >> numEdges >> maxVID))
+      throw ParseException(WHERE, "Bad graph header in '" + _filename + "'.");
+
+    CfgModel cfg;
+    Map::VID vid, target;
+    size_t numAdjacent;
+    for(size_t i = 0; i < numVertices; ++i) {
+      if(!(ifs >> vid >> cfg >> numAdjacent))
+        throw ParseException(WHERE, "Failed reading vertex " + to_string(i) +
+            " of '" + _filename + "'.");
+      graph->add_vertex(vid, cfg);
+      for(size_t j = 0; j < numAdjacent; ++j) {
+        EdgeModel weight;
+        if(!(ifs >> target >> weight))
+          throw ParseException(WHERE, "Failed reading an edge of vertex " +
+              to_string(vid) + " in '" + _filename + "'.");
+        graph->add_edge(vid, target, weight);
+      }
+    }
+  }
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Read a .path file with stream extraction on one thread.
+  void
+  ReadPathSerial(const string& _filename) {
+    ifstream ifs(_filename);
+    string s;
+    getline(ifs, s);
+    getline(ifs, s);
+
+    size_t pathSize = 0;
+    ifs >> pathSize;
+    vector<CfgModel> path(pathSize);
+    for(size_t i = 0; i < pathSize && ifs; ++i)
+      ifs >> path[i];
+  }
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Read the cfgs of every instruction of a .vd file with stream
+  ///        extraction on one thread, as DebugModel did before the parallel
+  ///        parser.
+  void
+  ReadDebugSerial(const string& _filename) {
+    static const pair<const char*, size_t> cfgCounts[] = {
+      {"AddNode", 1}, {"AddEdge", 2}, {"AddTempCfg", 1}, {"AddTempRay", 1},
+      {"AddTempEdge", 2}, {"RemoveNode", 1}, {"RemoveEdge", 2},
+      {"QueryInstruction", 2}
+    };
+
+    ifstream ifs(_filename);
+    vector<CfgModel> cfgs;
+    string line, name;
+    while(getline(ifs, line)) {
+      istringstream iss(line);
+      iss >> name;
+      for(const auto& count : cfgCounts)
+        if(name == count.first)
+          for(size_t i = 0; i < count.second; ++i) {
+            cfgs.emplace_back();
+            iss >> cfgs.back();
+          }
+    }
+  }
+
+
+  /*-------------------------------- Benchmark -------------------------------*/
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief parse map|path|debug file [repeats]: parse time of a text file on
+  ///        one thread with streams, then with TextParser on 1 to 16 threads.
+  void
+  ParseBenchmark(const vector<string>& _args) {
+    string kind = Benchmark::Arg(_args, 0);
+    string filename = Benchmark::Arg(_args, 1);
+    size_t repeats = stoul(Benchmark::Arg(_args, 2, "3"));
+    if(!GetVizmo().GetEnv())
+      throw ParseException(WHERE, "The parse benchmark needs an environment "
+          "(-e) to read cfgs.");
+
+    //The path and debug models are built once, and only their parse is
+    //timed from then on.
+    function<void()> serial, parallel;
+    unique_ptr<PathModel> path;
+    unique_ptr<DebugModel> debug;
+    if(kind == "map") {
+      serial = [&]() {ReadMapSerial(filename);};
+      parallel = [&]() {
+        Map map;
+        map.SetFilename(filename);
+        map.ParseFile();
+      };
+    }
+    else if(kind == "path") {
+      path.reset(new PathModel(filename));
+      serial = [&]() {ReadPathSerial(filename);};
+      parallel = [&]() {path->ParseFile();};
+    }
+    else if(kind == "debug") {
+      debug.reset(new DebugModel(filename));
+      serial = [&]() {ReadDebugSerial(filename);};
+      parallel = [&]() {debug->ParseFile();};
+    }
+    else
+      throw ParseException(WHERE, "Unknown file kind '" + kind + "'.");
+
+    Benchmark::Report("parse", kind + " streams",
+        Benchmark::Seconds(serial, repeats), "s");
+
+    QThreadPool* pool = QThreadPool::globalInstance();
+    int maxThreads = pool->maxThreadCount();
+    for(int threads = 1; threads <= 16; threads *= 2) {
+      pool->setMaxThreadCount(threads);
+      Benchmark::Report("parse", kind + " " + to_string(threads) + " threads",
+          Benchmark::Seconds(parallel, repeats), "s");
+    }
+    pool->setMaxThreadCount(maxThreads);
+  }
+
+  Benchmark::Registration parse("parse", "map|path|debug file [repeats]",
+      ParseBenchmark);
+}
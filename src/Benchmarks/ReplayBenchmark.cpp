@@ -0,0 +1,154 @@
+#include "Benchmark.h"
+
+#include <algorithm>
+#include <fstream>
+#include <memory>
+
+#ifdef __APPLE__
+  #include <GLUT/glut.h>
+#else
+  #include <glut.h>
+#endif
+
+#include "Models/ActiveMultiBodyModel.h"
+#include "Models/CfgModel.h"
+#include "Models/DebugModel.h"
+#include "Models/EnvModel.h"
+#include "Models/Vizmo.h"
+#include "Utilities/MPUtils.h"
+#include "Utilities/VizmoExceptions.h"
+
+namespace {
+
+  typedef DebugModel::MM Map;
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Write a debug file of AddNode and AddEdge instructions for the
+  ///        first robot. Every other instruction adds a node at a random
+  ///        position in the environment, and the rest connect two random
+  ///        nodes, so CCs form and merge throughout the replay.
+  void
+  WriteDebugFile(const string& _filename, size_t _instructions) {
+    EnvModel* env = GetVizmo().GetEnv();
+    size_t dofs = env->GetRobot(0)->Dofs();
+    const Point3d& center = env->GetCenter();
+    double radius = env->GetRadius();
+
+    ofstream ofs(_filename);
+    if(!ofs)
+      throw ParseException(WHERE, "Cannot write '" + _filename + "'.");
+
+    vector<CfgModel> nodes;
+    for(size_t i = 0; i < _instructions; ++i) {
+      if(i % 2 == 0 || nodes.size() < 2) {
+        vector<double> v(dofs);
+        for(size_t j = 0; j < dofs; ++j)
+          v[j] = j < 3 ? center[j] + radius * (2 * DRand() - 1) : DRand();
+        nodes.emplace_back(0);
+        nodes.back().SetCfg(v);
+        ofs << "AddNode " << nodes.back() << endl;
+      }
+      else
+        ofs << "AddEdge " << nodes[LRand() % nodes.size()] << " "
+            << nodes[LRand() % nodes.size()] << endl;
+    }
+  }
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief The Cfg2VID lookup that the index replaced: a scan of every
+  ///        vertex.
+  Map::VID
+  Cfg2VIDScan(Map* _map, const CfgModel& _target) {
+    Map::RGraph* graph = _map->GetGraph();
+    for(auto vi = graph->begin(); vi != graph->end(); ++vi)
+      if(vi->property() == _target)
+        return vi->descriptor();
+    return -1;
+  }
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief replay file [instructions] [steps]: load and full replay time of
+  ///        a debug file, the time to step through it, and Cfg2VID lookups
+  ///        through the index against a scan. Given a number of
+  ///        instructions, the file is first written with that many.
+  void
+  ReplayBenchmark(const vector<string>& _args) {
+    string filename = Benchmark::Arg(_args, 0);
+    size_t instructions = stoul(Benchmark::Arg(_args, 1, "0"));
+    size_t steps = stoul(Benchmark::Arg(_args, 2, "1000"));
+    if(!GetVizmo().GetEnv())
+      throw ParseException(WHERE, "The replay benchmark needs an environment "
+          "(-e).");
+
+    if(instructions)
+      WriteDebugFile(filename, instructions);
+
+    //Loading replays the whole file once to place the keyframes.
+    unique_ptr<DebugModel> debug;
+    size_t memory = Benchmark::ResidentBytes();
+    Benchmark::Report("replay", "load",
+        Benchmark::Seconds([&]() {debug.reset(new DebugModel(filename));}),
+        "s");
+    Benchmark::Report("replay", "load memory",
+        double(Benchmark::ResidentBytes() - memory) / (1 << 20), "MiB");
+    Benchmark::Report("replay", "instructions", debug->GetSize() - 1, "");
+
+    //Step forward and back over evenly spaced frames, as the slider does.
+    Benchmark::AimCamera();
+    CfgModel::SetShape(CfgModel::Point);
+    size_t last = debug->GetSize() - 1;
+    steps = max<size_t>(1, min(steps, last));
+    auto step = [&](size_t _frame) {
+      debug->ConfigureFrame(_frame);
+      glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+      debug->DrawRender();
+      glFinish();
+    };
+    double forward = Benchmark::Seconds([&]() {
+        for(size_t i = 1; i <= steps; ++i)
+          step(last * i / steps);
+      });
+    Benchmark::Report("replay", "step forward", 1000 * forward / steps,
+        "ms/step");
+    double backward = Benchmark::Seconds([&]() {
+        for(size_t i = steps; i > 0; --i)
+          step(last * (i - 1) / steps);
+      });
+    Benchmark::Report("replay", "step backward", 1000 * backward / steps,
+        "ms/step");
+    Benchmark::Report("replay", "seek start to end",
+        1000 * Benchmark::Seconds([&]() {step(0); step(last);}), "ms");
+
+    //Look up the cfgs of the final roadmap both ways.
+    Map* map = debug->GetMapModel();
+    vector<CfgModel> targets;
+    Map::RGraph* graph = map->GetGraph();
+    for(auto vi = graph->begin(); vi != graph->end() && targets.size() < 1000;
+        ++vi)
+      targets.push_back(vi->property());
+    if(targets.empty())
+      return;
+
+    size_t misses = 0;
+    double scan = Benchmark::Seconds([&]() {
+        for(auto& c : targets)
+          misses += Cfg2VIDScan(map, c) == Map::VID(-1);
+      });
+    double index = Benchmark::Seconds([&]() {
+        for(auto& c : targets)
+          misses += map->Cfg2VID(c) == Map::VID(-1);
+      });
+    Benchmark::Report("replay", "vertices", graph->get_num_vertices(), "");
+    Benchmark::Report("replay", "Cfg2VID scan", 1e6 * scan / targets.size(),
+        "us/lookup");
+    Benchmark::Report("replay", "Cfg2VID index", 1e6 * index / targets.size(),
+        "us/lookup");
+    if(misses)
+      Benchmark::Report("replay", "Cfg2VID misses", misses, "");
+  }
+
+  Benchmark::Registration replay("replay", "file [instructions] [steps]",
+      ReplayBenchmark);
+}
@@ -0,0 +1,109 @@
+#include "Benchmark.h"
+
+#ifdef __APPLE__
+  #include <GLUT/glut.h>
+#else
+  #include <glut.h>
+#endif
+
+#include "Models/CCModel.h"
+#include "Models/CfgModel.h"
+#include "Models/EdgeModel.h"
+#include "Models/MapModel.h"
+#include "Models/Vizmo.h"
+#include "Utilities/VizmoExceptions.h"
+
+namespace {
+
+  typedef MapModel<CfgModel, EdgeModel> Map;
+  typedef CCModel<CfgModel, EdgeModel> CC;
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief The immediate-mode roadmap draw that the CC vertex arrays
+  ///        replaced: every node and edge point is sent with glVertex3dv
+  ///        each frame, looking up edge targets in the graph. It walks the
+  ///        whole graph rather than one CC at a time, which issues the same
+  ///        vertices without the per-CC color changes.
+  void
+  DrawImmediate(Map::RGraph* _graph) {
+    glDisable(GL_LIGHTING);
+    glPointSize(CfgModel::GetPointSize());
+    glBegin(GL_POINTS);
+    for(auto vi = _graph->begin(); vi != _graph->end(); ++vi)
+      glVertex3dv(vi->property().GetPoint());
+    glEnd();
+
+    glLineWidth(EdgeModel::m_edgeThickness);
+    glBegin(GL_LINES);
+    for(auto vi = _graph->begin(); vi != _graph->end(); ++vi) {
+      for(auto ei = vi->begin(); ei != vi->end(); ++ei) {
+        if(CC::SkipEdge(_graph, (*ei).source(), (*ei).target()))
+          continue;
+        glVertex3dv(vi->property().GetPoint());
+        for(auto& c : (*ei).property().GetIntermediates()) {
+          glVertex3dv(c.GetPoint());
+          glVertex3dv(c.GetPoint());
+        }
+        glVertex3dv(_graph->find_vertex((*ei).target())->property().GetPoint());
+      }
+    }
+    glEnd();
+  }
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Time one frame of a draw function, including the GPU work.
+  double
+  FrameSeconds(const function<void()>& _draw, size_t _frames) {
+    return Benchmark::Seconds([&]() {
+        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+        _draw();
+        glFinish();
+      }, _frames);
+  }
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief roadmap [frames] [lodPixelSize]: frame time of the loaded map
+  ///        drawn as points, immediate mode against the CC vertex arrays.
+  void
+  RoadmapBenchmark(const vector<string>& _args) {
+    size_t frames = stoul(Benchmark::Arg(_args, 0, "100"));
+    double lodPixelSize = stod(Benchmark::Arg(_args, 1, "0"));
+
+    Map* map = GetVizmo().GetMap();
+    if(!map)
+      throw ParseException(WHERE, "The roadmap benchmark needs a map (-m).");
+
+    CfgModel::SetShape(CfgModel::Point);
+    map->SetRenderMode(SOLID_MODE);
+    Benchmark::AimCamera();
+
+    Map::RGraph* graph = map->GetGraph();
+    Benchmark::Report("roadmap", "vertices", graph->get_num_vertices(), "");
+    Benchmark::Report("roadmap", "edges", graph->get_num_edges(), "");
+
+    //Warm both paths up once so that first-use costs are not measured.
+    DrawImmediate(graph);
+    map->DrawRender();
+
+    Benchmark::Report("roadmap", "immediate",
+        1000 * FrameSeconds([graph]() {DrawImmediate(graph);}, frames),
+        "ms/frame");
+
+    GetVizmo().SetLODPixelSize(0);
+    Benchmark::Report("roadmap", "arrays",
+        1000 * FrameSeconds([map]() {map->DrawRender();}, frames), "ms/frame");
+
+    if(lodPixelSize > 0) {
+      GetVizmo().SetLODPixelSize(lodPixelSize);
+      Benchmark::Report("roadmap", "arrays+lod",
+          1000 * FrameSeconds([map]() {map->DrawRender();}, frames),
+          "ms/frame");
+      GetVizmo().SetLODPixelSize(0);
+    }
+  }
+
+  Benchmark::Registration roadmap("roadmap", "[frames] [lodPixelSize]",
+      RoadmapBenchmark);
+}
@@ -205,8 +205,14 @@ void
 EdgeEditDialog::
 FinalizeEdgeEdit(int _accepted) {
   if(_accepted == 1) {
-    if(m_tempEdge->IsValid())
+    if(m_tempEdge->IsValid()) {
       m_originalEdge->SetIntermediates(m_tempEdge->GetIntermediates());
+      //Intermediates are cached in the CC vertex arrays
+      if(GetVizmo().GetMap()) {
+        GetVizmo().GetMap()->MarkDirty(m_originalEdge->GetStartCfg()->GetIndex());
+        GetVizmo().GetMap()->RefreshMap();
+      }
+    }
     else
       //For now, user must start all over again in this case
       QMessageBox::about(this, "", "Invalid edge!");
@@ -127,7 +127,7 @@ void
 FileListDialog::
 ChangeMap() {
   QString fn = QFileDialog::getOpenFileName(this, "Choose a map file",
-      GetMainWindow()->GetLastDir(), "Map File (*.map)");
+      GetMainWindow()->GetLastDir(), "Map File (*.map *.bmap)");
   if(!fn.isEmpty()) {
     m_mapFilename->setText(fn);
     m_mapCheckBox->setChecked(true);
@@ -316,6 +316,10 @@ GetAssociatedFiles(const vector<string>& _filename) {
       mapname = name + ".map";
       envname = ParseMapHeader(mapname);
     }
+    else if(FileExists(name + ".bmap")) {
+      mapname = name + ".bmap";
+      envname = ParseMapHeader(mapname);
+    }
 
     if(FileExists(name + ".query"))
       queryname = name + ".query";
@@ -49,6 +49,8 @@ CreateActions() {
       tr("Save Query"), this);
   m_actions["saveRoadmap"] = new QAction(QPixmap(savemap),
       tr("Save Roadmap"), this);
+  m_actions["convertRoadmap"] = new QAction(QPixmap(savemap),
+      tr("Convert Roadmap"), this);
   m_actions["savePath"] = new QAction(QPixmap(savepath),
       tr("Save Path"), this);
   m_actions["quit"] = new QAction(QPixmap(quiticon),
@@ -64,6 +66,7 @@ CreateActions() {
   m_actions["saveFile"]->setEnabled(false);
   m_actions["saveQuery"]->setEnabled(false);
   m_actions["saveRoadmap"]->setEnabled(false);
+  m_actions["convertRoadmap"]->setEnabled(false);
   m_actions["savePath"]->setEnabled(false);
 
   //3. Make connections
@@ -77,6 +80,8 @@ CreateActions() {
       this, SLOT(SaveQryFile()));
   connect(m_actions["saveRoadmap"], SIGNAL(triggered()),
       this, SLOT(SaveRoadmap()));
+  connect(m_actions["convertRoadmap"], SIGNAL(triggered()),
+      this, SLOT(ConvertRoadmap()));
   connect(m_actions["savePath"], SIGNAL(triggered()),
       this, SLOT(SavePath()));
   connect(m_actions["quit"], SIGNAL(triggered()),
@@ -90,6 +95,9 @@ SetHelpTips() {
   m_actions["openFile"]->setWhatsThis("Click this button to open a <b>File</b>."
       "<br>You can separately specify the preferred Map, Environment, Path, "
       "Debug, and Query files.");
+  m_actions["convertRoadmap"]->setWhatsThis("Click this button to convert a "
+      "roadmap between the text (.map) and binary (.bmap) formats. The "
+      "roadmap must belong to the loaded environment.");
 }
 
 
@@ -108,6 +116,7 @@ Reset() {
   m_actions["saveFile"]->setEnabled(true);
   m_actions["saveQuery"]->setEnabled(true);
   m_actions["saveRoadmap"]->setEnabled(true);
+  m_actions["convertRoadmap"]->setEnabled(true);
   m_actions["savePath"]->setEnabled(true);
 }
 
@@ -119,13 +128,14 @@ LoadFile() {
   /// Handles all local data types, including:
   /// \arg \c .env
   /// \arg \c .map
+  /// \arg \c .bmap
   /// \arg \c .query
   /// \arg \c .path
   /// \arg \c .vd
   /// \arg \c .xml
   QString fn = QFileDialog::getOpenFileName(this,
       "Choose an environment to open", GetMainWindow()->GetLastDir(),
-      "Files (*.env *.map *.query *.path *.vd *.xml)");
+      "Files (*.env *.map *.bmap *.query *.path *.vd *.xml)");
 
   if(!fn.isEmpty()){
     GetMainWindow()->ResetDialogs();
@@ -205,7 +215,7 @@ FileOptions::
 SaveRoadmap() {
   QString fn = QFileDialog::getSaveFileName(this,
       "Choose a file name for the roadmap",
-      GetMainWindow()->GetLastDir(), "Files (*.map)");
+      GetMainWindow()->GetLastDir(), "Files (*.map *.bmap)");
 
   if(!fn.isEmpty()){
     string filename = fn.toStdString();
@@ -220,6 +230,41 @@ SaveRoadmap() {
 }
 
 
+void
+FileOptions::
+ConvertRoadmap() {
+  QString in = QFileDialog::getOpenFileName(this,
+      "Choose a roadmap to convert", GetMainWindow()->GetLastDir(),
+      "Files (*.map *.bmap)");
+  if(in.isEmpty()) {
+    GetMainWindow()->statusBar()->showMessage("Conversion aborted", 2000);
+    return;
+  }
+
+  QString out = QFileDialog::getSaveFileName(this,
+      "Choose a file name for the converted roadmap",
+      GetMainWindow()->GetLastDir(), "Files (*.map *.bmap)");
+  if(out.isEmpty()) {
+    GetMainWindow()->statusBar()->showMessage("Conversion aborted", 2000);
+    return;
+  }
+
+  //Parse and write the graph only, without building CCs for display
+  try {
+    MapModel<CfgModel, EdgeModel> map;
+    map.SetFilename(in.toStdString());
+    map.ParseFile();
+    map.Write(out.toStdString());
+    GetMainWindow()->statusBar()->showMessage("Converted roadmap saved to " +
+        out, 2000);
+  }
+  catch(PMPLException& _e) {
+    GetMainWindow()->AlertUser(_e.what());
+  }
+  GetMainWindow()->SetLastDir(QFileInfo(out).absolutePath());
+}
+
+
 void
 FileOptions::
 SavePath() {
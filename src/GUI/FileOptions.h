@@ -23,6 +23,7 @@ class FileOptions : public OptionsBase {
     void SaveEnv();        ///< Save the current environment to a file.
     void SaveQryFile();    ///< Save the current query to a file.
     void SaveRoadmap();    ///< Save the current roadmap to a file.
+    void ConvertRoadmap(); ///< Convert a roadmap file to the other format.
     void SavePath();       ///< Save the current robot path to a file.
 
   private:
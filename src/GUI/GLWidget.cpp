@@ -1,5 +1,6 @@
 #include "GLWidget.h"
 
+#include <algorithm>
 #include <numeric>
 #include <ctime>
 
@@ -154,6 +155,32 @@ paintGL() {
   double frameRate = 1./(accumulate(m_frameTimes.begin(), m_frameTimes.end(), 0.) / m_frameTimes.size());
   if(m_showFrameRate)
     DrawFrameRate(frameRate);
+
+  UpdateLOD(frameRate);
+}
+
+void
+GLWidget::
+SetTargetFrameRate(double _f) {
+  m_targetFrameRate = _f;
+  if(m_targetFrameRate <= 0)
+    GetVizmo().SetLODPixelSize(0);
+}
+
+void
+GLWidget::
+UpdateLOD(double _frameRate) {
+  if(m_targetFrameRate <= 0)
+    return;
+
+  //Grow the clusters while too slow; shrink them back to full detail while
+  //comfortably fast.
+  double size = GetVizmo().GetLODPixelSize();
+  if(_frameRate < m_targetFrameRate)
+    size = min(max(size * 1.25, 2.), 64.);
+  else if(_frameRate > 1.5 * m_targetFrameRate)
+    size = size * .8 < 2 ? 0 : size * .8;
+  GetVizmo().SetLODPixelSize(size);
 }
 
 void
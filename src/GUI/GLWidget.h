@@ -40,6 +40,12 @@ class GLWidget : public QGLWidget {
 
     void SetRecording(bool _b) {m_recording = _b;}
 
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Set the frame rate that roadmap level-of-detail should maintain.
+    /// \param[in] _f The target in frames per second, or 0 for full detail.
+    void SetTargetFrameRate(double _f);
+    double GetTargetFrameRate() const {return m_targetFrameRate;}
+
     void SetClearColor(double _r, double _g, double _b) const {
       glClearColor(_r, _g, _b, 0);
     }
@@ -108,6 +114,10 @@ class GLWidget : public QGLWidget {
 
     void DrawAxis();
     void DrawFrameRate(double _frameRate);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Coarsen or refine the roadmap level-of-detail to move the frame
+    ///        rate toward the target.
+    void UpdateLOD(double _frameRate);
 
     bool m_takingSnapShot;
     bool m_showAxis, m_showFrameRate;
@@ -115,6 +125,7 @@ class GLWidget : public QGLWidget {
     bool m_recording;
 
     deque<double> m_frameTimes;
+    double m_targetFrameRate{0}; ///< Frame rate for roadmap LOD, 0 if off.
 
     Camera m_camera;
     TransformTool* m_transformTool;
@@ -5,6 +5,7 @@
 
 #include <QtGui>
 #include <QColorDialog>
+#include <QInputDialog>
 #include <QAction>
 #include <QMenu>
 
@@ -58,6 +59,8 @@ CreateActions() {
       tr("Axis"), this);
   m_actions["showFrameRate"] = new QAction(QPixmap(framerate),
       tr("Theoretical Frame Rate"), this);
+  m_actions["setTargetFrameRate"] = new QAction(QPixmap(framerate),
+      tr("Set Target Frame Rate"), this);
   m_actions["resetCamera"] = new QAction(QPixmap(resetcamera),
       tr("Reset Camera"), this);
   m_actions["setCameraPosition"] = new QAction(QPixmap(setcameraposition),
@@ -119,6 +122,8 @@ CreateActions() {
       this, SLOT(ResetCameraUp()));
   connect(m_actions["changeBGColor"], SIGNAL(triggered()),
       this, SLOT(ChangeBGColor()));
+  connect(m_actions["setTargetFrameRate"], SIGNAL(triggered()),
+      this, SLOT(SetTargetFrameRate()));
   connect(m_actions["makeSolid"], SIGNAL(triggered()), this, SLOT(MakeSolid()));
   connect(m_actions["makeWired"], SIGNAL(triggered()), this, SLOT(MakeWired()));
   connect(m_actions["makeInvisible"], SIGNAL(triggered()),
@@ -192,6 +197,11 @@ SetHelpTips() {
 
   m_actions["resetCameraUp"]->setWhatsThis(tr("Reset the camera up direction"));
 
+  m_actions["setTargetFrameRate"]->setStatusTip(tr("Set the target frame rate"));
+  m_actions["setTargetFrameRate"]->setWhatsThis(tr("Click this button to set"
+        " a frame rate to maintain. Large roadmaps are drawn with clustered"
+        " nodes and edges while the scene renders slower than this rate."));
+
   #ifdef USE_SPACEMOUSE
   m_actions["toggleCursor"]->setWhatsThis(tr("Enable/disable the 3d cursor."));
   #endif
@@ -212,6 +222,7 @@ SetUpSubmenu() {
   m_submenu->addAction(m_actions["showObjectNormals"]);
   m_submenu->addAction(m_actions["resetCamera"]);
   m_submenu->addAction(m_actions["changeBGColor"]);
+  m_submenu->addAction(m_actions["setTargetFrameRate"]);
 
   #ifdef USE_SPACEMOUSE
   m_submenu->addAction(m_actions["toggleCursor"]);
@@ -238,6 +249,7 @@ SetUpToolTab() {
   buttonList.push_back("_separator_");
   buttonList.push_back("showAxis");
   buttonList.push_back("showFrameRate");
+  buttonList.push_back("setTargetFrameRate");
   buttonList.push_back("showObjectNormals");
   #ifdef USE_SPACEMOUSE
   buttonList.push_back("_separator_");
@@ -336,11 +348,22 @@ ToggleCursor() {
 #endif
 /*---------------------------- Model Functions -------------------------------*/
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The roadmap is drawn from a snapshot holding each CC's color and
+///        render mode, so republish it after the selection changes them.
+static void
+RefreshRoadmapStyle() {
+  if(GetVizmo().GetMap())
+    GetVizmo().GetMap()->RefreshMap();
+}
+
+
 void
 GLWidgetOptions::
 MakeSolid() {
   for(auto& i : GetVizmo().GetSelectedModels())
     i->SetRenderMode(SOLID_MODE);
+  RefreshRoadmapStyle();
 }
 
 
@@ -349,6 +372,7 @@ GLWidgetOptions::
 MakeWired() {
   for(auto& i : GetVizmo().GetSelectedModels())
     i->SetRenderMode(WIRE_MODE);
+  RefreshRoadmapStyle();
 }
 
 
@@ -357,6 +381,7 @@ GLWidgetOptions::
 MakeInvisible() {
   for(auto& i : GetVizmo().GetSelectedModels())
     i->SetRenderMode(INVISIBLE_MODE);
+  RefreshRoadmapStyle();
 }
 
 
@@ -375,6 +400,7 @@ ChangeObjectColor() {
 
   for(auto& i : GetVizmo().GetSelectedModels())
     i->SetColor(Color4(r, g, b, 1));
+  RefreshRoadmapStyle();
 }
 
 
@@ -401,6 +427,19 @@ ChangeBGColor() {
 }
 
 
+void
+GLWidgetOptions::
+SetTargetFrameRate() {
+  GLWidget* glWidget = GetMainWindow()->GetGLWidget();
+  bool ok;
+  int fps = QInputDialog::getInt(this, tr("Target Frame Rate"),
+      tr("Frames per second (0 to always draw roadmaps in full):"),
+      glWidget->GetTargetFrameRate(), 0, 240, 1, &ok);
+  if(ok)
+    glWidget->SetTargetFrameRate(fps);
+}
+
+
 void
 GLWidgetOptions::
 ShowGeneralContextMenu() {
@@ -413,6 +452,7 @@ ShowGeneralContextMenu() {
     //show general display options when no models are selected
     cm.addAction(m_actions["showAxis"]);
     cm.addAction(m_actions["showFrameRate"]);
+    cm.addAction(m_actions["setTargetFrameRate"]);
     cm.addAction(m_actions["changeBGColor"]);
     cm.addSeparator();
     cm.addAction(m_actions["resetCamera"]);
@@ -42,6 +42,7 @@ class GLWidgetOptions : public OptionsBase {
 
     // other
     void ChangeBGColor();         ///< Change the background color.
+    void SetTargetFrameRate();    ///< Set the frame rate for roadmap LOD.
     void ShowGeneralContextMenu();///< Display the right-click menu.
 
   private:
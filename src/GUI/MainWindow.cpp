@@ -5,6 +5,7 @@
 #include <QGridLayout>
 #include <QMessageBox>
 #include <QMenuBar>
+#include <QThread>
 
 #include "AnimationWidget.h"
 #include "FileListDialog.h"
@@ -86,8 +87,16 @@ InitVizmo() {
 void
 MainWindow::
 closeEvent(QCloseEvent* _event) {
-  /// Executes clean-up prior to closing the application.
-  static_cast<PlanningOptions*>(m_mainMenu->m_planningOptions)->HaltMPThread();
+  /// Executes clean-up prior to closing the application. A running strategy
+  /// is canceled, and the window closes once its thread has finished.
+  PlanningOptions* planning =
+      static_cast<PlanningOptions*>(m_mainMenu->m_planningOptions);
+  if(!planning->HaltMPThread()) {
+    connect(planning->GetMPThread(), SIGNAL(finished()), this, SLOT(close()),
+        Qt::UniqueConnection);
+    _event->ignore();
+    return;
+  }
   GetVizmo().Clean();
   QMainWindow::closeEvent(_event);
 }
@@ -171,7 +171,8 @@ NodeEditDialog(MainWindow* _mainWindow, string _title)
   m_tempNode = new CfgModel();
   m_tempObjs.AddModel(m_tempNode);
 
-  //Set up dialog widget
+  //Set up dialog widget. Edges to the nearest nodes follow the new node as
+  //its DOFs change.
   Init();
 
   //Configure end behavior
@@ -303,6 +304,10 @@ UpdateDOF(int _id) {
   //Also assumes index alignment
   (*m_tempNode)[_id] = m_sliders[_id]->GetSlider()->value() / 100000.0;
 
+  //A new node connects to whichever roadmap nodes are nearest
+  if(!m_originalNode && m_nodesToDelete.empty())
+    ConnectNearest();
+
   ValidityCheck();
 
   if(m_tempNode->IsQuery()) {
@@ -352,6 +357,27 @@ ValidityCheck() {
 }
 
 
+void
+NodeEditDialog::
+ConnectNearest() {
+  Map* map = GetVizmo().GetMap();
+  if(!map)
+    return;
+
+  for(auto m : m_tempObjs.GetModels())
+    if(m->Name().substr(0, 4) == "Edge")
+      m_tempObjs.RemoveModel(m);
+
+  Graph* graph = map->GetGraph();
+  m_nodesToConnect = map->Nearest(m_tempNode->GetPoint(), m_numNeighbors);
+  for(const auto vid : m_nodesToConnect) {
+    EdgeModel* tempEdge = new EdgeModel();
+    tempEdge->Set(m_tempNode, &graph->find_vertex(vid)->property());
+    m_tempObjs.AddModel(tempEdge);
+  }
+}
+
+
 void
 NodeEditDialog::
 FinalizeNodeEdit(int _accepted) {
@@ -360,12 +386,15 @@ FinalizeNodeEdit(int _accepted) {
 
   if(_accepted == 1) {  //user pressed okay
     if(m_tempNode->IsValid()) {
-      //set data for original node to match temp
-      m_originalNode->SetCfg(m_tempNode->GetDataCfg());
+      //set data for original node to match temp, through the map when there
+      //is one so that Cfg2VID still finds it
+      if(map)
+        map->MoveVertex(m_originalNode->GetIndex(), m_tempNode->GetDataCfg());
+      else
+        m_originalNode->SetCfg(m_tempNode->GetDataCfg());
 
       //delete edges that are no longer valid
       if(map) {
-        Graph* graph = map->GetGraph();
         for(auto& m : m_tempObjs) {
           // Skip non-edges.
           if(m->Name().substr(0, 4) != "Edge")
@@ -375,8 +404,8 @@ FinalizeNodeEdit(int _accepted) {
           if(!edge->IsValid()) {
             VID start = map->Cfg2VID(*(edge->GetStartCfg()));
             VID end = map->Cfg2VID(*(edge->GetEndCfg()));
-            graph->delete_edge(start, end);
-            graph->delete_edge(end, start);
+            map->DeleteEdge(start, end);
+            map->DeleteEdge(end, start);
           }
         }
       }
@@ -401,12 +430,25 @@ NodeEditDialog::
 FinalizeNodeAdd(int _accepted) {
   Map* map = GetVizmo().GetMap();
   if(map) {
-    Graph* graph = map->GetGraph();
     if(_accepted == 1) {
       if(m_tempNode->IsValid()) {
         CfgModel newNode = *m_tempNode;
         newNode.SetRenderMode(SOLID_MODE);
-        graph->add_vertex(newNode);
+        VID newID = map->AddVertex(newNode);
+
+        //Add the valid edges to the nearest nodes
+        for(auto m : m_tempObjs) {
+          // Skip non-edges.
+          if(m->Name().substr(0, 4) != "Edge")
+            continue;
+          auto edge = static_cast<EdgeModel*>(m);
+
+          if(edge->IsValid()) {
+            VID endID = map->Cfg2VID(*edge->GetEndCfg());
+            map->AddEdge(newID, endID, EdgeModel());
+            map->AddEdge(endID, newID, EdgeModel());
+          }
+        }
         map->RefreshMap();
       }
       else
@@ -421,13 +463,12 @@ void
 NodeEditDialog::
 FinalizeNodeMerge(int _accepted) {
   Map* map = GetVizmo().GetMap();
-  Graph* graph = map->GetGraph();
 
   if(_accepted == 1) {
     if(m_tempNode->IsValid()) {
       CfgModel super = *m_tempNode;
       super.SetRenderMode(SOLID_MODE);
-      Map::VID superID = graph->add_vertex(super);
+      Map::VID superID = map->AddVertex(super);
 
       //Add the valid new edges
       for(auto m : m_tempObjs) {
@@ -437,14 +478,15 @@ FinalizeNodeMerge(int _accepted) {
         auto edge = static_cast<EdgeModel*>(m);
 
         if(edge->IsValid()) {
-          graph->add_edge(superID, map->Cfg2VID(*edge->GetEndCfg()));
-          graph->add_edge(map->Cfg2VID(*edge->GetEndCfg()), superID);
+          VID endID = map->Cfg2VID(*edge->GetEndCfg());
+          map->AddEdge(superID, endID, EdgeModel());
+          map->AddEdge(endID, superID, EdgeModel());
         }
       }
 
       //Remove selected vertices
       for(const auto vid : m_nodesToDelete)
-        graph->delete_vertex(vid);
+        map->DeleteVertex(vid);
 
       map->RefreshMap();
     }
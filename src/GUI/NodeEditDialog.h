@@ -88,6 +88,8 @@ class NodeEditDialog : public QDialog {
     NodeEditDialog(MainWindow* _mainWindow, string _title, CfgModel* _tempNode,
         vector<VID> _nodesToConnect, vector<VID> _nodesToDelte);
 
+    static const size_t m_numNeighbors = 5; ///< Nearest nodes to connect to.
+
   private slots:
 
     void UpdateDOF(int _id);  //Update value of DOF associated with m_sliders[_id]
@@ -104,6 +106,10 @@ class NodeEditDialog : public QDialog {
     void SetUpSliders(vector<NodeEditSlider*>& _sliders);
     void InitSliderValues(const vector<double>& _vals);
     void ValidityCheck();
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Replace the temporary edges with edges to the roadmap nodes
+    ///        nearest to the temporary node.
+    void ConnectNearest();
 
     vector<NodeEditSlider*> m_sliders; //destruction??
     string m_title;               ///< The node name.
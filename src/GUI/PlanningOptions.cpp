@@ -14,6 +14,7 @@
 #include "RegionSamplerDialog.h"
 
 #include "Models/EnvModel.h"
+#include "Models/PlanningService.h"
 #include "Models/RegionBoxModel.h"
 #include "Models/RegionBox2DModel.h"
 #include "Models/RegionModel.h"
@@ -49,7 +50,7 @@
 
 PlanningOptions::
 PlanningOptions(QWidget* _parent) : OptionsBase(_parent, "Planning"),
-  m_userInputStarted(false), m_thread(NULL) {
+  m_userInputStarted(false), m_thread(NULL), m_service(NULL) {
     CreateActions();
     SetHelpTips();
     SetUpSubmenu();
@@ -59,24 +60,27 @@ PlanningOptions(QWidget* _parent) : OptionsBase(_parent, "Planning"),
 
 PlanningOptions::
 ~PlanningOptions() {
-  HaltMPThread();
+  //The main window waits for the thread before closing, so this only joins a
+  //thread if the options are torn down some other way
+  if(m_thread) {
+    m_service->Cancel();
+    m_thread->wait();
+    ThreadDone();
+  }
 }
 
 
-void
+bool
 PlanningOptions::
 HaltMPThread() {
-  /// \bug Ideally we should close
-  /// the thread properly, but this is not possible under the current
-  /// organization as our thread 'event loop' only runs one time. The actual
-  /// loop is outsourced to Vizmo and then again to the corresponding strategy.
-  /// Fixing this properly requires that the worker have some way to interrupt
-  /// MPStrategy::Run() so that control will return to the worker object. Until
-  /// then, we will crash and burn whenever halting a thread prematurely.
-  if(m_thread) {
-    delete m_thread;
-    m_thread = NULL;
-  }
+  /// The strategy stops at its next planning checkpoint, and \ref ThreadDone
+  /// cleans up once the thread has finished. Strategies which never reach a
+  /// checkpoint run to completion first.
+  if(!m_thread)
+    return true;
+  if(m_service && !m_service->IsCanceled())
+    StopPlanning();
+  return false;
 }
 
 /*----------------------------- GUI Management -------------------------------*/
@@ -123,6 +127,8 @@ CreateActions() {
       tr("Print User Path"), this);
   m_actions["mapEnvironment"] = new QAction(QPixmap(mapenv),
       tr("Map Environment"), this);
+  m_actions["pausePlanning"] = new QAction(tr("Pause Planning"), this);
+  m_actions["stopPlanning"] = new QAction(tr("Stop Planning"), this);
 
   // 2. Set other specifications
   m_actions["addRegionSphere"]->setEnabled(false);
@@ -144,6 +150,8 @@ CreateActions() {
   m_actions["loadCfgs"]->setEnabled(false);
   m_actions["savePath"]->setEnabled(false);
   m_actions["loadPath"]->setEnabled(false);
+  m_actions["pausePlanning"]->setEnabled(false);
+  m_actions["stopPlanning"]->setEnabled(false);
 
   // 3. Make connections
   connect(m_actions["addRegionSphere"], SIGNAL(triggered()),
@@ -166,6 +174,10 @@ CreateActions() {
       this, SLOT(DuplicateRegion()));
   connect(m_actions["mapEnvironment"], SIGNAL(triggered()),
       this, SLOT(MapEnvironment()));
+  connect(m_actions["pausePlanning"], SIGNAL(triggered()),
+      this, SLOT(TogglePause()));
+  connect(m_actions["stopPlanning"], SIGNAL(triggered()),
+      this, SLOT(StopPlanning()));
   connect(m_actions["addUserPathMouse"], SIGNAL(triggered()),
       this, SLOT(AddUserPath()));
   connect(m_actions["addUserPathCamera"], SIGNAL(triggered()),
@@ -194,6 +206,10 @@ PlanningOptions::
 SetHelpTips() {
   m_actions["mapEnvironment"]->setWhatsThis(
       tr("Map an environment using selected Strategy"));
+  m_actions["pausePlanning"]->setWhatsThis(
+      tr("Pause or resume the running Strategy"));
+  m_actions["stopPlanning"]->setWhatsThis(
+      tr("Stop the running Strategy and keep its roadmap"));
   m_actions["addRegionSphere"]->setWhatsThis(
       tr("Add a spherical region to aid planner"));
   m_actions["addRegionBox"]->setWhatsThis(
@@ -245,6 +261,8 @@ SetUpSubmenu() {
   m_submenu->addAction(m_actions["loadRegion"]);
   m_submenu->addAction(m_actions["deleteRegion"]);
   m_submenu->addAction(m_actions["mapEnvironment"]);
+  m_submenu->addAction(m_actions["pausePlanning"]);
+  m_submenu->addAction(m_actions["stopPlanning"]);
 
   m_pathsMenu = new QMenu("User Paths", this);
   m_pathsMenu->addAction(m_actions["addUserPathMouse"]);
@@ -293,6 +311,8 @@ SetUpToolTab() {
   buttonList.push_back("_separator_");
 
   buttonList.push_back("mapEnvironment");
+  buttonList.push_back("pausePlanning");
+  buttonList.push_back("stopPlanning");
 
   CreateToolTab(buttonList);
 }
@@ -753,9 +773,19 @@ PlanningOptions::
 ThreadDone() {
   /// Should be connected to the finish signal of \ref m_thread before executing
   /// a mapping strategy.
+  if(!m_thread)
+    return;
+  GetVizmo().SetPlanningService(NULL);
+  delete m_service;
+  m_service = NULL;
+  m_thread->deleteLater();
   m_thread = NULL;
   m_userInputStarted = false;
 
+  m_actions["pausePlanning"]->setText(tr("Pause Planning"));
+  m_actions["pausePlanning"]->setEnabled(false);
+  m_actions["stopPlanning"]->setEnabled(false);
+
   // Refresh scene + GUI
   GetMainWindow()->GetModelSelectionWidget()->ResetLists();
   GetMainWindow()->m_mainMenu->CallReset();
@@ -790,30 +820,80 @@ MapEnvironment() {
     GetVizmo().SetPMPLMap();
     GetMainWindow()->m_mainMenu->CallReset();
 
-    //Set up thread for execution
+    //Set up thread for execution. The service is deleted by ThreadDone once
+    //the thread has finished.
     m_thread = new QThread;
-    MapEnvironmentWorker* mpsw = new MapEnvironmentWorker(slabel);
-    mpsw->moveToThread(m_thread);
-    connect(m_thread, SIGNAL(started()), mpsw, SLOT(Solve()));
-    connect(m_thread, SIGNAL(finished()), mpsw, SLOT(deleteLater()));
+    m_service = new PlanningService(slabel);
+    m_service->moveToThread(m_thread);
+    GetVizmo().SetPlanningService(m_service);
+    connect(m_thread, SIGNAL(started()), m_service, SLOT(Run()));
     connect(m_thread, SIGNAL(finished()), this, SLOT(ThreadDone()));
-    connect(mpsw, SIGNAL(Finished()), mpsw, SLOT(deleteLater()));
-    connect(mpsw, SIGNAL(destroyed()), m_thread, SLOT(quit()));
+    connect(m_service, SIGNAL(Finished(bool)), m_thread, SLOT(quit()));
+    connect(m_service, SIGNAL(Progress()), this, SLOT(PlanningProgress()));
+    connect(m_service, SIGNAL(Checkpointed()),
+        this, SLOT(PlanningCheckpointed()));
+
+    //Pause and Stop only work at checkpoints, so they wait for the first one
+    m_actions["pausePlanning"]->setEnabled(false);
+    m_actions["stopPlanning"]->setEnabled(false);
     m_thread->start();
   }
 }
 
-/*----------------------------MapEnvironmentWorker----------------------------*/
 
-MapEnvironmentWorker::
-MapEnvironmentWorker(string _strategyLabel)
-  : QObject(), m_strategyLabel(_strategyLabel) {
+void
+PlanningOptions::
+TogglePause() {
+  if(!m_service)
+    return;
+
+  if(m_service->IsPaused()) {
+    m_service->Resume();
+    m_actions["pausePlanning"]->setText(tr("Pause Planning"));
+  }
+  else {
+    m_service->Pause();
+    m_actions["pausePlanning"]->setText(tr("Resume Planning"));
   }
+}
+
+
+void
+PlanningOptions::
+StopPlanning() {
+  /// The thread finishes on its own and \ref ThreadDone cleans up after it.
+  if(!m_service)
+    return;
+  m_service->Cancel();
+  m_actions["pausePlanning"]->setEnabled(false);
+  m_actions["stopPlanning"]->setEnabled(false);
+  GetMainWindow()->statusBar()->showMessage("Stopping planner...");
+}
+
 
 void
-MapEnvironmentWorker::
-Solve() {
-  GetVizmo().Solve(m_strategyLabel);
-  emit Finished();
+PlanningOptions::
+PlanningCheckpointed() {
+  if(!m_service || m_service->IsCanceled())
+    return;
+  m_actions["pausePlanning"]->setEnabled(true);
+  m_actions["stopPlanning"]->setEnabled(true);
+}
+
+
+void
+PlanningOptions::
+PlanningProgress() {
+  if(!m_service || m_service->IsCanceled())
+    return;
+
+  PlanningService::Stats s = m_service->GetStats();
+  ostringstream oss;
+  oss << (m_service->IsPaused() ? "Paused: " : "Planning: ")
+      << s.m_vertices << " nodes (" << int(s.m_verticesPerSecond) << "/s), "
+      << s.m_edges << " edges (" << int(s.m_edgesPerSecond) << "/s), "
+      << s.m_ccs << " CCs (" << showpos << int(s.m_ccsPerSecond) << noshowpos
+      << "/s), " << s.m_iterations << " iterations";
+  GetMainWindow()->statusBar()->showMessage(oss.str().c_str());
 }
 
@@ -4,6 +4,8 @@
 #include "OptionsBase.h"
 #include "Models/EnvModel.h"
 
+class PlanningService;
+
 ////////////////////////////////////////////////////////////////////////////////
 /// \brief This class provides access to the user-guided planning tools.
 ////////////////////////////////////////////////////////////////////////////////
@@ -20,7 +22,11 @@ class PlanningOptions : public OptionsBase {
 
     //planning thread access
     QThread* GetMPThread() {return m_thread ? m_thread : NULL;}
-    void HaltMPThread(); ///< Deletes the current mapping thread if one exists.
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Cancel the current mapping thread without waiting for it.
+    /// \return True if no thread is running. Otherwise the thread's finished
+    ///         signal tells when it is done.
+    bool HaltMPThread();
 
     void StartPreInputTimer();
 
@@ -57,6 +63,10 @@ class PlanningOptions : public OptionsBase {
     //Common planning functions
     void MapEnvironment();    ///< Start a mapping thread to run an MPStrategy.
     void ThreadDone();        ///< Clean-up after mapping thread finishes.
+    void TogglePause();       ///< Pause or resume the running strategy.
+    void StopPlanning();      ///< Cancel the running strategy.
+    void PlanningProgress();  ///< Show the planner's counters.
+    void PlanningCheckpointed(); ///< Enable Pause and Stop.
 
   private:
 
@@ -79,35 +89,10 @@ class PlanningOptions : public OptionsBase {
 
     bool m_userInputStarted;       ///< Tracks whether user input timer is running.
     QThread* m_thread;             ///< Points to the current mapping thread.
+    PlanningService* m_service;    ///< Runs the strategy on \ref m_thread.
     QMenu* m_addRegionMenu;        ///< Menu for adding new regions.
     QMenu* m_regionPropertiesMenu; ///< Menu for modifying regions.
     QMenu* m_pathsMenu;            ///< Menu for working with user paths.
 };
 
-
-////////////////////////////////////////////////////////////////////////////////
-/// \brief This class launches interactive strategies.
-////////////////////////////////////////////////////////////////////////////////
-class MapEnvironmentWorker : public QObject {
-
-  Q_OBJECT
-
-  public:
-
-    MapEnvironmentWorker(string _strategyLabel);
-
-  public slots:
-
-    void Solve();           ///< Executes the desired strategy.
-
-  signals:
-
-    void Finished();        ///< Indicates that the strategy has halted.
-
-  private:
-
-    string m_strategyLabel; ///< The label of the strategy to execute.
-
-};
-
 #endif
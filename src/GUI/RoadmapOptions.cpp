@@ -1,5 +1,7 @@
 #include "RoadmapOptions.h"
 
+#include <set>
+
 #include <QtGui>
 #include <QAction>
 #include <QMenu>
@@ -347,7 +349,6 @@ AddStraightLineEdge() {
   vector<Model*>& sel = GetVizmo().GetSelectedModels();
   vector<CfgModel*> selNodes;
   Map* map = GetVizmo().GetMap();
-  Graph* graph = map->GetGraph();
 
   //Filter away selected edges, but still enforce two nodes
   for(MIT it = sel.begin(); it != sel.end(); it++)
@@ -364,16 +365,9 @@ AddStraightLineEdge() {
   if(visibility.first) {
     VID v0 = selNodes[0]->GetIndex();
     VID v1 = selNodes[1]->GetIndex();
-    graph->add_edge(v0, v1);
-    graph->add_edge(v1, v0);
-
-    //Set edge weights in underlying graph
-    VI viTemp, viTemp2;
-    EI eiTemp, eiTemp2;
-    graph->find_edge(EID(v0, v1), viTemp, eiTemp);
-    graph->find_edge(EID(v1, v0), viTemp2, eiTemp2);
-    (*eiTemp).property().SetWeight(visibility.second);
-    (*eiTemp2).property().SetWeight(visibility.second);
+    EdgeModel edge("", visibility.second);
+    map->AddEdge(v0, v1, edge);
+    map->AddEdge(v1, v0, edge);
 
     map->RefreshMap();
     GetMainWindow()->GetModelSelectionWidget()->ResetLists();
@@ -390,7 +384,6 @@ RoadmapOptions::
 DeleteSelectedItems() {
   vector<Model*>& sel = GetVizmo().GetSelectedModels();
   Map* map = GetVizmo().GetMap();
-  Graph* graph = map->GetGraph();
 
   bool selectionValid = false;
   vector<VID> nodesToDelete;
@@ -418,12 +411,12 @@ DeleteSelectedItems() {
     //Remove selected vertices
     typedef vector<VID>::iterator VIT;
     for(VIT it = nodesToDelete.begin(); it != nodesToDelete.end(); it++)
-      graph->delete_vertex(*it);
+      map->DeleteVertex(*it);
     //Remove selected edges
     typedef vector<pair<VID, VID> >::iterator EIT;
     for(EIT it = edgesToDelete.begin(); it != edgesToDelete.end(); it++) {
-      graph->delete_edge(it->first, it->second);
-      graph->delete_edge(it->second, it->first);
+      map->DeleteEdge(it->first, it->second);
+      map->DeleteEdge(it->second, it->first);
     }
     map->RefreshMap();
     GetMainWindow()->GetModelSelectionWidget()->ResetLists();
@@ -465,20 +458,27 @@ MergeSelectedNodes() {
   vector<VID> toDelete;
   vector<VID> toConnect;
   typedef vector<CfgModel*>::iterator NIT;
+  for(NIT it = selNodes.begin(); it != selNodes.end(); it++)
+    toDelete.push_back((*it)->GetIndex());
+
+  //Connect the supervertex to the neighbors of the merged nodes
+  std::set<VID> superTargets(toDelete.begin(), toDelete.end());
   for(NIT it = selNodes.begin(); it != selNodes.end(); it++) {
-    VID selectedID = (*it)->GetIndex();
-    toDelete.push_back(selectedID);
-    VI vi = graph->find_vertex(selectedID);
-    std::map<VID, bool> superTargets;
+    VI vi = graph->find_vertex((*it)->GetIndex());
     for(EI ei = vi->begin(); ei != vi->end(); ++ei) {
       VID targetVID = (*ei).target();
-      if(superTargets.count(targetVID) == 0) {
-        superTargets[targetVID] = true;
+      if(superTargets.insert(targetVID).second)
         toConnect.push_back(targetVID);
-      }
     }
   }
 
+  //If the merged nodes had no other neighbors, try the nearest nodes instead
+  if(toConnect.empty())
+    for(auto& vid : map->Nearest(superPreview->GetPoint(),
+          numSelected + NodeEditDialog::m_numNeighbors))
+      if(superTargets.insert(vid).second && toConnect.size() < NodeEditDialog::m_numNeighbors)
+        toConnect.push_back(vid);
+
   NodeEditDialog* ned = new NodeEditDialog(GetMainWindow(), "New Supervertex",
       superPreview, toConnect, toDelete);
   GetMainWindow()->ShowDialog(ned);
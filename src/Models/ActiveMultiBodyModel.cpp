@@ -1,5 +1,7 @@
 #include "ActiveMultiBodyModel.h"
 
+#include "Environment/Connection.h"
+
 #include "BodyModel.h"
 #include "BoundaryModel.h"
 #include "EnvModel.h"
@@ -50,12 +52,47 @@ ConfigureRender(const vector<double>& _cfg) {
         m_activeMultiBody->GetFreeBody(i)->RenderTransformation());
 }
 
+void
+ActiveMultiBodyModel::
+GetRenderTransforms(vector<GLfloat>& _buffer) const {
+  size_t offset = _buffer.size();
+  _buffer.resize(offset + 16 * m_bodies.size());
+  for(size_t i = 0; i < m_bodies.size(); ++i)
+    m_bodies[i]->GetTransformMatrix(&_buffer[offset + 16 * i]);
+}
+
 bool
 ActiveMultiBodyModel::
 InCSpace(const vector<double>& _cfg) {
   return m_activeMultiBody->InCSpace(_cfg, GetVizmo().GetEnv()->GetBoundary()->GetBoundary());
 }
 
+double
+ActiveMultiBodyModel::
+GetReach() const {
+  if(m_activeMultiBody->GetBaseType() == FreeBody::BodyType::Fixed)
+    return -1;
+
+  //Each joint moves the next body frame by at most its fixed offsets, and
+  //each mesh lies within its radius of the mesh center, which sits at the
+  //COM adjustment offset from its body frame
+  double joints = 0, extent = 0;
+  for(size_t i = 0; i < m_bodies.size(); ++i) {
+    PolyhedronModel* mesh = m_bodies[i]->GetPolyhedronModel();
+    extent = max(extent, mesh->GetCenter().norm() + mesh->GetRadius());
+
+    shared_ptr<FreeBody> body = m_activeMultiBody->GetFreeBody(i);
+    for(size_t j = 0; j < body->ForwardConnectionCount(); ++j) {
+      const Connection& c = body->GetForwardConnection(j);
+      const DHParameters& dh = c.GetDHParameters();
+      joints += c.GetTransformationToDHFrame().translation().norm() +
+          sqrt(dh.m_a * dh.m_a + dh.m_d * dh.m_d) +
+          c.GetTransformationToBody2().translation().norm();
+    }
+  }
+  return joints + extent;
+}
+
 void
 ActiveMultiBodyModel::
 RestoreColor() {
@@ -86,6 +123,27 @@ Build() {
   }
 }
 
+void
+ActiveMultiBodyModel::
+DrawRenderInstances(const vector<GLfloat>& _transforms) {
+  if(m_bodies.empty())
+    return;
+
+  DrawRenderInstances(_transforms.data(),
+      _transforms.size() / (16 * m_bodies.size()));
+}
+
+void
+ActiveMultiBodyModel::
+DrawRenderInstances(const GLfloat* _transforms, size_t _count,
+    const Color4* _colors) {
+  //Matrices are grouped by cfg, so each body strides over the whole group.
+  size_t stride = 16 * m_bodies.size();
+  for(size_t i = 0; i < m_bodies.size(); ++i)
+    m_bodies[i]->DrawRenderInstances(_transforms + 16 * i, _count, stride,
+        _colors);
+}
+
 void
 ActiveMultiBodyModel::
 DrawSelected() {
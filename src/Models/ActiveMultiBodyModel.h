@@ -18,13 +18,38 @@ class ActiveMultiBodyModel : public MultiBodyModel {
 
     void BackUp();
     void ConfigureRender(const vector<double>& _cfg);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Append the current transform of each body to a buffer, as one
+    ///        column-major GL matrix per body.
+    void GetRenderTransforms(vector<GLfloat>& _buffer) const;
     bool InCSpace(const vector<double>& _cfg);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Bound how far any part of the robot reaches from the base
+    ///        position of its configuration, over all joint angles.
+    /// \return The bound, or a negative value if there is none, e.g. for a
+    ///         fixed base, whose position is not part of the configuration.
+    double GetReach() const;
     void RestoreColor();
     void Restore();
 
     void Print(ostream& _os) const;
 
     virtual void Build();
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Draw the robot at many configurations in one pass per body.
+    /// \param[in] _transforms Body transforms for each configuration, laid
+    ///                        out as by GetRenderTransforms.
+    void DrawRenderInstances(const vector<GLfloat>& _transforms);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Draw the robot at a number of configurations in one pass per
+    ///        body.
+    /// \param[in] _transforms Body transforms for each configuration, laid
+    ///                        out as by GetRenderTransforms.
+    /// \param[in] _count The number of configurations.
+    /// \param[in] _colors A color for each configuration, or null to use the
+    ///                    body colors.
+    void DrawRenderInstances(const GLfloat* _transforms, size_t _count,
+        const Color4* _colors = nullptr);
     virtual void DrawSelected();
     void DrawSelectedImpl();
 
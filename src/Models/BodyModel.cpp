@@ -10,17 +10,23 @@
 #include "MPProblem/MPProblemBase.h"
 
 #include "Models/PolyhedronModel.h"
+#include "Models/Vizmo.h"
 #include "Utilities/LoadTexture.h"
 
 BodyModel::
 BodyModel(shared_ptr<Body> _b) : TransformableModel("Body"), m_body(_b),
-  m_polyhedronModel(new PolyhedronModel(
-        (Body::m_modelDataDir == "/" || _b->GetFileName()[0] == '/' ?
-         "" : Body::m_modelDataDir) + _b->GetFileName(), _b->GetCOMAdjust())),
+  m_polyhedronModel(new PolyhedronModel(MeshPath(_b), _b->GetCOMAdjust())),
   m_textureID(-1) {
     SetTransform(_b->GetWorldTransformation());
   }
 
+string
+BodyModel::
+MeshPath(const shared_ptr<Body>& _b) {
+  return (Body::m_modelDataDir == "/" || _b->GetFileName()[0] == '/' ?
+      "" : Body::m_modelDataDir) + _b->GetFileName();
+}
+
 BodyModel::
 ~BodyModel() {
   delete m_polyhedronModel;
@@ -70,6 +76,27 @@ Select(GLuint* _index, vector<Model*>& sel) {
 void
 BodyModel::
 DrawRender() {
+  //Skip bodies outside of the view and draw those too small to see as points.
+  if(const Frustum* frustum = GetVizmo().GetFrustum()) {
+    Point3d center = m_currentTransform * m_polyhedronModel->GetCenter();
+    double radius = GetRadius();
+    if(frustum->IsOutside(center, radius))
+      return;
+    if(frustum->IsSmall(center, radius)) {
+      if(m_renderMode != INVISIBLE_MODE) {
+        glPushAttrib(GL_LIGHTING_BIT | GL_POINT_BIT | GL_CURRENT_BIT);
+        glDisable(GL_LIGHTING);
+        glColor4fv(GetColor());
+        glPointSize(1);
+        glBegin(GL_POINTS);
+        glVertex3dv(center);
+        glEnd();
+        glPopAttrib();
+      }
+      return;
+    }
+  }
+
   glPushMatrix();
 
   Transform();
@@ -85,7 +112,7 @@ DrawRender() {
 
   m_polyhedronModel->DrawRender();
 
-  if(m_body->IsTextureLoaded())
+  if(m_textureID != GLuint(-1))
     glDisable(GL_TEXTURE_2D);
 
   m_polyhedronModel->DrawNormals();
@@ -93,6 +120,39 @@ DrawRender() {
   glPopMatrix();
 }
 
+void
+BodyModel::
+DrawRenderInstances(const GLfloat* _transforms, size_t _count, size_t _stride,
+    const Color4* _colors) {
+  glColor4fv(GetColor());
+  if(m_textureID != GLuint(-1)) {
+    glEnable(GL_TEXTURE_2D);
+    glTexEnvf(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+    glBindTexture(GL_TEXTURE_2D, m_textureID);
+  }
+
+  for(size_t i = 0; i < _count; ++i) {
+    if(_colors)
+      glColor4fv(_colors[i]);
+    glPushMatrix();
+    glMultMatrixf(_transforms + i * _stride);
+    m_polyhedronModel->DrawRender();
+    glPopMatrix();
+  }
+
+  if(m_textureID != GLuint(-1))
+    glDisable(GL_TEXTURE_2D);
+
+  //normals are drawn in a second pass, since they change the current color
+  if(m_showNormals)
+    for(size_t i = 0; i < _count; ++i) {
+      glPushMatrix();
+      glMultMatrixf(_transforms + i * _stride);
+      m_polyhedronModel->DrawNormals();
+      glPopMatrix();
+    }
+}
+
 void
 BodyModel::
 DrawSelect() {
@@ -147,6 +207,20 @@ SetTransform(const Transformation& _t) {
   RotationQ() = qua;
 }
 
+void
+BodyModel::
+GetTransformMatrix(GLfloat* _m) const {
+  const Vector3d& p = m_currentTransform.translation();
+  const auto& r = m_currentTransform.rotation().matrix();
+  for(size_t i = 0; i < 3; ++i) {
+    for(size_t j = 0; j < 3; ++j)
+      _m[4*j + i] = r[i][j];
+    _m[4*i + 3] = 0;
+    _m[12 + i] = p[i];
+  }
+  _m[15] = 1;
+}
+
 void
 BodyModel::
 Build() {
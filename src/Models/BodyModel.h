@@ -31,6 +31,9 @@ class BodyModel : public TransformableModel {
 
     // File information
     ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the path of the mesh file for a PMPL body.
+    static string MeshPath(const shared_ptr<Body>& _b);
+    ////////////////////////////////////////////////////////////////////////////
     /// \brief Get the directory of this object's input file.
     const string& GetDirectory() {return m_directory;}
     ////////////////////////////////////////////////////////////////////////////
@@ -58,11 +61,25 @@ class BodyModel : public TransformableModel {
     ////////////////////////////////////////////////////////////////////////////
     /// \brief Set the current transformation for this object.
     void SetTransform(const Transformation& _t);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the current transformation as a column-major GL matrix.
+    /// \param[out] _m Storage for the 16 matrix entries.
+    void GetTransformMatrix(GLfloat* _m) const;
 
     // Model functions
     void Build();
     void Select(GLuint* _index, vector<Model*>& sel);
     void DrawRender();
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Draw this body once for each of a set of transforms, setting up
+    ///        the color and texture state only once.
+    /// \param[in] _transforms The first column-major GL matrix.
+    /// \param[in] _count The number of matrices.
+    /// \param[in] _stride The distance between consecutive matrices.
+    /// \param[in] _colors A color for each matrix, or null to use this body's
+    ///                    color.
+    void DrawRenderInstances(const GLfloat* _transforms, size_t _count,
+        size_t _stride, const Color4* _colors = nullptr);
     void DrawSelect();
     void DrawSelected();
     void DrawHaptics();
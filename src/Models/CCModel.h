@@ -1,9 +1,14 @@
 #ifndef CC_MODEL_H_
 #define CC_MODEL_H_
 
+#include <cmath>
+#include <cstdint>
 #include <iostream>
 #include <map>
+#include <memory>
+#include <set>
 #include <sstream>
+#include <unordered_map>
 #include <vector>
 using namespace std;
 
@@ -11,6 +16,7 @@ using namespace std;
 
 #include "Model.h"
 #include "MapModel.h"
+#include "Vizmo.h"
 
 template<typename, typename>
 class MapModel;
@@ -33,17 +39,170 @@ class CCModel : public Model {
     typedef typename MM::EI EI;
     typedef typename MM::ColorMap ColorMap;
 
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief A coarse version of part of this CC, with the nodes in each grid
+    ///        cell merged into one point and the edges between two cells
+    ///        bundled into one line.
+    ////////////////////////////////////////////////////////////////////////////
+    struct LODLevel {
+      double m_cellSize;         ///< Grid cell size.
+      vector<GLfloat> m_points;  ///< Cluster centroids.
+      vector<GLfloat> m_lines;   ///< Edge bundles between centroids.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief One cell of a coarse grid over a CC: its nodes, the edges which
+    ///        start in it, and its LOD levels, coarsest first. Each tile
+    ///        chooses its own level, so the near part of a CC keeps its detail
+    ///        while the far part is clustered.
+    ////////////////////////////////////////////////////////////////////////////
+    struct LODTile {
+      Point3d m_min, m_max;      ///< Bounding box of both arrays.
+      vector<GLfloat> m_nodes;   ///< Node positions.
+      vector<GLfloat> m_edges;   ///< Edge line segment endpoints.
+      vector<LODLevel> m_levels; ///< The levels.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief The LOD tiles of a CC and how much of its arrays they cover.
+    ///        Nodes and edges are only appended, so anything past the covered
+    ///        counts was added since and is drawn in full.
+    ////////////////////////////////////////////////////////////////////////////
+    struct LODSet {
+      vector<LODTile> m_tiles;   ///< The non-empty tiles.
+      size_t m_nodes{0};         ///< Number of nodes covered.
+      size_t m_edgePoints{0};    ///< Number of edge array points covered.
+      size_t m_generation{0};    ///< CC generation of the nodes covered.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief A stretch of a CC's vertex arrays which is never changed once
+    ///        published.
+    /// \details Robot mode needs each node's DOFs to pose the robot. The
+    ///          poses are computed by the renderer on first draw, since they
+    ///          configure the environment's robot models, and only the
+    ///          renderer touches the mutable members.
+    ////////////////////////////////////////////////////////////////////////////
+    struct Chunk {
+      vector<GLfloat> m_nodes;   ///< Node positions.
+      vector<GLfloat> m_edges;   ///< Edge line segment endpoints.
+      vector<GLuint> m_edgeStarts; ///< First m_edges point of each edge.
+      vector<double> m_dofs;     ///< Node DOFs, back to back.
+      vector<char> m_valid;      ///< Node validity.
+
+      mutable bool m_posed{false};              ///< Are the poses computed?
+      mutable vector<GLfloat> m_robotTransforms; ///< Valid node poses.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief An immutable copy of the vertex arrays and LOD levels of a CC,
+    ///        which the renderer can draw while the CC itself is updated.
+    /// \details The arrays are split into chunks which successive copies
+    ///          share. Appends land in a new chunk, and equal-sized chunks at
+    ///          the end are merged, so a CC of n nodes has O(log n) chunks and
+    ///          each position is copied O(log n) times over the CC's life.
+    ////////////////////////////////////////////////////////////////////////////
+    struct Geometry {
+      Point3d m_min, m_max;           ///< Bounding box of both arrays.
+      vector<shared_ptr<const Chunk>> m_chunks; ///< The arrays, in order.
+      shared_ptr<const LODSet> m_lods; ///< The LOD levels, or null until built.
+      CFG m_rep;                      ///< A node, for the robot to draw.
+      size_t m_generation{0};         ///< CC generation of the arrays.
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Draw the nodes and edges. In point mode the nodes are culled
+      ///        against the view and clustered when the view calls for it; in
+      ///        robot mode each node is drawn as the robot.
+      void Draw(const Color4& _color, RenderMode _mode) const;
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Choose the coarsest level of a tile whose cells appear no
+      ///        larger than the given size on screen.
+      /// \return The level to draw, or null to draw the tile in full.
+      static const LODLevel* SelectLOD(const LODTile& _tile,
+          const Frustum& _frustum, double _pixels);
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Split the CC into tiles and build the LOD levels of each, from
+      ///        coarsest to finest, stopping once clustering no longer
+      ///        removes most of the tile's nodes. This reads only the chunks,
+      ///        so it may run without the map mutex.
+      shared_ptr<const LODSet> BuildLODs() const;
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Draw a point array and a line array from the given points on.
+      static void DrawArrays(const vector<GLfloat>& _points,
+          const vector<GLfloat>& _lines, size_t _firstPoint = 0,
+          size_t _firstLine = 0);
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Draw each node as the robot.
+      void DrawRobots(const Color4& _color, RenderMode _mode) const;
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Get the grid cell containing a point from a vertex array.
+      uint64_t CellKey(const GLfloat* _p, double _cellSize) const;
+    };
+
     // Construction
     CCModel(size_t _id, VID _rep, Graph* _graph);
+    CCModel(size_t _id, const vector<VID>& _nodes, Graph* _graph);
 
     void SetName();                     ///< Set the name of this CC.
     size_t GetID() const {return m_id;} ///< Get the ID of this CC.
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Change the ID of this CC, e.g. after other CCs were removed.
+    void SetID(size_t _id) {m_id = _id; SetName();}
+    VID GetRep() const {return m_rep;}  ///< Get the reference node of this CC.
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the VIDs of the nodes in this CC.
+    const vector<VID>& GetNodes() const {return m_nodes;}
+
+    // Incremental updates
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Absorb all nodes and edges of another CC into this one. Edges
+    ///        leading to nodes outside both CCs must be passed to Extend.
+    /// \param[in] _cc The CC to absorb. It is left unchanged and should be
+    ///                deleted by the caller.
+    void Merge(const CCModel& _cc);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Add new nodes and edges to this CC without rebuilding it.
+    /// \param[in] _nodes The new nodes.
+    /// \param[in] _edges The new edges, as (source, target) pairs which are
+    ///                   not skipped by SkipEdge.
+    void Extend(const vector<VID>& _nodes, const vector<pair<VID, VID>>& _edges);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Reset the CC and edge pointers of every member after the graph
+    ///        storage has moved. The vertex arrays are unaffected.
+    void Relink();
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the geometry of this CC as of now. A new copy is made only if
+    ///        the CC changed since the last call. Its LOD levels are null if
+    ///        they must be built again.
+    shared_ptr<const Geometry> GetGeometry();
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Keep LOD levels built from a geometry of this CC for the next
+    ///        GetGeometry. This may be called without the map mutex.
+    void SetLODs(const shared_ptr<const LODSet>& _lods) {
+      atomic_store(&m_lods, _lods);
+    }
+
+    /// Check if we should skip an edge when drawing.
+    /// @param _graph The graph holding the edge.
+    /// @param _source The edge source.
+    /// @param _target The edge target.
+    /// @return True if this edge should be skipped because it appears twice
+    ///         as a bi-directional edge.
+    static bool SkipEdge(Graph* _graph, VID _source, VID _target);
 
     // Model functions
     void Build();
     void Select(GLuint* _index, vector<Model*>& _sel);
     void DrawRender();
-    void DrawSelect();
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Nothing is drawn for picking: MapModel answers picks from its
+    ///        spatial index.
+    void DrawSelect() {}
     void DrawSelected();
     void Print(ostream& _os) const;
     void SetColor(const Color4& _c);
@@ -57,13 +216,54 @@ class CCModel : public Model {
     ///         as a bi-directional edge.
     bool SkipEdge(EI _edgeIter) const;
 
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Set up the members and vertex arrays from m_nodes.
+    void Initialize();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Attach a node to this CC and append its position to the vertex
+    ///        array.
+    void AddNode(VID _v);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Attach an edge to this CC and append its line segments, including
+    ///        any intermediates, to the edge vertex array.
+    void AddEdge(VI _v, EI _ei);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Set the ID, color, and endpoint pointers of an edge.
+    void LinkEdge(VI _v, EI _ei);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Append a point to a vertex array and grow the bounds to fit it.
+    void PushPoint(vector<GLfloat>& _buffer, const Point3d& _p);
+
     CFG& GetCfg(VID _v);
+    WEIGHT& GetEdge(const pair<VID, VID>& _e);
 
     size_t m_id;         ///< The ID of this CC.
     VID m_rep;           ///< The ID of a reference node in this CC.
     Graph* m_graph;      ///< Pointer to the graph.
     ColorMap m_colorMap; ///< Auxiliary structure for stapl graph.
     vector<VID> m_nodes; ///< A list of the VIDs in this CC.
+    size_t m_numEdges{0};///< The number of drawn edges in this CC.
+
+    vector<GLfloat> m_nodeBuffer; ///< Node positions, in m_nodes order.
+    vector<double> m_dofBuffer;   ///< Node DOFs, in m_nodes order.
+    vector<char> m_validBuffer;   ///< Node validity, in m_nodes order.
+    vector<GLfloat> m_edgeBuffer; ///< Edge line segment endpoints.
+    Point3d m_min, m_max;         ///< Bounding box of both arrays.
+    vector<GLuint> m_edgeStarts;  ///< First edge buffer point of each edge.
+    vector<pair<VID, VID>> m_edges; ///< Drawn edges, in m_edgeStarts order.
+
+    shared_ptr<const Geometry> m_geometry; ///< The last copy made.
+    bool m_geometryChanged{true}; ///< Do the arrays differ from m_geometry?
+    size_t m_sharedNodes{0};      ///< Node array floats in m_geometry.
+    size_t m_sharedEdges{0};      ///< Edge array floats in m_geometry.
+    size_t m_sharedEdgeStarts{0}; ///< Edge starts in m_geometry.
+    size_t m_sharedDofs{0};       ///< DOF array values in m_geometry.
+    shared_ptr<const LODSet> m_lods; ///< Use atomic_load/store.
+    size_t m_generation{0};       ///< Count of Initialize calls.
 
     static map<VID, Color4> m_colorIndex; ///< Cfg colors by VID.
 };
@@ -86,6 +286,17 @@ CCModel(size_t _id, VID _rep, Graph* _graph) : Model(""), m_id(_id), m_rep(_rep)
 }
 
 
+template <class CFG, class WEIGHT>
+CCModel<CFG, WEIGHT>::
+CCModel(size_t _id, const vector<VID>& _nodes, Graph* _graph) : Model(""),
+    m_id(_id), m_rep(_nodes.front()), m_graph(_graph), m_nodes(_nodes) {
+  SetName();
+  m_renderMode = INVISIBLE_MODE;
+
+  Initialize();
+}
+
+
 template <class CFG, class WEIGHT>
 void
 CCModel<CFG, WEIGHT>::
@@ -95,48 +306,65 @@ Build() {
   m_colorMap.reset();
   get_cc(*m_graph, m_colorMap, m_rep, m_nodes);
 
-  typedef typename vector<VID>::iterator VIT;
-  for(VIT vit = m_nodes.begin(); vit != m_nodes.end(); ++vit)
-    GetCfg(*vit).Set(*vit, this);
+  Initialize();
+}
 
-  //Set up edges
-  int edgeIdx = 0;
-  for(VIT vit = m_nodes.begin(); vit != m_nodes.end(); ++vit) {
-    VI v = m_graph->find_vertex(*vit);
-    for(EI ei = v->begin(); ei != v->end(); ++ei) {
-      if(SkipEdge(ei))
-        continue;
-
-      CFG* cfg2 = &GetCfg((*ei).target());
-      WEIGHT& edge = (*ei).property();
-      edge.Set(edgeIdx++, &v->property(), cfg2);
-    }
-  }
 
+template <class CFG, class WEIGHT>
+void
+CCModel<CFG, WEIGHT>::
+Initialize() {
   //If user changes a CC's color, color at associated index is changed
   if(m_colorIndex.find(m_rep) == m_colorIndex.end())
     m_colorIndex[m_rep] = Color4(DRand()/2.0 + 0.25, DRand()/2.0 + 0.25, DRand()/2.0 + 0.25, 1);
-  SetColor(m_colorIndex[m_rep]);
+  Model::SetColor(m_colorIndex[m_rep]);
+
+  vector<VID> nodes;
+  nodes.swap(m_nodes);
+  m_numEdges = 0;
+  m_nodeBuffer.clear();
+  m_dofBuffer.clear();
+  m_validBuffer.clear();
+  m_edgeBuffer.clear();
+  m_min = Point3d();
+  m_max = Point3d();
+  m_edgeStarts.clear();
+  m_edges.clear();
+  m_geometry.reset();
+  m_geometryChanged = true;
+  m_sharedNodes = 0;
+  m_sharedEdges = 0;
+  m_sharedEdgeStarts = 0;
+  m_sharedDofs = 0;
+  atomic_store(&m_lods, shared_ptr<const LODSet>());
+  ++m_generation;
+  m_nodeBuffer.reserve(3 * nodes.size());
+
+  //Set up nodes, then edges once every endpoint belongs to this CC
+  for(auto& vid : nodes)
+    AddNode(vid);
+  for(auto& vid : m_nodes) {
+    VI v = m_graph->find_vertex(vid);
+    for(EI ei = v->begin(); ei != v->end(); ++ei)
+      if(!SkipEdge(ei))
+        AddEdge(v, ei);
+  }
 }
 
 
 template <class CFG, class WEIGHT>
 void
 CCModel<CFG, WEIGHT>::
-SetColor(const Color4& _c) {
-  Model::SetColor(_c);
-  m_colorIndex[m_rep] = _c;
+Merge(const CCModel& _cc) {
+  for(auto& vid : _cc.m_nodes)
+    AddNode(vid);
 
-  for(auto& vid : m_nodes) {
+  //Edges to nodes which are not members yet are left to Extend.
+  for(auto& vid : _cc.m_nodes) {
     VI v = m_graph->find_vertex(vid);
-    v->property().SetColor(_c);
-    v->property().Lock();
-    for(EI ei = v->begin(); ei != v->end(); ++ei) {
-      if(SkipEdge(ei))
-        continue;
-      (*ei).property().SetColor(_c);
-    }
-    v->property().UnLock();
+    for(EI ei = v->begin(); ei != v->end(); ++ei)
+      if(!SkipEdge(ei) && GetCfg((*ei).target()).GetCC() == this)
+        AddEdge(v, ei);
   }
 }
 
@@ -144,133 +372,507 @@ SetColor(const Color4& _c) {
 template <class CFG, class WEIGHT>
 void
 CCModel<CFG, WEIGHT>::
-GetChildren(list<Model*>& _models) {
+Extend(const vector<VID>& _nodes, const vector<pair<VID, VID>>& _edges) {
+  for(auto& vid : _nodes)
+    AddNode(vid);
+  for(auto& e : _edges) {
+    VI vi;
+    EI ei;
+    m_graph->find_edge(EID(e.first, e.second), vi, ei);
+    AddEdge(vi, ei);
+  }
+}
+
+
+template <class CFG, class WEIGHT>
+void
+CCModel<CFG, WEIGHT>::
+Relink() {
+  m_numEdges = 0;
+  for(auto& vid : m_nodes)
+    GetCfg(vid).Set(vid, this);
   for(auto& vid : m_nodes) {
     VI v = m_graph->find_vertex(vid);
-    _models.push_back(&v->property());
-    v->property().Lock();
-    for(EI ei = v->begin(); ei != v->end(); ++ei) {
-      if(SkipEdge(ei))
-        continue;
-      _models.push_back(&(*ei).property());
-    }
-    v->property().UnLock();
+    for(EI ei = v->begin(); ei != v->end(); ++ei)
+      if(!SkipEdge(ei))
+        LinkEdge(v, ei);
   }
 }
 
 
 template <class CFG, class WEIGHT>
-bool
+void
 CCModel<CFG, WEIGHT>::
-SkipEdge(EI _edgeIter) const {
-  const VID source = _edgeIter->source(),
-            target = _edgeIter->target();
+AddNode(VID _v) {
+  CFG& cfg = GetCfg(_v);
+  cfg.Set(_v, this);
+  cfg.SetColor(GetColor());
+  m_nodes.push_back(_v);
+  PushPoint(m_nodeBuffer, cfg.GetPoint());
+  const vector<double>& dofs = cfg.GetData();
+  m_dofBuffer.insert(m_dofBuffer.end(), dofs.begin(), dofs.end());
+  m_validBuffer.push_back(cfg.IsValid());
+  m_geometryChanged = true;
+}
+
 
-  return source > target and m_graph->IsEdge(target, source);
+template <class CFG, class WEIGHT>
+void
+CCModel<CFG, WEIGHT>::
+AddEdge(VI _v, EI _ei) {
+  LinkEdge(_v, _ei);
+  m_edgeStarts.push_back(m_edgeBuffer.size() / 3);
+  m_edges.emplace_back(_v->descriptor(), (*_ei).target());
+  m_geometryChanged = true;
+
+  //Each edge becomes a chain of line segments through its intermediates.
+  Point3d last = _v->property().GetPoint();
+  for(auto& c : (*_ei).property().GetIntermediates()) {
+    Point3d next = c.GetPoint();
+    PushPoint(m_edgeBuffer, last);
+    PushPoint(m_edgeBuffer, next);
+    last = next;
+  }
+  PushPoint(m_edgeBuffer, last);
+  PushPoint(m_edgeBuffer, GetCfg((*_ei).target()).GetPoint());
 }
 
 
 template <class CFG, class WEIGHT>
-void CCModel<CFG, WEIGHT>::
-DrawRender() {
-  if(m_renderMode == INVISIBLE_MODE)
-    return;
+void
+CCModel<CFG, WEIGHT>::
+LinkEdge(VI _v, EI _ei) {
+  WEIGHT& edge = (*_ei).property();
+  edge.Set(m_numEdges++, &_v->property(), &GetCfg((*_ei).target()));
+  edge.SetColor(GetColor());
+}
+
 
-  glColor4fv(GetColor());
-
-  switch(CFG::GetShape()){
-    case CFG::Robot:
-      glEnable(GL_LIGHTING);
-      glLineWidth(1);
-      typedef typename vector<VID>::iterator VIT;
-      for(VIT vit = m_nodes.begin(); vit != m_nodes.end(); ++vit)
-        GetCfg(*vit).DrawRender();
-      break;
-
-    case CFG::Point:
-      glDisable(GL_LIGHTING);
-      glPointSize(CFG::GetPointSize());
-      glBegin(GL_POINTS);
-      typedef typename vector<VID>::iterator VIT;
-      for(VIT vit = m_nodes.begin(); vit != m_nodes.end(); ++vit)
-        glVertex3dv(GetCfg(*vit).GetPoint());
-      glEnd();
-      break;
+template <class CFG, class WEIGHT>
+shared_ptr<const typename CCModel<CFG, WEIGHT>::LODSet>
+CCModel<CFG, WEIGHT>::Geometry::
+BuildLODs() const {
+  auto lods = make_shared<LODSet>();
+  lods->m_generation = m_generation;
+  for(auto& chunk : m_chunks) {
+    lods->m_nodes += chunk->m_nodes.size() / 3;
+    lods->m_edgePoints += chunk->m_edges.size() / 3;
   }
 
-  //draw edges
-  glDisable(GL_LIGHTING);
-  glLineWidth(WEIGHT::m_edgeThickness);
+  Vector3d size = m_max - m_min;
+  double extent = max(size[0], max(size[1], size[2]));
+  if(lods->m_nodes < 64 || extent <= 0)
+    return lods;
+
+  //Split the CC into the tiles of a 4x4x4 grid. Level cells start at the tile
+  //size and halve from there, so each cell lies in one tile.
+  double tileSize = extent / 4;
+  vector<LODTile>& tiles = lods->m_tiles;
+  unordered_map<uint64_t, size_t> tileIndex;
+  auto tileOf = [&](const GLfloat* _p) -> LODTile& {
+    auto t = tileIndex.insert(make_pair(CellKey(_p, tileSize), tiles.size()));
+    if(t.second) {
+      tiles.push_back(LODTile());
+      tiles.back().m_min = tiles.back().m_max = Point3d(_p[0], _p[1], _p[2]);
+    }
+    return tiles[t.first->second];
+  };
+  auto push = [](LODTile& _tile, vector<GLfloat>& _buffer, const GLfloat* _p) {
+    _buffer.insert(_buffer.end(), _p, _p + 3);
+    for(size_t j = 0; j < 3; ++j) {
+      _tile.m_min[j] = min<double>(_tile.m_min[j], _p[j]);
+      _tile.m_max[j] = max<double>(_tile.m_max[j], _p[j]);
+    }
+  };
+  for(auto& chunk : m_chunks) {
+    for(size_t i = 0; i < chunk->m_nodes.size(); i += 3) {
+      LODTile& tile = tileOf(&chunk->m_nodes[i]);
+      push(tile, tile.m_nodes, &chunk->m_nodes[i]);
+    }
 
-  glBegin(GL_LINES);
-  typedef typename vector<VID>::iterator VIT;
-  for(VIT vit = m_nodes.begin(); vit != m_nodes.end(); ++vit) {
-    VI v = m_graph->find_vertex(*vit);
-    v->property().Lock();
-    for(EI ei = v->begin(); ei != v->end(); ++ei) {
-      if(SkipEdge(ei))
+    //Each edge goes with the tile of its first point
+    const vector<GLuint>& starts = chunk->m_edgeStarts;
+    const vector<GLfloat>& edges = chunk->m_edges;
+    for(size_t i = 0; i < starts.size(); ++i) {
+      size_t end = i + 1 < starts.size() ? starts[i + 1] : edges.size() / 3;
+      LODTile& tile = tileOf(&edges[3 * starts[i]]);
+      for(size_t j = starts[i]; j < end; ++j)
+        push(tile, tile.m_edges, &edges[3 * j]);
+    }
+  }
+
+  //A tile stops adding levels once they would not draw much less than the
+  //tile in full
+  vector<char> open(tiles.size(), true);
+  size_t numOpen = tiles.size();
+  double cell = tileSize;
+  for(size_t l = 0; numOpen && l < 16; ++l, cell /= 2) {
+    //Average the nodes of each cell
+    unordered_map<uint64_t, GLuint> clusters;
+    vector<double> sums;
+    vector<size_t> counts, clusterTiles, tileClusters(tiles.size(), 0);
+    for(size_t t = 0; t < tiles.size(); ++t) {
+      const vector<GLfloat>& nodes = tiles[t].m_nodes;
+      for(size_t i = 0; i < nodes.size(); i += 3) {
+        const GLfloat* p = &nodes[i];
+        auto c = clusters.insert(make_pair(CellKey(p, cell), counts.size()));
+        if(c.second) {
+          sums.resize(sums.size() + 3, 0);
+          counts.push_back(0);
+          clusterTiles.push_back(t);
+          ++tileClusters[t];
+        }
+        GLuint index = c.first->second;
+        for(size_t j = 0; j < 3; ++j)
+          sums[3 * index + j] += p[j];
+        ++counts[index];
+      }
+    }
+
+    vector<size_t> levelIndex(tiles.size());
+    for(size_t t = 0; t < tiles.size(); ++t) {
+      if(open[t] && 4 * tileClusters[t] > tiles[t].m_nodes.size() / 3) {
+        open[t] = false;
+        --numOpen;
+      }
+      if(!open[t])
         continue;
+      levelIndex[t] = tiles[t].m_levels.size();
+      tiles[t].m_levels.push_back(LODLevel());
+      tiles[t].m_levels.back().m_cellSize = cell;
+    }
+    for(size_t c = 0; c < counts.size(); ++c) {
+      size_t t = clusterTiles[c];
+      if(!open[t])
+        continue;
+      vector<GLfloat>& points = tiles[t].m_levels[levelIndex[t]].m_points;
+      for(size_t j = 0; j < 3; ++j)
+        points.push_back(sums[3 * c + j] / counts[c]);
+    }
 
-      CFG* cfg2 = &GetCfg((*ei).target());
-      WEIGHT& edge = (*ei).property();
-      edge.Set(&v->property(), cfg2);
-      edge.DrawRenderInCC();
+    //Bundle the edges joining each pair of cells, using the end points of
+    //each edge's segment chain. A bundle goes with the tile of its first
+    //cluster, and ends at the other cluster's centroid at the same level.
+    vector<set<pair<GLuint, GLuint>>> bundles(tiles.size());
+    for(auto& chunk : m_chunks) {
+      const vector<GLuint>& starts = chunk->m_edgeStarts;
+      const vector<GLfloat>& edges = chunk->m_edges;
+      for(size_t i = 0; i < starts.size(); ++i) {
+        size_t end = i + 1 < starts.size() ? starts[i + 1] : edges.size() / 3;
+        auto a = clusters.find(CellKey(&edges[3 * starts[i]], cell));
+        auto b = clusters.find(CellKey(&edges[3 * (end - 1)], cell));
+        if(a == clusters.end() || b == clusters.end() || a == b)
+          continue;
+        auto bundle = minmax(a->second, b->second);
+        size_t t = clusterTiles[bundle.first];
+        if(open[t])
+          bundles[t].insert(bundle);
+      }
+    }
+    for(size_t t = 0; t < tiles.size(); ++t) {
+      if(!open[t])
+        continue;
+      vector<GLfloat>& lines = tiles[t].m_levels[levelIndex[t]].m_lines;
+      lines.reserve(6 * bundles[t].size());
+      for(auto& b : bundles[t])
+        for(GLuint c : {b.first, b.second})
+          for(size_t j = 0; j < 3; ++j)
+            lines.push_back(sums[3 * c + j] / counts[c]);
     }
-    v->property().UnLock();
   }
-  glEnd();
+  return lods;
 }
 
 
 template <class CFG, class WEIGHT>
-void CCModel<CFG, WEIGHT>::
-DrawSelect() {
-  if(m_renderMode == INVISIBLE_MODE)
+shared_ptr<const typename CCModel<CFG, WEIGHT>::Geometry>
+CCModel<CFG, WEIGHT>::
+GetGeometry() {
+  //Keep LOD levels until the CC has grown by an eighth since they were built;
+  //a few new nodes can wait. Levels built since the last call are picked up
+  //even if nothing else changed, unless they were built before Initialize.
+  shared_ptr<const LODSet> lods = atomic_load(&m_lods);
+  if(lods && (lods->m_generation != m_generation ||
+        m_nodes.size() < lods->m_nodes ||
+        m_nodes.size() > lods->m_nodes + lods->m_nodes / 8))
+    lods.reset();
+  if(m_geometry && !m_geometryChanged) {
+    if(m_geometry->m_lods != lods && lods) {
+      auto g = make_shared<Geometry>(*m_geometry);
+      g->m_lods = lods;
+      m_geometry = g;
+    }
+    return m_geometry;
+  }
+
+  auto g = make_shared<Geometry>();
+  g->m_min = m_min;
+  g->m_max = m_max;
+  g->m_rep = GetCfg(m_rep);
+  g->m_lods = lods;
+  g->m_generation = m_generation;
+
+  //Nodes and edges are only appended until the next Initialize, so share the
+  //published chunks and copy just the new tail
+  auto tail = make_shared<Chunk>();
+  tail->m_nodes.assign(m_nodeBuffer.begin() + m_sharedNodes, m_nodeBuffer.end());
+  tail->m_edges.assign(m_edgeBuffer.begin() + m_sharedEdges, m_edgeBuffer.end());
+  for(size_t i = m_sharedEdgeStarts; i < m_edgeStarts.size(); ++i)
+    tail->m_edgeStarts.push_back(m_edgeStarts[i] - m_sharedEdges / 3);
+  tail->m_dofs.assign(m_dofBuffer.begin() + m_sharedDofs, m_dofBuffer.end());
+  tail->m_valid.assign(m_validBuffer.begin() + m_sharedNodes / 3,
+      m_validBuffer.end());
+  if(m_geometry)
+    g->m_chunks = m_geometry->m_chunks;
+  auto size = [](const Chunk& _c) {return _c.m_nodes.size() + _c.m_edges.size();};
+  while(!g->m_chunks.empty() && size(*g->m_chunks.back()) <= size(*tail)) {
+    auto merged = make_shared<Chunk>(*g->m_chunks.back());
+    GLuint offset = merged->m_edges.size() / 3;
+    merged->m_nodes.insert(merged->m_nodes.end(), tail->m_nodes.begin(),
+        tail->m_nodes.end());
+    merged->m_edges.insert(merged->m_edges.end(), tail->m_edges.begin(),
+        tail->m_edges.end());
+    for(auto start : tail->m_edgeStarts)
+      merged->m_edgeStarts.push_back(start + offset);
+    merged->m_dofs.insert(merged->m_dofs.end(), tail->m_dofs.begin(),
+        tail->m_dofs.end());
+    merged->m_valid.insert(merged->m_valid.end(), tail->m_valid.begin(),
+        tail->m_valid.end());
+    merged->m_posed = false;
+    merged->m_robotTransforms.clear();
+    tail = merged;
+    g->m_chunks.pop_back();
+  }
+  if(size(*tail))
+    g->m_chunks.push_back(tail);
+  m_sharedNodes = m_nodeBuffer.size();
+  m_sharedEdges = m_edgeBuffer.size();
+  m_sharedEdgeStarts = m_edgeStarts.size();
+  m_sharedDofs = m_dofBuffer.size();
+
+  m_geometry = g;
+  m_geometryChanged = false;
+  return m_geometry;
+}
+
+
+template <class CFG, class WEIGHT>
+void
+CCModel<CFG, WEIGHT>::Geometry::
+Draw(const Color4& _color, RenderMode _mode) const {
+  if(_mode == INVISIBLE_MODE)
     return;
 
-  //Names: 1 = Nodes, 2 = Edges
+  //Robots reach past the node positions, so only point mode is culled.
+  if(CFG::GetShape() == CFG::Robot) {
+    DrawRobots(_color, _mode);
+    return;
+  }
+
+  //Skip CCs outside of the view
+  const Frustum* frustum = GetVizmo().GetFrustum();
+  if(frustum && !m_chunks.empty() &&
+      frustum->IsOutside((m_min + m_max) / 2, (m_max - m_min).norm() / 2))
+    return;
 
-  //draw nodes
-  glPushName(1);
-  switch(CFG::GetShape()){
-    case CFG::Robot:
-      glLineWidth(1);
-      break;
+  glColor4fv(_color);
+  glDisable(GL_LIGHTING);
+  glPointSize(CFG::GetPointSize());
+  glLineWidth(WEIGHT::m_edgeThickness);
+  glEnableClientState(GL_VERTEX_ARRAY);
+
+  //Far away or too slow to draw in full: choose a level for each tile, so
+  //that the near tiles keep their detail while the far ones are clustered
+  double pixels = GetVizmo().GetLODPixelSize();
+  if(frustum && pixels > 0 && m_lods && !m_lods->m_tiles.empty()) {
+    for(auto& tile : m_lods->m_tiles) {
+      if(frustum->IsOutside((tile.m_min + tile.m_max) / 2,
+            (tile.m_max - tile.m_min).norm() / 2))
+        continue;
+      const LODLevel* level = SelectLOD(tile, *frustum, pixels);
+      if(level)
+        DrawArrays(level->m_points, level->m_lines);
+      else
+        DrawArrays(tile.m_nodes, tile.m_edges);
+    }
 
-    case CFG::Point:
-      glPointSize(CFG::GetPointSize());
-      break;
+    //Draw what was added since the tiles were built in full
+    size_t nodes = 0, edgePoints = 0;
+    for(auto& chunk : m_chunks) {
+      DrawArrays(chunk->m_nodes, chunk->m_edges,
+          max(m_lods->m_nodes, nodes) - nodes,
+          max(m_lods->m_edgePoints, edgePoints) - edgePoints);
+      nodes += chunk->m_nodes.size() / 3;
+      edgePoints += chunk->m_edges.size() / 3;
+    }
   }
+  else
+    for(auto& chunk : m_chunks)
+      DrawArrays(chunk->m_nodes, chunk->m_edges);
+  glDisableClientState(GL_VERTEX_ARRAY);
+}
+
 
-  typedef typename vector<VID>::iterator VIT;
-  for(VIT vit = m_nodes.begin(); vit != m_nodes.end(); ++vit) {
-    glPushName(*vit);
-    GetCfg(*vit).DrawSelect();
-    glPopName();
+template <class CFG, class WEIGHT>
+void
+CCModel<CFG, WEIGHT>::Geometry::
+DrawRobots(const Color4& _color, RenderMode _mode) const {
+  CFG cfg = m_rep;
+  cfg.SetColor(_color);
+  cfg.SetRenderMode(_mode);
+
+  glEnable(GL_LIGHTING);
+  glLineWidth(1);
+  for(auto& chunk : m_chunks) {
+    size_t numNodes = chunk->m_valid.size();
+    if(!numNodes)
+      continue;
+    size_t dofs = chunk->m_dofs.size() / numNodes;
+
+    //Pose the valid nodes once per chunk; invalid ones are drawn one at a
+    //time in their own color
+    if(!chunk->m_posed) {
+      CFG node = m_rep;
+      for(size_t i = 0; i < numNodes; ++i)
+        if(chunk->m_valid[i]) {
+          node.SetCfg(vector<double>(&chunk->m_dofs[dofs * i],
+              &chunk->m_dofs[dofs * i] + dofs));
+          node.GetRobotTransforms(chunk->m_robotTransforms);
+        }
+      chunk->m_posed = true;
+    }
+    if(!chunk->m_robotTransforms.empty())
+      cfg.DrawRobotInstances(chunk->m_robotTransforms);
+
+    for(size_t i = 0; i < numNodes; ++i)
+      if(!chunk->m_valid[i]) {
+        CFG node = cfg;
+        node.SetCfg(vector<double>(&chunk->m_dofs[dofs * i],
+            &chunk->m_dofs[dofs * i] + dofs));
+        node.SetValidity(false);
+        node.DrawRender();
+      }
   }
-  glPopName();
 
   //draw edges
-  glPushName(2);
+  glDisable(GL_LIGHTING);
+  glColor4fv(_color);
   glLineWidth(WEIGHT::m_edgeThickness);
-  for(VIT vit = m_nodes.begin(); vit != m_nodes.end(); ++vit) {
-    glPushName(*vit);
-    VI v = m_graph->find_vertex(*vit);
-    v->property().Lock();
-    for(EI ei = v->begin(); ei != v->end(); ++ei) {
-      if(SkipEdge(ei))
-        continue;
-      glPushName((*ei).target());
-      CFG* cfg2 = &GetCfg((*ei).target());
-      WEIGHT& edge = (*ei).property();
-      edge.Set(&v->property(), cfg2);
-      edge.DrawSelect();
-      glPopName();
+  glEnableClientState(GL_VERTEX_ARRAY);
+  for(auto& chunk : m_chunks)
+    if(!chunk->m_edges.empty()) {
+      glVertexPointer(3, GL_FLOAT, 0, chunk->m_edges.data());
+      glDrawArrays(GL_LINES, 0, chunk->m_edges.size() / 3);
     }
-    v->property().UnLock();
-    glPopName();
+  glDisableClientState(GL_VERTEX_ARRAY);
+}
+
+
+template <class CFG, class WEIGHT>
+const typename CCModel<CFG, WEIGHT>::LODLevel*
+CCModel<CFG, WEIGHT>::Geometry::
+SelectLOD(const LODTile& _tile, const Frustum& _frustum, double _pixels) {
+  Point3d center = (_tile.m_min + _tile.m_max) / 2;
+  for(auto& level : _tile.m_levels)
+    if(_frustum.PixelRadius(center, level.m_cellSize) <= _pixels)
+      return &level;
+  return nullptr;
+}
+
+
+template <class CFG, class WEIGHT>
+void
+CCModel<CFG, WEIGHT>::Geometry::
+DrawArrays(const vector<GLfloat>& _points, const vector<GLfloat>& _lines,
+    size_t _firstPoint, size_t _firstLine) {
+  if(_firstPoint < _points.size() / 3) {
+    glVertexPointer(3, GL_FLOAT, 0, _points.data());
+    glDrawArrays(GL_POINTS, _firstPoint, _points.size() / 3 - _firstPoint);
+  }
+  if(_firstLine < _lines.size() / 3) {
+    glVertexPointer(3, GL_FLOAT, 0, _lines.data());
+    glDrawArrays(GL_LINES, _firstLine, _lines.size() / 3 - _firstLine);
+  }
+}
+
+
+template <class CFG, class WEIGHT>
+uint64_t
+CCModel<CFG, WEIGHT>::Geometry::
+CellKey(const GLfloat* _p, double _cellSize) const {
+  //21 bits per axis
+  uint64_t key = 0;
+  for(size_t i = 0; i < 3; ++i) {
+    //The bounds come from the double positions, so a rounded float may fall
+    //just below them
+    uint64_t c = max(floor((_p[i] - m_min[i]) / _cellSize), 0.);
+    key = key << 21 | (c & 0x1fffff);
+  }
+  return key;
+}
+
+
+template <class CFG, class WEIGHT>
+void
+CCModel<CFG, WEIGHT>::
+PushPoint(vector<GLfloat>& _buffer, const Point3d& _p) {
+  for(size_t i = 0; i < 3; ++i) {
+    if(m_nodeBuffer.empty() || _p[i] < m_min[i])
+      m_min[i] = _p[i];
+    if(m_nodeBuffer.empty() || _p[i] > m_max[i])
+      m_max[i] = _p[i];
   }
-  glPopName();
+  _buffer.push_back(_p[0]);
+  _buffer.push_back(_p[1]);
+  _buffer.push_back(_p[2]);
+}
+
+
+template <class CFG, class WEIGHT>
+void
+CCModel<CFG, WEIGHT>::
+SetColor(const Color4& _c) {
+  Model::SetColor(_c);
+  m_colorIndex[m_rep] = _c;
+
+  for(auto& vid : m_nodes)
+    GetCfg(vid).SetColor(_c);
+  for(auto& e : m_edges)
+    GetEdge(e).SetColor(_c);
+}
+
+
+template <class CFG, class WEIGHT>
+void
+CCModel<CFG, WEIGHT>::
+GetChildren(list<Model*>& _models) {
+  for(auto& vid : m_nodes)
+    _models.push_back(&GetCfg(vid));
+  for(auto& e : m_edges)
+    _models.push_back(&GetEdge(e));
+}
+
+
+template <class CFG, class WEIGHT>
+bool
+CCModel<CFG, WEIGHT>::
+SkipEdge(EI _edgeIter) const {
+  return SkipEdge(m_graph, _edgeIter->source(), _edgeIter->target());
+}
+
+
+template <class CFG, class WEIGHT>
+bool
+CCModel<CFG, WEIGHT>::
+SkipEdge(Graph* _graph, VID _source, VID _target) {
+  return _source > _target and _graph->IsEdge(_target, _source);
+}
+
+
+template <class CFG, class WEIGHT>
+void CCModel<CFG, WEIGHT>::
+DrawRender() {
+  GetGeometry()->Draw(GetColor(), m_renderMode);
 }
 
 
@@ -295,13 +897,17 @@ Select(GLuint* _index, vector<Model*>& _sel) {
   if(!m_selectable || _index == NULL)
     return;
 
-  if(_index[0] == 1)
-    _sel.push_back(&GetCfg(_index[1]));
+  //The names may outlive the nodes and edges they were drawn for
+  if(_index[0] == 1) {
+    VI vi = m_graph->find_vertex(_index[1]);
+    if(vi != m_graph->end())
+      _sel.push_back(&vi->property());
+  }
   else {
     VI vi;
     EI ei;
-    m_graph->find_edge(EID(_index[1], _index[2]), vi, ei);
-    _sel.push_back(&(*ei).property());
+    if(m_graph->find_edge(EID(_index[1], _index[2]), vi, ei))
+      _sel.push_back(&(*ei).property());
   }
 }
 
@@ -333,4 +939,15 @@ GetCfg(VID _v) {
   return m_graph->find_vertex(_v)->property();
 }
 
+
+template<class CFG, class WEIGHT>
+WEIGHT&
+CCModel<CFG, WEIGHT>::
+GetEdge(const pair<VID, VID>& _e) {
+  VI vi;
+  EI ei;
+  m_graph->find_edge(EID(_e.first, _e.second), vi, ei);
+  return (*ei).property();
+}
+
 #endif
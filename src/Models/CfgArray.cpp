@@ -0,0 +1,77 @@
+#include "CfgArray.h"
+
+void
+CfgArray::
+reserve(size_t _n, size_t _dofs) {
+  m_records.reserve(_n);
+  m_values.reserve(_n * _dofs);
+}
+
+
+size_t
+CfgArray::
+Bytes() const {
+  return sizeof(CfgArray) + m_records.capacity() * sizeof(Record) +
+      m_values.capacity() * sizeof(double);
+}
+
+
+void
+CfgArray::
+push_back(const CfgModel& _c) {
+  const vector<double>& data = _c.GetData();
+  Point3d p = _c.GetPoint();
+  m_records.push_back(Record{m_values.size(), {GLfloat(p[0]), GLfloat(p[1]),
+      GLfloat(p[2])}, uint32_t(_c.GetRobotIndex()), uint16_t(data.size()),
+      _c.IsValid()});
+  m_values.insert(m_values.end(), data.begin(), data.end());
+}
+
+
+void
+CfgArray::
+pop_back() {
+  m_values.resize(m_records.back().m_first);
+  m_records.pop_back();
+}
+
+
+void
+CfgArray::
+clear() {
+  m_records.clear();
+  m_values.clear();
+}
+
+
+void
+CfgArray::
+swap(CfgArray& _other) {
+  m_records.swap(_other.m_records);
+  m_values.swap(_other.m_values);
+}
+
+
+void
+CfgArray::
+append(const CfgArray& _other, size_t _first, size_t _count) {
+  for(size_t i = _first; i < _first + _count; ++i) {
+    const Record& r = _other.m_records[i];
+    m_records.push_back(r);
+    m_records.back().m_first = m_values.size();
+    m_values.insert(m_values.end(), _other.m_values.begin() + r.m_first,
+        _other.m_values.begin() + r.m_first + r.m_count);
+  }
+}
+
+
+CfgModel
+CfgArray::
+operator[](size_t _i) const {
+  const Record& r = m_records[_i];
+  CfgModel c(r.m_robot);
+  c.SetCfg(vector<double>(m_values.begin() + r.m_first,
+      m_values.begin() + r.m_first + r.m_count));
+  c.SetValidity(r.m_valid);
+  return c;
+}
@@ -0,0 +1,95 @@
+#ifndef CFG_ARRAY_H_
+#define CFG_ARRAY_H_
+
+#include <cstdint>
+#include <vector>
+using namespace std;
+
+#include "CfgModel.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief   Bulk storage for configurations.
+/// \details Each configuration is a small record holding its robot index,
+///          validity, and position, and a slice of one DOF array shared by
+///          all of them.
+///          Nothing else of a CfgModel is stored. CfgModel objects are made on
+///          request, e.g. to draw, select, or edit a single configuration.
+////////////////////////////////////////////////////////////////////////////////
+class CfgArray {
+
+  public:
+
+    ///\name Size
+    ///@{
+
+    size_t size() const {return m_records.size();}
+    bool empty() const {return m_records.empty();}
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Reserve room for configurations of a given size.
+    void reserve(size_t _n, size_t _dofs);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Estimate the memory used, in bytes.
+    size_t Bytes() const;
+
+    ///@}
+    ///\name Modification
+    ///@{
+
+    void push_back(const CfgModel& _c);
+    void pop_back();
+    void clear();
+    void swap(CfgArray& _other);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Append configurations of another array.
+    /// \param[in] _other The array to copy from.
+    /// \param[in] _first The first configuration to copy.
+    /// \param[in] _count The number of configurations to copy.
+    void append(const CfgArray& _other, size_t _first, size_t _count);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Set the validity of a configuration.
+    void SetValidity(size_t _i, bool _valid) {m_records[_i].m_valid = _valid;}
+
+    ///@}
+    ///\name Access
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Make a CfgModel of a configuration.
+    CfgModel operator[](size_t _i) const;
+    CfgModel back() const {return (*this)[size() - 1];}
+
+    size_t GetRobotIndex(size_t _i) const {return m_records[_i].m_robot;}
+    bool IsValid(size_t _i) const {return m_records[_i].m_valid;}
+    size_t GetDOF(size_t _i) const {return m_records[_i].m_count;}
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the position of a configuration, as from CfgModel::GetPoint.
+    const GLfloat* GetPoint(size_t _i) const {return m_records[_i].m_point;}
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the DOF values of a configuration.
+    const double* GetData(size_t _i) const {
+      return m_values.data() + m_records[_i].m_first;
+    }
+
+    ///@}
+
+  private:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief The stored part of a configuration.
+    struct Record {
+      size_t m_first;    ///< The position of the first DOF value.
+      GLfloat m_point[3];///< The configuration's position.
+      uint32_t m_robot;  ///< The robot index.
+      uint16_t m_count;  ///< The number of DOF values.
+      bool m_valid;      ///< The validity flag.
+    };
+
+    vector<Record> m_records; ///< The configurations, in order.
+    vector<double> m_values;  ///< The DOF values of all configurations.
+};
+
+#endif
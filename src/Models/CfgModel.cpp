@@ -1,25 +1,28 @@
 #include "CfgModel.h"
 
+#include <sstream>
+
 #include "ActiveMultiBodyModel.h"
 #include "EnvModel.h"
 #include "Vizmo.h"
 
+#include "Utilities/TextParser.h"
+
 CfgModel::Shape CfgModel::m_shape = CfgModel::Point;
 float CfgModel::m_pointScale = 10;
 
 CfgModel::
-CfgModel(const size_t _index) : Model("Cfg"), CfgType(_index),
-    m_mutex(new mutex()) { }
+CfgModel(const size_t _index) : Model("Cfg"), CfgType(_index) { }
 
 CfgModel::
 CfgModel(const Vector3d& _vec, const size_t _index) : Model("Cfg"),
-    CfgType(_vec, _index), m_mutex(new mutex()) { }
+    CfgType(_vec, _index) { }
 
 CfgModel::
-CfgModel(const CfgType& _c) : Model("Cfg"), CfgType(_c), m_mutex(new mutex()) { }
+CfgModel(const CfgType& _c) : Model("Cfg"), CfgType(_c) { }
 
 CfgModel::
-CfgModel(const CfgModel& _c) : Model("Cfg"), CfgType(_c), m_mutex(new mutex()) { }
+CfgModel(const CfgModel& _c) : Model("Cfg"), CfgType(_c) { }
 
 void
 CfgModel::
@@ -35,6 +38,32 @@ SetCfg(const vector<double>& _newCfg) {
   m_v.assign(_newCfg.begin(), _newCfg.end());
 }
 
+bool
+CfgModel::
+Parse(const char*& _p, const char* _end) {
+#ifdef PMPCfg
+  //A robot index followed by the robot's DOF values
+  size_t robot;
+  if(!TextParser::ParseUnsigned(_p, _end, robot))
+    return false;
+  if(robot != m_robotIndex || m_v.empty()) {
+    m_robotIndex = robot;
+    m_v.resize(CfgType(robot).GetData().size());
+  }
+  for(auto& v : m_v)
+    if(!TextParser::ParseDouble(_p, _end, v))
+      return false;
+  return true;
+#else
+  //Other cfg types keep their own text layout
+  istringstream iss(string(_p, _end));
+  if(!(iss >> *this))
+    return false;
+  _p = iss.eof() ? _end : _p + size_t(iss.tellg());
+  return true;
+#endif
+}
+
 void
 CfgModel::
 Set(size_t _index, CCModel<CfgModel, EdgeModel>* _cc) {
@@ -136,6 +165,26 @@ DrawPathRobot() {
   robot->DrawRender();
 }
 
+void
+CfgModel::
+GetRobotTransforms(vector<GLfloat>& _buffer) const {
+  shared_ptr<ActiveMultiBodyModel> robot = GetVizmo().GetEnv()->GetRobot(m_robotIndex);
+  robot->ConfigureRender(m_v);
+  robot->GetRenderTransforms(_buffer);
+}
+
+void
+CfgModel::
+DrawRobotInstances(const vector<GLfloat>& _transforms) {
+  if(m_renderMode == INVISIBLE_MODE)
+    return;
+
+  shared_ptr<ActiveMultiBodyModel> robot = GetVizmo().GetEnv()->GetRobot(m_robotIndex);
+  robot->SetColor(m_color);
+  robot->SetRenderMode(m_renderMode);
+  robot->DrawRenderInstances(_transforms);
+}
+
 void
 CfgModel::
 Print(ostream& _os) const {
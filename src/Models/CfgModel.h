@@ -3,7 +3,6 @@
 
 #include <iostream>
 #include <string>
-#include <mutex>
 using namespace std;
 
 #ifdef __APPLE__
@@ -55,6 +54,13 @@ class CfgModel : public Model, public CfgType {
     /// \brief Get the data for this configuration.
     vector<double> GetDataCfg() {return m_v;}
     ////////////////////////////////////////////////////////////////////////////
+    /// \brief Read this cfg from text in the layout written by operator<<,
+    ///        without going through a stream.
+    /// \param[in,out] _p The text position, advanced past the cfg.
+    /// \param[in] _end The end of the text.
+    /// \return False if the text does not hold a cfg.
+    bool Parse(const char*& _p, const char* _end);
+    ////////////////////////////////////////////////////////////////////////////
     /// \brief Label this cfg as valid or invalid.
     void SetValidity(bool _validity) {m_isValid = _validity;}
     ////////////////////////////////////////////////////////////////////////////
@@ -106,13 +112,17 @@ class CfgModel : public Model, public CfgType {
 
     void DrawPathRobot();
 
-    void Lock() {
-      m_mutex->lock();
-    }
-
-    void UnLock() {
-      m_mutex->unlock();
-    }
+    // Batched robot rendering
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Configure this cfg's robot and append its body transforms to a
+    ///        buffer for DrawRobotInstances.
+    void GetRobotTransforms(vector<GLfloat>& _buffer) const;
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Draw this cfg's robot with this cfg's color and render mode once
+    ///        per set of body transforms.
+    /// \param[in] _transforms Transforms collected by GetRobotTransforms from
+    ///                        cfgs of the same robot.
+    void DrawRobotInstances(const vector<GLfloat>& _transforms);
 
   protected:
 
@@ -128,8 +138,6 @@ class CfgModel : public Model, public CfgType {
     bool m_isQuery{false};        ///< Is this configuration is part of a query?
     size_t m_index{(size_t)-1};   ///< This configuration's VID in the roadmap.
     CCModel<CfgModel, EdgeModel>* m_cc{nullptr}; ///< This configuration's CC.
-
-    shared_ptr<mutex> m_mutex;
 };
 
 #endif
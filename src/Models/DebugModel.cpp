@@ -1,7 +1,12 @@
 #include "DebugModel.h"
 
+#include <cctype>
+#include <memory>
+#include <sstream>
+
 #include <containers/sequential/graph/algorithms/dijkstra.h>
 
+#include "ActiveMultiBodyModel.h"
 #include "EnvModel.h"
 #include "RegionBoxModel.h"
 #include "RegionBox2DModel.h"
@@ -9,16 +14,21 @@
 #include "RegionSphere2DModel.h"
 #include "Vizmo.h"
 
+#include "Utilities/TextParser.h"
+
 using namespace DebugInstructions;
 
 DebugModel::
-DebugModel(const string& _filename) :
+DebugModel(const string& _filename, size_t _keyframeBudget) :
     LoadableModel("Debug"),
+    m_keyframeBudget(_keyframeBudget),
     m_index(-1),
     m_mapModel(new MapModel<CfgModel, EdgeModel>()),
     m_edgeNum(-1) {
   SetFilename(_filename);
   m_renderMode = INVISIBLE_MODE;
+  m_mapModel->SetIndexResolution(
+      GetVizmo().GetEnv()->GetEnvironment()->GetPositionRes());
   ParseFile();
   Build();
 }
@@ -27,9 +37,8 @@ DebugModel(const string& _filename) :
 DebugModel::
 ~DebugModel() {
   delete m_mapModel;
-  typedef vector<Instruction*>::iterator IIT;
-  for(IIT iit = m_instructions.begin(); iit != m_instructions.end(); ++iit)
-    delete *iit;
+  for(auto& region : m_regionModels)
+    delete region.second;
 }
 
 
@@ -40,238 +49,525 @@ GetComments(){
 }
 
 
-void
-DebugModel::
-ParseFile() {
-  //check if file exists
-  if(!FileExists(GetFilename()))
-    throw ParseException(WHERE, "'" + GetFilename() + "' does not exist");
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The keyword and number of cfgs of each instruction type.
+struct Syntax {
+  const char* m_name;             ///< The keyword starting the line.
+  size_t m_length;                ///< The keyword length.
+  DebugInstructions::Type m_type; ///< The instruction type.
+  size_t m_cfgs;                  ///< The number of cfgs after the keyword.
+};
+
+static const Syntax syntax[] = {
+  {"AddNode",          7,  AddNode,          1},
+  {"AddEdge",          7,  AddEdge,          2},
+  {"AddTempCfg",       10, AddTempCfg,       1},
+  {"AddTempRay",       10, AddTempRay,       1},
+  {"AddTempEdge",      11, AddTempEdge,      2},
+  {"ClearLastTemp",    13, ClearLastTemp,    0},
+  {"ClearAll",         8,  ClearAll,         0},
+  {"ClearComments",    13, ClearComments,    0},
+  {"RemoveNode",       10, RemoveNode,       1},
+  {"RemoveEdge",       10, RemoveEdge,       2},
+  {"Comment",          7,  Comment,          0},
+  {"QueryInstruction", 16, QueryInstruction, 2},
+  {"AddRegion",        9,  AddRegion,        0},
+  {"RemoveRegion",     12, RemoveRegion,     0}
+};
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse a region shape as written by VDAddRegion and VDRemoveRegion.
+static RegionModel*
+ParseRegion(istream& _is) {
+  int tempType;
+  _is >> tempType;
+
+  string modelShapeName;
+  _is >> modelShapeName;
+
+  RegionModel::Type modelType = static_cast<RegionModel::Type>(tempType);
+  RegionModel* mod;
+
+  if(modelShapeName == "BOX") {
+    Point3d min, max;
+    _is >> min >> max;
+
+    pair<double, double> xPair(min[0], max[0]);
+    pair<double, double> yPair(min[1], max[1]);
+    pair<double, double> zPair(min[2], max[2]);
+
+    mod = new RegionBoxModel(xPair, yPair, zPair);
+  }
+  else if(modelShapeName == "BOX2D") {
+    Point2d min, max;
+    _is >> min >> max;
 
-  ifstream ifs(GetFilename().c_str());
+    pair<double, double> xPair(min[0], max[0]);
+    pair<double, double> yPair(min[1], max[1]);
 
-  typedef vector<Instruction*>::iterator IIT;
-  for(IIT iit = m_instructions.begin(); iit != m_instructions.end(); ++iit)
-    delete *iit;
-  m_instructions.clear();
+    mod = new RegionBox2DModel(xPair, yPair);
+  }
+  else if(modelShapeName == "SPHERE") {
+    Point3d tempCenter;
+    _is >> tempCenter;
 
-  m_instructions.push_back(new Instruction());
+    double radius = -1;
+    _is >> radius;
 
-  string line;
-  while(getline(ifs,line)) {
+    mod = new RegionSphereModel(tempCenter, radius);
+  }
+  else if(modelShapeName == "SPHERE2D") {
+    // Is Point3d to match implementation of Sphere2D
+    // Constructor takes in Point3d and the center is
+    // stored this way
+    Point3d tempCenter;
+    _is >> tempCenter;
 
-    istringstream iss(line);
-    string name;
-    iss>>name;
+    double radius = -1;
+    _is >> radius;
 
-    if(name == "AddNode"){
-      CfgModel c;
-      iss >> c;
-      c.SetColor(Color4(drand48(), drand48(), drand48(), 1));
-      m_instructions.push_back(new AddNode(c));
-    }
-    else if(name == "AddEdge"){
-      CfgModel s, t;
-      iss >> s >> t;
-      m_instructions.push_back(new AddEdge(s, t));
-    }
-    else if(name == "AddTempCfg"){
-      CfgModel c;
-      bool valid;
-      iss >> c >> valid;
-      if(valid) c.SetColor(Color4(0, 0, 0, 0.25));
-      else c.SetColor(Color4(1, 0, 0, 0.25));
-      m_instructions.push_back(new AddTempCfg(c, valid));
-    }
-    else if(name == "AddTempRay"){
-      CfgModel c;
-      iss >> c;
-      m_instructions.push_back(new AddTempRay(c));
-    }
-    else if(name == "AddTempEdge"){
-      CfgModel s, t;
-      iss >> s >> t;
-      m_instructions.push_back(new AddTempEdge(s, t));
-    }
-    else if(name == "ClearAll")
-      m_instructions.push_back(new ClearAll());
-    else if(name == "ClearLastTemp")
-      m_instructions.push_back(new ClearLastTemp());
-    else if(name == "ClearComments")
-      m_instructions.push_back(new ClearComments());
-    else if(name == "RemoveNode"){
-      CfgModel c;
-      iss >> c;
-      m_instructions.push_back(new RemoveNode(c));
-    }
-    else if(name == "RemoveEdge"){
-      CfgModel s, t;
-      iss >> s >> t;
-      m_instructions.push_back(new RemoveEdge(s, t));
-    }
-    else if(name == "Comment")
-      m_instructions.push_back(new Comment(iss.str().substr(8,
-          iss.str().length())));
-    else if(name == "QueryInstruction"){
-      CfgModel s, t;
-      iss >> s >> t;
-      m_instructions.push_back(new QueryInstruction(s, t));
-    }
-    else if(name == "AddRegion") {
-      RegionModel* mod;
+    mod = new RegionSphere2DModel(tempCenter, radius);
+  }
+  else
+    throw ParseException(WHERE, "Region read unknown type: " + modelShapeName);
 
-      int tempType;
-      iss >> tempType;
+  mod->SetType(modelType);
+  mod->ChangeColor();
+  return mod;
+}
 
-      string modelShapeName;
-      iss >> modelShapeName;
 
-      RegionModel::Type modelType = static_cast<RegionModel::Type>(tempType);
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Decode one line of a debug file. Cfgs and text are appended to the
+///        window's pools. Lines with an unknown keyword decode to Nothing.
+/// \param[in] _cfg A scratch cfg, reused between lines.
+/// \return False if the line is malformed.
+static bool
+DecodeLine(const char* _p, const char* _end, CfgModel& _cfg,
+    Instruction& _ins, CfgArray& _cfgs, vector<string>& _text) {
+  const char* p = TextParser::SkipBlanks(_p, _end);
+  const char* nameEnd = p;
+  while(nameEnd < _end && !isspace(*nameEnd))
+    ++nameEnd;
+
+  _ins = Instruction();
+  const Syntax* s = nullptr;
+  for(const auto& entry : syntax) {
+    if(size_t(nameEnd - p) == entry.m_length &&
+        equal(p, nameEnd, entry.m_name)) {
+      s = &entry;
+      break;
+    }
+  }
+  if(!s)
+    return true;
+  _ins.m_type = s->m_type;
+  p = nameEnd;
+
+  for(size_t i = 0; i < s->m_cfgs; ++i) {
+    if(!_cfg.Parse(p, _end))
+      return false;
+    _ins.m_cfgs[i] = _cfgs.size();
+    _cfgs.push_back(_cfg);
+  }
 
-      if(modelShapeName == "BOX") {
+  switch(_ins.m_type) {
+    case AddTempCfg:
+      {
+        size_t valid;
+        if(!TextParser::ParseUnsigned(p, _end, valid))
+          return false;
+        _ins.m_valid = valid;
+      }
+      break;
+    case Comment:
+      _ins.m_text = _text.size();
+      _text.emplace_back(min(_p + 8, _end), _end);
+      break;
+    case AddRegion:
+    case RemoveRegion:
+      {
+        //Regions are made on first use, so only the shape is checked here.
+        size_t type;
+        if(!TextParser::ParseUnsigned(p, _end, type))
+          return false;
+        p = TextParser::SkipBlanks(p, _end);
+        const char* shapeEnd = p;
+        while(shapeEnd < _end && !isspace(*shapeEnd))
+          ++shapeEnd;
+        string shape(p, shapeEnd);
+        if(shape != "BOX" && shape != "BOX2D" && shape != "SPHERE" &&
+            shape != "SPHERE2D")
+          return false;
+        _ins.m_text = _text.size();
+        _text.emplace_back(_p, _end);
+      }
+      break;
+    default:
+      break;
+  }
+  return true;
+}
 
-        Point3d min, max;
-        iss >> min >> max;
 
-        pair<double, double> xPair(min[0], max[0]);
-        pair<double, double> yPair(min[1], max[1]);
-        pair<double, double> zPair(min[2], max[2]);
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the random color of the node added by an instruction. It depends
+///        only on the instruction index, so a node looks the same however its
+///        frame is reached.
+static Color4
+NodeColor(size_t _i) {
+  uint64_t state = _i;
+  auto next = [&state]() {
+    uint64_t z = (state += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return float((z ^ (z >> 31)) >> 40) / float(1 << 24);
+  };
+  float r = next(), g = next(), b = next();
+  return Color4(r, g, b, 1);
+}
 
-        mod = new RegionBoxModel(xPair, yPair, zPair);
-        mod->SetType(modelType);
-        mod->ChangeColor();
-      }
-      else if(modelShapeName == "BOX2D") {
 
-        Point2d min, max;
-        iss >> min >> max;
+////////////////////////////////////////////////////////////////////////////////
+/// \brief A line of a debug file seen while indexing.
+struct IndexRecord {
+  const char* m_line{nullptr}; ///< The line, if it holds an instruction.
+};
 
-        pair<double, double> xPair(min[0], max[0]);
-        pair<double, double> yPair(min[1], max[1]);
 
-        mod = new RegionBox2DModel(xPair, yPair);
-        mod->SetType(modelType);
-        mod->ChangeColor();
-      }
-      else if(modelShapeName == "SPHERE") {
+void
+DebugModel::
+ParseFile() {
+  //check if file exists
+  if(!FileExists(GetFilename()))
+    throw ParseException(WHERE, "'" + GetFilename() + "' does not exist");
 
-        Point3d tempCenter;
-        iss >> tempCenter;
+  for(auto& region : m_regionModels)
+    delete region.second;
+  m_regionModels.clear();
+  m_window.clear();
+  m_block = size_t(-1);
+  m_blocks.clear();
+  m_size = 1;
+
+  //Lines are checked in parallel and only the offset of the first instruction
+  //of each block is kept, so the index is small however long the file is.
+  m_file.reset(new TextParser::MappedFile(GetFilename()));
+  auto check = [](const char* _p, const char* _end, IndexRecord& _r) {
+    thread_local CfgModel cfg;
+    thread_local CfgArray cfgs;
+    thread_local vector<string> text;
+    cfgs.clear();
+    text.clear();
+    Instruction ins;
+    if(!DecodeLine(_p, _end, cfg, ins, cfgs, text))
+      return false;
+    if(ins.m_type != Nothing)
+      _r.m_line = _p;
+    return true;
+  };
+  auto add = [this](IndexRecord& _r) {
+    if(!_r.m_line)
+      return;
+    if((m_size - 1) % m_blockSize == 0)
+      m_blocks.push_back(_r.m_line - m_file->begin());
+    ++m_size;
+  };
+  TextParser::ParseRecords<IndexRecord>(m_file->begin(), m_file->end(), check,
+      add);
+}
 
-        double radius = -1;
-        iss >> radius;
 
-        mod = new RegionSphereModel(tempCenter, radius);
-        mod->SetType(modelType);
-        mod->ChangeColor();
-      }
-      else if(modelShapeName == "SPHERE2D") {
-        // Is Point3d to match implementation of Sphere2D
-        // Constructor takes in Point3d and the center is
-        // stored this way
-        Point3d tempCenter;
-        iss >> tempCenter;
-
-        double radius = -1;
-        iss >> radius;
-
-        mod = new RegionSphere2DModel(tempCenter, radius);
-        mod->SetType(modelType);
-        mod->ChangeColor();
-      }
-      else {
-        string exceptionDescription = "Add region read unknown type: ";
-        exceptionDescription.append(modelShapeName);
-        throw ParseException(WHERE, exceptionDescription.c_str());
-      }
-      m_instructions.push_back(new AddRegion(mod));
-    }
-    else if(name == "RemoveRegion") {
-      RegionModel* mod;
+const Instruction&
+DebugModel::
+GetInstruction(size_t _i) {
+  static const Instruction initial{};
+  if(_i == 0)
+    return initial;
+
+  size_t block = (_i - 1) / m_blockSize;
+  if(block != m_block)
+    Decode(block);
+  return m_window[(_i - 1) % m_blockSize];
+}
 
-      int tempType;
-      iss >> tempType;
 
-      string modelShapeName;
-      iss >> modelShapeName;
+CfgModel
+DebugModel::
+GetCfg(const Instruction& _ins, size_t _n) const {
+  return m_cfgs[_ins.m_cfgs[_n]];
+}
 
-      RegionModel::Type modelType = static_cast<RegionModel::Type>(tempType);
 
-      if(modelShapeName == "BOX") {
-        Point3d min;
-        Point3d max;
-        iss >> min >> max;
+RegionModel*
+DebugModel::
+GetRegion(size_t _i, const Instruction& _ins) {
+  auto iter = m_regionModels.find(_i);
+  if(iter != m_regionModels.end())
+    return iter->second;
+
+  istringstream iss(m_text[_ins.m_text]);
+  string name;
+  iss >> name;
+  RegionModel* mod = ParseRegion(iss);
+  m_regionModels[_i] = mod;
+  return mod;
+}
 
-        pair<double, double> xPair(min[0], max[0]);
-        pair<double, double> yPair(min[1], max[1]);
-        pair<double, double> zPair(min[2], max[2]);
 
-        mod = new RegionBoxModel(xPair, yPair, zPair);
-        mod->SetType(modelType);
-        mod->ChangeColor();
-      }
-      else if(modelShapeName == "BOX2D") {
-        Point2d min;
-        Point2d max;
-        iss >> min >> max;
+void
+DebugModel::
+Decode(size_t _block) {
+  m_window.clear();
+  m_cfgs.clear();
+  m_text.clear();
+  m_block = size_t(-1);
+
+  CfgModel cfg;
+  const char* end = m_file->end();
+  for(const char* line = m_file->begin() + m_blocks[_block];
+      line < end && m_window.size() < m_blockSize; ) {
+    const char* next = TextParser::NextLine(line, end);
+    const char* lineEnd = next;
+    while(lineEnd > line && isspace(lineEnd[-1]))
+      --lineEnd;
+
+    Instruction ins;
+    if(!DecodeLine(line, lineEnd, cfg, ins, m_cfgs, m_text))
+      throw ParseException(WHERE, "Malformed line '" + string(line,
+          min<size_t>(lineEnd - line, 80)) + "' in '" + GetFilename() + "'.");
+    if(ins.m_type != Nothing)
+      m_window.push_back(ins);
+    line = next;
+  }
+  m_block = _block;
+}
 
-        pair<double, double> xPair(min[0], max[0]);
-        pair<double, double> yPair(min[1], max[1]);
 
-        mod = new RegionBox2DModel(xPair, yPair);
-        mod->SetType(modelType);
-        mod->ChangeColor();
-      }
-      else if(modelShapeName == "SPHERE") {
+void
+DebugModel::
+Build() {
+  m_prevIndex = 0;
+  m_index = 0;
+  m_edgeNum = 0;
+  m_hasTempRay = false;
 
-        Point3d tempCenter;
-        iss >> tempCenter;
+  m_mapModel->Build();
+  m_mapModel->SetRenderMode(SOLID_MODE);
+  BuildKeyframes();
+}
 
-        double radius = -1;
-        iss >> radius;
 
-        mod = new RegionSphereModel(tempCenter, radius);
-        mod->SetType(modelType);
-        mod->ChangeColor();
-      }
-      else if(modelShapeName == "SPHERE2D") {
-        // Is Point3d to match implementation of Sphere2D
-        // Constructor takes in Point3d and the center is
-        // stored this way
-        Point3d tempCenter;
-        iss >> tempCenter;
+size_t
+DebugModel::Keyframe::
+Bytes() const {
+  size_t bytes = sizeof(Keyframe) + m_vids.capacity() * sizeof(size_t) +
+      m_cfgs.Bytes() + m_colors.capacity() * sizeof(Color4) +
+      m_edges.capacity() * sizeof(KeyEdge);
 
-        double radius = -1;
-        iss >> radius;
+  bytes += m_scene.m_tempCfgs.Bytes() + m_scene.m_tempEdges.Bytes() +
+      m_scene.m_query.Bytes() +
+      m_scene.m_regions.size() * sizeof(RegionModel*);
+  for(const auto& comment : m_scene.m_comments)
+    bytes += sizeof(string) + comment.size();
+  return bytes;
+}
 
-        mod = new RegionSphere2DModel(tempCenter, radius);
-        mod->SetType(modelType);
-        mod->ChangeColor();
 
+void
+DebugModel::
+BuildKeyframes() {
+  m_keyframes.clear();
+  m_keyframes.emplace_back();
+  Capture(m_keyframes.back());
+  size_t bytes = m_keyframes.back().Bytes();
+
+  for(size_t frame = m_keyframeSpacing; frame < m_size;
+      frame += m_keyframeSpacing) {
+    m_index = frame;
+    BuildForward();
+    m_prevIndex = m_index;
+
+    //Nothing is undone past a keyframe, so the undo stacks can go
+    m_edgeColors.clear();
+    m_ccMerges.clear();
+    m_removedEdges.clear();
+    m_cleared.clear();
+
+    m_keyframes.emplace_back();
+    Capture(m_keyframes.back());
+    bytes += m_keyframes.back().Bytes();
+
+    while(bytes > m_keyframeBudget && m_keyframes.size() > 2) {
+      m_keyframeSpacing *= 2;
+      bytes = 0;
+      size_t kept = 0;
+      for(size_t i = 0; i < m_keyframes.size(); ++i) {
+        if(m_keyframes[i].m_index % m_keyframeSpacing)
+          continue;
+        bytes += m_keyframes[i].Bytes();
+        if(i != kept)
+          m_keyframes[kept] = move(m_keyframes[i]);
+        ++kept;
       }
-      else {
-        string exceptionDescription = "Add region read unknown type: ";
-        exceptionDescription.append(modelShapeName);
-        throw ParseException(WHERE, exceptionDescription.c_str());
-      }
-      m_instructions.push_back(new RemoveRegion(mod));
+      m_keyframes.resize(kept);
     }
+    //Keep the next keyframe on the (possibly wider) spacing
+    frame -= frame % m_keyframeSpacing;
   }
+
+  Restore(m_keyframes.front());
+  m_index = 0;
 }
 
 
 void
 DebugModel::
-Build() {
-  m_prevIndex = 0;
-  m_index = 0;
-  m_edgeNum = 0;
-  m_tempRay = NULL;
+Capture(Keyframe& _key) {
+  typedef MM::VI VI;
+  typedef MM::EI EI;
 
-  m_mapModel->Build();
+  _key.m_index = m_prevIndex;
+  MM::RGraph* graph = m_mapModel->GetGraph();
+  for(VI vi = graph->begin(); vi != graph->end(); ++vi) {
+    const CfgModel& cfg = vi->property();
+    _key.m_vids.push_back(vi->descriptor());
+    _key.m_cfgs.push_back(cfg);
+    _key.m_colors.push_back(cfg.GetColor());
+    for(EI ei = vi->begin(); ei != vi->end(); ++ei)
+      _key.m_edges.push_back(KeyEdge{vi->descriptor(), (*ei).target(),
+          (*ei).property().GetID(), (*ei).property().GetColor()});
+  }
+  _key.m_vids.shrink_to_fit();
+  _key.m_colors.shrink_to_fit();
+  _key.m_edges.shrink_to_fit();
+  _key.m_edgeNum = m_edgeNum;
+
+  Scene& scene = _key.m_scene;
+  scene.m_hasTempRay = m_hasTempRay;
+  scene.m_tempRay = m_tempRay;
+  scene.m_tempCfgs = m_tempCfgs;
+  scene.m_tempEdges = m_tempEdges;
+  scene.m_query = m_query;
+  scene.m_comments = m_comments;
+  scene.m_regions = m_regions;
+}
+
+
+void
+DebugModel::
+Restore(const Keyframe& _key) {
+  //Vertices keep their VIDs, so the edges can be added by VID afterwards
+  m_mapModel->Clear();
+  MM::RGraph* graph = m_mapModel->GetGraph();
+  for(size_t i = 0; i < _key.m_vids.size(); ++i) {
+    CfgModel cfg = _key.m_cfgs[i];
+    cfg.SetColor(_key.m_colors[i]);
+    graph->add_vertex(_key.m_vids[i], cfg);
+  }
+  for(const auto& e : _key.m_edges) {
+    EdgeModel edge("", 1);
+    edge.Set(e.m_id, &graph->find_vertex(e.m_source)->property(),
+        &graph->find_vertex(e.m_target)->property());
+    edge.SetColor(e.m_color);
+    graph->add_edge(e.m_source, e.m_target, edge);
+  }
+  m_edgeNum = _key.m_edgeNum;
+
+  const Scene& scene = _key.m_scene;
+  m_hasTempRay = scene.m_hasTempRay;
+  m_tempRay = scene.m_tempRay;
+  m_tempCfgs = scene.m_tempCfgs;
+  m_tempEdges = scene.m_tempEdges;
+  m_query = scene.m_query;
+  m_comments = scene.m_comments;
+  m_regions = scene.m_regions;
+
+  m_edgeColors.clear();
+  m_removedEdges.clear();
+  m_cleared.clear();
+  DropCCs();
+  m_undoBase = _key.m_index;
+  m_prevIndex = _key.m_index;
+
+  m_mapModel->RefreshMap();
   m_mapModel->SetRenderMode(SOLID_MODE);
 }
 
 
+void
+DebugModel::
+Seek() {
+  const size_t target = m_index;
+  const size_t current = m_prevIndex;
+
+  //Replaying backward is only possible down to the last restored keyframe
+  size_t fromCurrent = size_t(-1);
+  if(target >= current)
+    fromCurrent = target - current;
+  else if(target >= m_undoBase)
+    fromCurrent = current - target;
+
+  auto key = upper_bound(m_keyframes.begin(), m_keyframes.end(), target,
+      [](size_t _i, const Keyframe& _k) {return _i < _k.m_index;});
+  --key;
+  if(target - key->m_index < fromCurrent)
+    Restore(*key);
+
+  if(m_index > m_prevIndex)
+    BuildForward();
+  else if(m_index < m_prevIndex)
+    BuildBackward();
+}
+
+
+void
+DebugModel::
+TrackCCs() {
+  if(m_ccsTracked)
+    return;
+  m_ccsTracked = true;
+  m_ccMerges.clear();
+
+  MM::RGraph* graph = m_mapModel->GetGraph();
+  MM::ColorMap cMap;
+  for(auto vi = graph->begin(); vi != graph->end(); ++vi) {
+    if(m_ccOf.count(vi->descriptor()))
+      continue;
+    vector<MM::VID> members;
+    cMap.reset();
+    get_cc(*graph, cMap, vi->descriptor(), members);
+    for(auto vid : members)
+      m_ccOf[vid] = m_ccMembers.size();
+    m_ccMembers.push_back(move(members));
+  }
+}
+
+
+void
+DebugModel::
+DropCCs() {
+  m_ccsTracked = false;
+  m_ccOf.clear();
+  m_ccMembers.clear();
+  m_ccMerges.clear();
+}
+
+
+void
+DebugModel::
+ColorCC(size_t _cc, size_t _first, const Color4& _c) {
+  const vector<MM::VID>& members = m_ccMembers[_cc];
+  for(size_t i = _first; i < members.size(); ++i) {
+    auto vi = m_mapModel->GetGraph()->find_vertex(members[i]);
+    vi->property().SetColor(_c);
+    for(auto ei = (*vi).begin(); ei != (*vi).end(); ++ei)
+      (*ei).property().SetColor(_c);
+  }
+}
+
+
 void
 DebugModel::
 BuildForward() {
@@ -281,208 +577,231 @@ BuildForward() {
   typedef MM::EID EID;
   typedef MM::EI EI;
   typedef vector<VID>::iterator ITVID;
-  typedef MM::ColorMap ColorMap;
   typedef MM::EdgeMap EdgeMap;
 
   for(int i = m_prevIndex; i < m_index; i++) {
-    Instruction* ins = m_instructions[i];
-    if(ins->m_name == "AddNode") {
-      //add vertex specified by instruction to the graph
-      AddNode* an = static_cast<AddNode*>(ins);
-      m_mapModel->GetGraph()->AddVertex(an->m_cfg);
-    }
-    else if(ins->m_name == "AddEdge") {
-      AddEdge* ae = static_cast<AddEdge*>(ins);
-      //add edge to the graph
-
-      Color4 color;
-      vector<VID> nIdCC1; //node id in this cc
-      vector<VID> nIdCC2; //node id in this cc
-      vector<VID>* smallerCC;
-      EdgeModel edge("", 1);
-
-      VID svId = m_mapModel->Cfg2VID(ae->m_source);
-      VID tvId = m_mapModel->Cfg2VID(ae->m_target);
-      CfgModel& source = m_mapModel->GetGraph()->find_vertex(svId)->property();
-      CfgModel& target = m_mapModel->GetGraph()->find_vertex(tvId)->property();
-
-      //set properties of edge and increase the edge count
-      edge.Set(m_edgeNum++, &source, &target);
-
-      ColorMap cMap;
-      cMap.reset();
-      get_cc(*(m_mapModel->GetGraph()), cMap, tvId, nIdCC1);
-      cMap.reset();
-      get_cc(*(m_mapModel->GetGraph()), cMap, svId, nIdCC2);
-
-      //store color of larger CC; will later color the smaller CC with this
-      if(nIdCC1.size() > nIdCC2.size()){
-        color = target.GetColor();
-        smallerCC = &nIdCC2;
-      }
-      else{
-        color = source.GetColor();
-        smallerCC = &nIdCC1;
-      }
-      //store source and target colors in instruction;
-      //will be restored when AddEdge is reversed in BuildBackward
-      ae->m_targetColor = target.GetColor();
-      ae->m_sourceColor = source.GetColor();
-      //change color of smaller CC to that of larger CC
-      for(ITVID it = smallerCC->begin(); it != smallerCC->end(); ++it) {
-        VI vi = m_mapModel->GetGraph()->find_vertex(*it);
-        CfgModel* cfgCC = &(vi->property());
-        cfgCC->SetColor(color);
-        for(EI ei = (*vi).begin(); ei != (*vi).end(); ++ei){
-          (*ei).property().SetColor(color) ;
+    const Instruction& ins = GetInstruction(i);
+    switch(ins.m_type) {
+      case AddNode:
+        {
+          //add vertex specified by instruction to the graph
+          CfgModel c = GetCfg(ins, 0);
+          c.SetColor(NodeColor(i));
+          VID vid = m_mapModel->AddVertex(c);
+          if(m_ccsTracked && !m_ccOf.count(vid)) {
+            m_ccOf[vid] = m_ccMembers.size();
+            m_ccMembers.push_back(vector<VID>(1, vid));
+          }
         }
-      }
-      //set color of new edge to that of larger cc
-      edge.SetColor(color);
-      //add edge
-      m_mapModel->GetGraph()->add_edge(svId, tvId, edge);
-      m_mapModel->GetGraph()->add_edge(tvId, svId, edge);
-    }
-    else if(ins->m_name == "AddTempCfg"){
-      //add temporary cfg
-      AddTempCfg* atc = static_cast<AddTempCfg*>(ins);
-      m_tempCfgs.push_back(atc->m_cfg);
-      m_tempCfgs.back().Set(0, NULL);
-      m_tempCfgs.back().SetShape(CfgModel::Robot);
-      if(!atc->m_valid)
-        m_tempCfgs.back().SetColor(Color4(1, 0, 0, 1));
-    }
-    else if(ins->m_name == "AddTempRay"){
-      //add temporary ray
-      AddTempRay* atr = static_cast<AddTempRay*>(ins);
-      m_tempRay = &atr->m_cfg;
-    }
-    else if(ins->m_name == "AddTempEdge"){
-      //add temporary edge
-      AddTempEdge* ate = static_cast<AddTempEdge*>(ins);
-      EdgeModel e("", 1);
-      e.Set(1, &ate->m_source, &ate->m_target);
-      m_tempEdges.push_back(e);
-    }
-    else if(ins->m_name == "ClearLastTemp"){
-      //clear last temporary cfg, edge, ray
-      //and store them in the instruction to be restored in BuildBackward
-      ClearLastTemp* clt = static_cast<ClearLastTemp*>(ins);
-
-      clt->m_tempRay = m_tempRay;
-      m_tempRay = NULL;
-
-      if(m_tempCfgs.size()>0) {
-        clt->m_lastTempCfgs.push_back(m_tempCfgs.back());
-        m_tempCfgs.pop_back();
-      }
-      if(m_tempEdges.size()>0) {
-        clt->m_lastTempEdges.push_back(m_tempEdges.back());
-        m_tempEdges.pop_back();
-      }
-    }
-    else if(ins->m_name == "ClearAll"){
-      //clear all temporary cfgs, edges, rays, comments, queries
-      ClearAll* ca = static_cast<ClearAll*>(ins);
-
-      ca->m_tempRay = m_tempRay;
-      m_tempRay = NULL;
-
-      ca->m_tempCfgs = m_tempCfgs;
-      m_tempCfgs.clear();
-
-      ca->m_tempEdges = m_tempEdges;
-      m_tempEdges.clear();
-
-      ca->m_query = m_query;
-      m_query.clear();
-
-      ca->m_comments = m_comments;
-      m_comments.clear();
-
-      ca->m_regions = m_regions;
-      m_regions.clear();
-    }
-    else if(ins->m_name == "ClearComments"){
-      //clear all comments
-      ClearComments* cc = static_cast<ClearComments*>(ins);
-      cc->m_comments = m_comments;
-      m_comments.clear();
-    }
-    else if(ins->m_name == "RemoveNode"){
-      //remove an existing node
-      RemoveNode* rn = static_cast<RemoveNode*>(ins);
-      VID xvId = m_mapModel->Cfg2VID(rn->m_cfg);
-      m_mapModel->GetGraph()->delete_vertex(xvId);
-    }
-    else if(ins->m_name == "RemoveEdge"){
-      //remove an existing edge
-      RemoveEdge* re = static_cast<RemoveEdge*>(ins);
-      VID svId = m_mapModel->Cfg2VID(re->m_source);
-      VID tvId = m_mapModel->Cfg2VID(re->m_target);
-
-      //store ID of edge being removed
-      //to be restored in BuildBackward
-      EID eid(svId, tvId);
-      VI vi;
-      EI ei;
-      m_mapModel->GetGraph()->find_edge(eid,vi,ei);
-      re->m_edgeNum = (*ei).property().GetID();
-
-      m_mapModel->GetGraph()->delete_edge(svId, tvId);
-      m_mapModel->GetGraph()->delete_edge(tvId, svId);
-    }
-    else if(ins->m_name == "Comment") {
-      //add comment
-      Comment* c = static_cast<Comment*>(ins);
-      m_comments.push_back(c->m_comment);
-    }
-    else if(ins->m_name == "QueryInstruction"){
-      //perform query
-      QueryInstruction* q = static_cast<QueryInstruction*>(ins);
-      vector<VID> path;
-
-      VID svId = m_mapModel->Cfg2VID(q->m_source);
-      VID tvId = m_mapModel->Cfg2VID(q->m_target);
-
-      //clear existing query
-      m_query.clear();
-
-      //perform query using dijkstra's algorithm
-      EdgeMap edgeMap(*(m_mapModel->GetGraph()));
-      find_path_dijkstra(*(m_mapModel->GetGraph()), edgeMap, svId, tvId, path);
-
-      //store edges of query
-      CfgModel source = q->m_source;
-      CfgModel target;
-      if(path.size()>0) {
-        for(ITVID pit = path.begin()+1; pit != path.end(); pit++){
-          target = m_mapModel->GetGraph()->find_vertex(*pit)->property();
-          EdgeModel e("", 1);
-          e.Set(1, &source, &target);
-          m_query.push_back(e);
-          source = target;
+        break;
+
+      case AddEdge:
+        {
+          //add edge to the graph
+          Color4 color;
+          EdgeModel edge("", 1);
+
+          VID svId = m_mapModel->Cfg2VID(GetCfg(ins, 0));
+          VID tvId = m_mapModel->Cfg2VID(GetCfg(ins, 1));
+          CfgModel& source =
+              m_mapModel->GetGraph()->find_vertex(svId)->property();
+          CfgModel& target =
+              m_mapModel->GetGraph()->find_vertex(tvId)->property();
+
+          //set properties of edge and increase the edge count
+          edge.Set(m_edgeNum++, &source, &target);
+
+          //store color of larger CC; will later color the smaller CC with this
+          TrackCCs();
+          size_t sourceCC = m_ccOf[svId], targetCC = m_ccOf[tvId];
+          CCMerge merge;
+          if(m_ccMembers[targetCC].size() > m_ccMembers[sourceCC].size()) {
+            color = target.GetColor();
+            merge.m_into = targetCC;
+            merge.m_from = sourceCC;
+          }
+          else {
+            color = source.GetColor();
+            merge.m_into = sourceCC;
+            merge.m_from = targetCC;
+          }
+          merge.m_size = m_ccMembers[merge.m_into].size();
+          m_ccMerges.push_back(merge);
+          //store source and target colors;
+          //will be restored when AddEdge is reversed in BuildBackward
+          m_edgeColors.emplace_back(source.GetColor(), target.GetColor());
+          //move the smaller CC into the larger one and give it that color
+          if(merge.m_from != merge.m_into) {
+            vector<VID>& into = m_ccMembers[merge.m_into];
+            vector<VID>& from = m_ccMembers[merge.m_from];
+            for(auto vid : from)
+              m_ccOf[vid] = merge.m_into;
+            into.insert(into.end(), from.begin(), from.end());
+            from.clear();
+            ColorCC(merge.m_into, merge.m_size, color);
+          }
+          //set color of new edge to that of larger cc
+          edge.SetColor(color);
+          //add edge
+          m_mapModel->AddEdge(svId, tvId, edge);
+          m_mapModel->AddEdge(tvId, svId, edge);
         }
-      }
-      q->m_query = m_query;
-    }
-    else if(ins->m_name == "AddRegion") {
-      AddRegion* add = static_cast<AddRegion*>(ins);
-      m_regions.push_back(add->m_regionModel);
-    }
-    else if(ins->m_name == "RemoveRegion") {
-      RemoveRegion* rmv = static_cast<RemoveRegion*>(ins);
-      for(vector<RegionModel*>::iterator i = m_regions.begin();
-          i != m_regions.end(); i++) {
-        if(*rmv->m_regionModel == **i) {
-          m_regions.erase(i);
-          break;
+        break;
+
+      case AddTempCfg:
+        //add temporary cfg
+        m_tempCfgs.push_back(GetCfg(ins, 0));
+        m_tempCfgs.SetValidity(m_tempCfgs.size() - 1, ins.m_valid);
+        CfgModel::SetShape(CfgModel::Robot);
+        break;
+
+      case AddTempRay:
+        //add temporary ray
+        m_tempRay = GetCfg(ins, 0);
+        m_hasTempRay = true;
+        break;
+
+      case AddTempEdge:
+        //add temporary edge
+        m_tempEdges.push_back(GetCfg(ins, 0));
+        m_tempEdges.push_back(GetCfg(ins, 1));
+        break;
+
+      case ClearLastTemp:
+        {
+          //clear last temporary cfg, edge, ray
+          //and store them to be restored in BuildBackward
+          m_cleared.emplace_back();
+          Scene& cleared = m_cleared.back();
+
+          cleared.m_hasTempRay = m_hasTempRay;
+          cleared.m_tempRay = m_tempRay;
+          m_hasTempRay = false;
+
+          if(m_tempCfgs.size()>0) {
+            cleared.m_tempCfgs.append(m_tempCfgs, m_tempCfgs.size() - 1, 1);
+            m_tempCfgs.pop_back();
+          }
+          if(m_tempEdges.size()>0) {
+            cleared.m_tempEdges.append(m_tempEdges, m_tempEdges.size() - 2, 2);
+            m_tempEdges.pop_back();
+            m_tempEdges.pop_back();
+          }
         }
-      }
+        break;
+
+      case ClearAll:
+        {
+          //clear all temporary cfgs, edges, rays, comments, queries
+          m_cleared.emplace_back();
+          Scene& cleared = m_cleared.back();
+
+          cleared.m_hasTempRay = m_hasTempRay;
+          cleared.m_tempRay = m_tempRay;
+          m_hasTempRay = false;
+
+          cleared.m_tempCfgs.swap(m_tempCfgs);
+          cleared.m_tempEdges.swap(m_tempEdges);
+          cleared.m_query.swap(m_query);
+          cleared.m_comments.swap(m_comments);
+          cleared.m_regions.swap(m_regions);
+        }
+        break;
+
+      case ClearComments:
+        //clear all comments
+        m_cleared.emplace_back();
+        m_cleared.back().m_comments.swap(m_comments);
+        break;
+
+      case RemoveNode:
+        {
+          //remove an existing node
+          VID xvId = m_mapModel->Cfg2VID(GetCfg(ins, 0));
+          m_mapModel->DeleteVertex(xvId);
+          DropCCs();
+        }
+        break;
+
+      case RemoveEdge:
+        {
+          //remove an existing edge
+          VID svId = m_mapModel->Cfg2VID(GetCfg(ins, 0));
+          VID tvId = m_mapModel->Cfg2VID(GetCfg(ins, 1));
+
+          //store ID of edge being removed
+          //to be restored in BuildBackward
+          EID eid(svId, tvId);
+          VI vi;
+          EI ei;
+          m_mapModel->GetGraph()->find_edge(eid,vi,ei);
+          m_removedEdges.push_back((*ei).property().GetID());
+
+          m_mapModel->DeleteEdge(svId, tvId);
+          m_mapModel->DeleteEdge(tvId, svId);
+          DropCCs();
+        }
+        break;
+
+      case Comment:
+        //add comment
+        m_comments.push_back(m_text[ins.m_text]);
+        break;
+
+      case QueryInstruction:
+        {
+          //perform query
+          vector<VID> path;
+          CfgModel source = GetCfg(ins, 0);
+
+          VID svId = m_mapModel->Cfg2VID(source);
+          VID tvId = m_mapModel->Cfg2VID(GetCfg(ins, 1));
+
+          //set aside existing query
+          m_cleared.emplace_back();
+          m_cleared.back().m_query.swap(m_query);
+
+          //perform query using dijkstra's algorithm
+          EdgeMap edgeMap(*(m_mapModel->GetGraph()));
+          find_path_dijkstra(*(m_mapModel->GetGraph()), edgeMap, svId, tvId,
+              path);
+
+          //store edges of query
+          if(path.size()>0) {
+            for(ITVID pit = path.begin()+1; pit != path.end(); pit++){
+              const CfgModel& target =
+                  m_mapModel->GetGraph()->find_vertex(*pit)->property();
+              m_query.push_back(source);
+              m_query.push_back(target);
+              source = target;
+            }
+          }
+        }
+        break;
+
+      case AddRegion:
+        m_regions.push_back(GetRegion(i, ins));
+        break;
+
+      case RemoveRegion:
+        {
+          RegionModel* rmv = GetRegion(i, ins);
+          for(vector<RegionModel*>::iterator r = m_regions.begin();
+              r != m_regions.end(); r++) {
+            if(*rmv == **r) {
+              m_regions.erase(r);
+              break;
+            }
+          }
+        }
+        break;
+
+      case Nothing:
+        break;
     }
   }
-  //rebuild map model since graph may have changed
-  m_mapModel->Build();
+  //update map model since graph may have changed
+  m_mapModel->RefreshMap();
   m_mapModel->SetRenderMode(SOLID_MODE);
 }
 
@@ -493,7 +812,6 @@ BuildBackward() {
   typedef MapModel<CfgModel, EdgeModel> MM;
   typedef MM::VID VID;
   typedef MM::VI VI;
-  typedef MM::EID EID;
   typedef MM::EI EI;
   typedef MM::ColorMap ColorMap;
   typedef vector<VID>::iterator ITVID;
@@ -502,162 +820,205 @@ BuildBackward() {
   //perform reverse of the forward operation
   //e.g. for AddNode, remove the specified node instead of adding it
   for(size_t i = m_prevIndex; i > (size_t)m_index; i--){
-    Instruction* ins = m_instructions[i-1];
-    if(ins->m_name == "AddNode"){
-      //undo addition of specified node
-      AddNode* an = static_cast<AddNode*>(ins);
-      VID xvId = m_mapModel->Cfg2VID(an->m_cfg);
-      m_mapModel->GetGraph()->delete_vertex(xvId);
-    }
-    else if(ins->m_name == "AddEdge"){
-      //undo addition of edge and restore original colors of CCs
-      AddEdge* ae = static_cast<AddEdge*>(ins);
-      VID svId = m_mapModel->Cfg2VID(ae->m_source);
-      VID tvId = m_mapModel->Cfg2VID(ae->m_target);
-      Color4 color;
-
-      //remove both the forward and reverse edge
-      m_mapModel->GetGraph()->delete_edge(svId, tvId);
-      m_mapModel->GetGraph()->delete_edge(tvId, svId);
-
-      vector<VID> nIdCC1; //node id in this cc
-      vector<VID> nIdCC2; //node id in this cc
-      ColorMap cMap;
-      cMap.reset();
-      get_cc(*(m_mapModel->GetGraph()), cMap, svId, nIdCC2);
-      cMap.reset();
-      get_cc(*(m_mapModel->GetGraph()), cMap, tvId, nIdCC1);
-
-      //get color of the target cfg's CC
-      //which was stored in the instruction
-      color = ae->m_targetColor;
-
-      //restore color of target's CC
-      for(ITVID it = nIdCC1.begin(); it != nIdCC1.end(); ++it){
-        VI vi = m_mapModel->GetGraph()->find_vertex(*it);
-        CfgModel* cfgCC = &(vi->property());
-        cfgCC->SetColor(color);
-
-        for(EI ei = (*vi).begin(); ei != (*vi).end(); ++ei){
-          (*ei).property().SetColor(color) ;
+    const Instruction& ins = GetInstruction(i-1);
+    switch(ins.m_type) {
+      case AddNode:
+        {
+          //undo addition of specified node. Its edges are already undone, so
+          //it is alone in its CC.
+          VID xvId = m_mapModel->Cfg2VID(GetCfg(ins, 0));
+          m_mapModel->DeleteVertex(xvId);
+          if(m_ccsTracked) {
+            auto cc = m_ccOf.find(xvId);
+            if(cc != m_ccOf.end() && m_ccMembers[cc->second].size() == 1) {
+              m_ccMembers[cc->second].clear();
+              m_ccOf.erase(cc);
+            }
+            else
+              DropCCs();
+          }
         }
-      }
-      //get color of source cfg's CC
-      //which was stored in the instruction
-      color = ae->m_sourceColor;
-      //restore color of source's CC
-      for(ITVID it = nIdCC2.begin(); it != nIdCC2.end(); ++it) {
-        VI vi = m_mapModel->GetGraph()->find_vertex(*it);
-        CfgModel* cfgCC = &(vi->property());
-        cfgCC->SetColor(color);
-        for(EI ei = (*vi).begin(); ei != (*vi).end(); ++ei) {
-          (*ei).property().SetColor(color);
+        break;
+
+      case AddEdge:
+        {
+          //undo addition of edge and restore original colors of CCs
+          VID svId = m_mapModel->Cfg2VID(GetCfg(ins, 0));
+          VID tvId = m_mapModel->Cfg2VID(GetCfg(ins, 1));
+
+          //remove both the forward and reverse edge
+          m_mapModel->DeleteEdge(svId, tvId);
+          m_mapModel->DeleteEdge(tvId, svId);
+
+          //get the colors of the source and target cfgs' CCs
+          //which were stored when the edge was added
+          pair<Color4, Color4> colors = m_edgeColors.back();
+          m_edgeColors.pop_back();
+          //undo increment of edge number
+          m_edgeNum--;
+
+          //split off the CC which the edge merged in, which is at the end of
+          //the other one's members, and restore its color
+          if(m_ccsTracked && !m_ccMerges.empty()) {
+            CCMerge merge = m_ccMerges.back();
+            m_ccMerges.pop_back();
+            if(merge.m_from != merge.m_into) {
+              vector<VID>& into = m_ccMembers[merge.m_into];
+              vector<VID>& from = m_ccMembers[merge.m_from];
+              from.assign(into.begin() + merge.m_size, into.end());
+              into.resize(merge.m_size);
+              for(auto vid : from)
+                m_ccOf[vid] = merge.m_from;
+              ColorCC(merge.m_from, 0, m_ccOf[svId] == merge.m_from ?
+                  colors.first : colors.second);
+            }
+            break;
+          }
+
+          //without the tracking, search the graph for both CCs
+          DropCCs();
+          vector<VID> nIdCC1; //node id in this cc
+          vector<VID> nIdCC2; //node id in this cc
+          ColorMap cMap;
+          cMap.reset();
+          get_cc(*(m_mapModel->GetGraph()), cMap, svId, nIdCC2);
+          cMap.reset();
+          get_cc(*(m_mapModel->GetGraph()), cMap, tvId, nIdCC1);
+
+          //restore color of target's CC
+          for(ITVID it = nIdCC1.begin(); it != nIdCC1.end(); ++it){
+            VI vi = m_mapModel->GetGraph()->find_vertex(*it);
+            CfgModel* cfgCC = &(vi->property());
+            cfgCC->SetColor(colors.second);
+
+            for(EI ei = (*vi).begin(); ei != (*vi).end(); ++ei){
+              (*ei).property().SetColor(colors.second) ;
+            }
+          }
+          //restore color of source's CC
+          for(ITVID it = nIdCC2.begin(); it != nIdCC2.end(); ++it) {
+            VI vi = m_mapModel->GetGraph()->find_vertex(*it);
+            CfgModel* cfgCC = &(vi->property());
+            cfgCC->SetColor(colors.first);
+            for(EI ei = (*vi).begin(); ei != (*vi).end(); ++ei) {
+              (*ei).property().SetColor(colors.first);
+            }
+          }
         }
-      }
-      //undo increment of edge number
-      m_edgeNum--;
-    }
-    else if(ins->m_name == "AddTempCfg") {
-      //undo addition of temp cfg
-      m_tempCfgs.pop_back();
-    }
-    else if(ins->m_name == "AddTempRay") {
-      //undo addition of temp ray
-      m_tempRay = NULL;
-    }
-    else if(ins->m_name == "AddTempEdge") {
-      //undo addiion of temp edge
-      m_tempEdges.pop_back();
-    }
-    else if(ins->m_name == "ClearLastTemp") {
-      //undo clearing of last temp cfg, edge, ray
-      //by restoring them from the instruction where they were stored
-      ClearLastTemp* clt = static_cast<ClearLastTemp*>(ins);
-      m_tempRay = clt->m_tempRay;
-
-      while(clt->m_lastTempCfgs.size()>0) {
-        m_tempCfgs.push_back(clt->m_lastTempCfgs.back());
-        clt->m_lastTempCfgs.pop_back();
-      }
-      while(clt->m_lastTempEdges.size()>0) {
-        m_tempEdges.push_back(clt->m_lastTempEdges.back());
-        clt->m_lastTempEdges.pop_back();
-      }
-    }
-    else if(ins->m_name == "ClearAll") {
-      //undo clearing of all temp cfgs, edges, queries, comments
-      //by restoring them from the instruction where they were stored
-      ClearAll* ca = static_cast<ClearAll*>(ins);
+        break;
 
-      m_tempRay = ca->m_tempRay;
-      ca->m_tempRay = NULL;
-
-      m_tempCfgs = ca->m_tempCfgs;
-      ca->m_tempCfgs.clear();
+      case AddTempCfg:
+        //undo addition of temp cfg
+        m_tempCfgs.pop_back();
+        break;
 
-      m_tempEdges = ca->m_tempEdges;
-      ca->m_tempEdges.clear();
+      case AddTempRay:
+        //undo addition of temp ray
+        m_hasTempRay = false;
+        break;
 
-      m_query = ca->m_query;
-      ca->m_query.clear();
+      case AddTempEdge:
+        //undo addiion of temp edge
+        m_tempEdges.pop_back();
+        m_tempEdges.pop_back();
+        break;
+
+      case ClearLastTemp:
+        {
+          //undo clearing of last temp cfg, edge, ray
+          //by restoring them from where they were stored
+          Scene& cleared = m_cleared.back();
+          m_hasTempRay = cleared.m_hasTempRay;
+          m_tempRay = cleared.m_tempRay;
+          m_tempCfgs.append(cleared.m_tempCfgs, 0, cleared.m_tempCfgs.size());
+          m_tempEdges.append(cleared.m_tempEdges, 0,
+              cleared.m_tempEdges.size());
+          m_cleared.pop_back();
+        }
+        break;
+
+      case ClearAll:
+        {
+          //undo clearing of all temp cfgs, edges, queries, comments
+          //by restoring them from where they were stored
+          Scene& cleared = m_cleared.back();
+          m_hasTempRay = cleared.m_hasTempRay;
+          m_tempRay = cleared.m_tempRay;
+          m_tempCfgs.swap(cleared.m_tempCfgs);
+          m_tempEdges.swap(cleared.m_tempEdges);
+          m_query.swap(cleared.m_query);
+          m_comments.swap(cleared.m_comments);
+          m_regions.swap(cleared.m_regions);
+          m_cleared.pop_back();
+        }
+        break;
+
+      case ClearComments:
+        //undo clearing of commments
+        m_comments.swap(m_cleared.back().m_comments);
+        m_cleared.pop_back();
+        break;
+
+      case RemoveNode:
+        //undo removal of node
+        m_mapModel->AddVertex(GetCfg(ins, 0));
+        DropCCs();
+        break;
+
+      case RemoveEdge:
+        {
+          //undo removal of edge
+          EdgeModel edge("", 1);
+          VID svId = m_mapModel->Cfg2VID(GetCfg(ins, 0));
+          VID tvId = m_mapModel->Cfg2VID(GetCfg(ins, 1));
+          CfgModel& source =
+              m_mapModel->GetGraph()->find_vertex(svId)->property();
+          CfgModel& target =
+              m_mapModel->GetGraph()->find_vertex(tvId)->property();
+
+          //restore edge number of edge
+          edge.Set(m_removedEdges.back(), &source, &target);
+          m_removedEdges.pop_back();
+          m_mapModel->AddEdge(svId, tvId, edge);
+          m_mapModel->AddEdge(tvId, svId, edge);
+          DropCCs();
+        }
+        break;
+
+      case Comment:
+        //undo addition of comment
+        m_comments.pop_back();
+        break;
+
+      case QueryInstruction:
+        //undo addition of query and restore the previous one if any
+        m_query.swap(m_cleared.back().m_query);
+        m_cleared.pop_back();
+        break;
+
+      case AddRegion:
+        {
+          RegionModel* add = GetRegion(i-1, ins);
+          for(vector<RegionModel*>::iterator r = m_regions.begin();
+              r != m_regions.end(); r++) {
+            if(*add == **r) {
+              m_regions.erase(r);
+              break;
+            }
+          }
+        }
+        break;
 
-      m_comments = ca->m_comments;
-      ca->m_comments.clear();
+      case RemoveRegion:
+        m_regions.push_back(GetRegion(i-1, ins));
+        break;
 
-      m_regions = ca->m_regions;
-      ca->m_regions.clear();
-    }
-    else if(ins->m_name == "ClearComments") {
-      //undo clearing of commments
-      ClearComments* cc =static_cast<ClearComments*>(ins);
-      m_comments = cc->m_comments;
-      cc->m_comments.clear();
-    }
-    else if(ins->m_name == "RemoveNode") {
-      //undo removal of node
-      RemoveNode* rn = static_cast<RemoveNode*>(ins);
-      m_mapModel->GetGraph()->AddVertex(rn->m_cfg);
-    }
-    else if(ins->m_name == "RemoveEdge") {
-      //undo removal of edge
-      RemoveEdge* re = static_cast<RemoveEdge*>(ins);
-      EdgeModel edge("", 1);
-      VID svId = m_mapModel->Cfg2VID(re->m_source);
-      VID tvId = m_mapModel->Cfg2VID(re->m_target);
-
-      //restore edge number of edge
-      edge.Set(re->m_edgeNum, &re->m_source, &re->m_target);
-      m_mapModel->GetGraph()->add_edge(svId, tvId, edge);
-      m_mapModel->GetGraph()->add_edge(tvId, svId, edge);
-    }
-    else if(ins->m_name == "Comment") {
-      //undo addition of comment
-      m_comments.pop_back();
-    }
-    else if(ins->m_name == "QueryInstruction") {
-      //undo addition of query and restore the previous one if any
-      QueryInstruction* q = static_cast<QueryInstruction*>(ins);
-      m_query = q->m_query;
-      q->m_query.clear();
-    }
-    else if(ins->m_name == "AddRegion") {
-      AddRegion* add = static_cast<AddRegion*>(ins);
-
-      for(vector<RegionModel*>::iterator i = m_regions.begin();
-          i != m_regions.end(); i++) {
-        if(*add->m_regionModel == **i) {
-          m_regions.erase(i);
-          break;
-        }
-      }
-    }
-    else if(ins->m_name == "RemoveRegion") {
-      RemoveRegion* rmv = static_cast<RemoveRegion*>(ins);
-      m_regions.push_back(rmv->m_regionModel);
+      case Nothing:
+        break;
     }
   }
-  //rebuild map model since graph may have changed
-  m_mapModel->Build();
+  //update map model since graph may have changed
+  m_mapModel->RefreshMap();
   m_mapModel->SetRenderMode(SOLID_MODE);
 }
 
@@ -665,46 +1026,115 @@ BuildBackward() {
 void
 DebugModel::
 DrawRender() {
-  typedef vector<CfgModel>::iterator CIT;
-  typedef vector<EdgeModel>::iterator EIT;
   typedef vector<RegionModel*>::iterator RIT;
 
-  //update the map model in either the forward or backward direction
-  //depending on the indices of the previous and current frames
-  //(do nothing if the indices are the same)
-  if(m_index > m_prevIndex)
-    BuildForward();
-  else if(m_index < m_prevIndex)
-    BuildBackward();
+  //update the map model to the current frame, from the previous frame or
+  //from a keyframe (do nothing if the indices are the same)
+  if(m_index != m_prevIndex)
+    Seek();
+
+  //the temporaries only change with the frame
+  if(m_index != m_prevIndex || m_tempShape != CfgModel::GetShape())
+    m_tempArraysStale = true;
 
   //update the index of the previous frame
   m_prevIndex = m_index;
 
   if(m_index) {
     m_mapModel->DrawRender();
-    for(CIT cit = m_tempCfgs.begin(); cit!=m_tempCfgs.end(); cit++)
-      cit->DrawRender();
-    for(EIT eit = m_tempEdges.begin(); eit!=m_tempEdges.end(); eit++)
-      eit->DrawRender();
-    for(EIT eit = m_query.begin(); eit!=m_query.end(); eit++) {
-      glLineWidth(32);
-      eit->SetColor(Color4(1, 1, 0, 1));
-      eit->DrawRender();
+    if(m_tempArraysStale)
+      BuildTempArrays();
+
+    //temporary cfgs are black if valid and red if not
+    if(m_tempShape == CfgModel::Robot)
+      for(auto& r : m_tempRobots) {
+        shared_ptr<ActiveMultiBodyModel> robot =
+            GetVizmo().GetEnv()->GetRobot(r.first);
+        robot->SetRenderMode(SOLID_MODE);
+        robot->DrawRenderInstances(r.second.m_transforms.data(),
+            r.second.m_colors.size(), r.second.m_colors.data());
+      }
+
+    glDisable(GL_LIGHTING);
+    glEnableClientState(GL_VERTEX_ARRAY);
+    if(m_tempShape == CfgModel::Point) {
+      glPointSize(CfgModel::GetPointSize());
+      glColor4f(0, 0, 0, 0.25);
+      glVertexPointer(3, GL_FLOAT, 0, m_validTempPoints.data());
+      glDrawArrays(GL_POINTS, 0, m_validTempPoints.size() / 3);
+      glColor4f(1, 0, 0, 1);
+      glVertexPointer(3, GL_FLOAT, 0, m_invalidTempPoints.data());
+      glDrawArrays(GL_POINTS, 0, m_invalidTempPoints.size() / 3);
     }
+    glLineWidth(EdgeModel::m_edgeThickness);
+    glColor4f(0, 0, 0, 1);
+    glVertexPointer(3, GL_FLOAT, 0, m_tempLines.data());
+    glDrawArrays(GL_LINES, 0, m_tempLines.size() / 3);
+    glLineWidth(32);
+    glColor4f(1, 1, 0, 1);
+    glVertexPointer(3, GL_FLOAT, 0, m_queryLines.data());
+    glDrawArrays(GL_LINES, 0, m_queryLines.size() / 3);
+    glDisableClientState(GL_VERTEX_ARRAY);
+
     for(RIT rit = m_regions.begin(); rit!=m_regions.end(); rit++) {
       (*rit)->DrawRender();
     }
-    if(m_tempRay != NULL && m_tempCfgs.size() > 0) {
-      EdgeModel edge;
-      CfgModel ray = *m_tempRay;
-      CfgModel* tmp = &(m_tempCfgs.back());
-      for(int i=0; i<3; i++)
-        ray[i]+= (*tmp)[i];
-      edge.Set(0, tmp, &ray);
-      edge.SetColor(Color4(1, 1, 0, 1));
+    if(m_hasTempRay && m_tempCfgs.size() > 0) {
+      const GLfloat* tmp = m_tempCfgs.GetPoint(m_tempCfgs.size() - 1);
       glLineWidth(8);
-      edge.DrawRender();
+      glColor4f(1, 1, 0, 1);
+      glBegin(GL_LINES);
+      glVertex3fv(tmp);
+      glVertex3f(tmp[0] + m_tempRay[0], tmp[1] + m_tempRay[1],
+          tmp[2] + m_tempRay[2]);
+      glEnd();
+    }
+    glEnable(GL_LIGHTING);
+  }
+}
+
+
+void
+DebugModel::
+BuildTempArrays() {
+  m_tempArraysStale = false;
+  m_tempShape = CfgModel::GetShape();
+  m_validTempPoints.clear();
+  m_invalidTempPoints.clear();
+  m_tempRobots.clear();
+  m_tempLines.clear();
+  m_queryLines.clear();
+
+  vector<double> cfg;
+  for(size_t i = 0; i < m_tempCfgs.size(); ++i) {
+    bool valid = m_tempCfgs.IsValid(i);
+    if(m_tempShape == CfgModel::Point) {
+      vector<GLfloat>& points = valid ? m_validTempPoints : m_invalidTempPoints;
+      points.insert(points.end(), m_tempCfgs.GetPoint(i),
+          m_tempCfgs.GetPoint(i) + 3);
+      continue;
     }
+    size_t r = m_tempCfgs.GetRobotIndex(i);
+    shared_ptr<ActiveMultiBodyModel> robot = GetVizmo().GetEnv()->GetRobot(r);
+    cfg.assign(m_tempCfgs.GetData(i),
+        m_tempCfgs.GetData(i) + m_tempCfgs.GetDOF(i));
+    robot->ConfigureRender(cfg);
+    robot->GetRenderTransforms(m_tempRobots[r].m_transforms);
+    m_tempRobots[r].m_colors.push_back(valid ? Color4(0, 0, 0, 0.25) :
+        Color4(1, 0, 0, 1));
+  }
+
+  for(size_t i = 0; i + 1 < m_tempEdges.size(); i += 2) {
+    m_tempLines.insert(m_tempLines.end(), m_tempEdges.GetPoint(i),
+        m_tempEdges.GetPoint(i) + 3);
+    m_tempLines.insert(m_tempLines.end(), m_tempEdges.GetPoint(i + 1),
+        m_tempEdges.GetPoint(i + 1) + 3);
+  }
+  for(size_t i = 0; i + 1 < m_query.size(); i += 2) {
+    m_queryLines.insert(m_queryLines.end(), m_query.GetPoint(i),
+        m_query.GetPoint(i) + 3);
+    m_queryLines.insert(m_queryLines.end(), m_query.GetPoint(i + 1),
+        m_query.GetPoint(i + 1) + 3);
   }
 }
 
@@ -713,7 +1143,7 @@ void
 DebugModel::
 Print(ostream& _os) const {
   _os << Name() << ": " << GetFilename() << endl
-    << m_instructions.size() << " debug frames" << endl;
+    << m_size << " debug frames" << endl;
 }
 
 
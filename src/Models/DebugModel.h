@@ -1,6 +1,12 @@
 #ifndef DEBUG_MODEL_H_
 #define DEBUG_MODEL_H_
 
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <unordered_map>
+
+#include "CfgArray.h"
 #include "CfgModel.h"
 #include "MapModel.h"
 #include "Model.h"
@@ -11,154 +17,57 @@ class RegionModel;
 /// \brief   Describes a set of instructions for use by the debug model.
 /// \details Instructions capture the actions of a planner in sequence, and are
 ///          used to replay the sequence of events that occur during a given
-///          execution.
+///          execution. They are decoded from the debug file on demand into a
+///          compact form which refers to the pools of the window that decoded
+///          it.
 ////////////////////////////////////////////////////////////////////////////////
 namespace DebugInstructions {
 
   //////////////////////////////////////////////////////////////////////////////
-  /// \brief Base class for debug instructions.
-  //////////////////////////////////////////////////////////////////////////////
-  struct Instruction {
-    Instruction(const string& _name = "default") : m_name(_name) {}
-    virtual ~Instruction() {}
-    string m_name;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Adds a node to the debug map model.
-  //////////////////////////////////////////////////////////////////////////////
-  struct AddNode : public Instruction {
-    AddNode(const CfgModel& _c) : Instruction("AddNode"), m_cfg(_c) {}
-    CfgModel m_cfg;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Adds an edge to the debug map model.
-  //////////////////////////////////////////////////////////////////////////////
-  struct AddEdge : public Instruction {
-    AddEdge(const CfgModel& _s, const CfgModel& _t) : Instruction("AddEdge"),
-        m_source(_s), m_target(_t) {}
-    Color4 m_targetColor, m_sourceColor;
-    CfgModel m_source, m_target;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Adds a temporary Cfg in the scene of either red or black color.
-  //////////////////////////////////////////////////////////////////////////////
-  struct AddTempCfg : public Instruction {
-    AddTempCfg(const CfgModel& _c, bool _v) : Instruction("AddTempCfg"),
-        m_cfg(_c), m_valid(_v) {}
-    CfgModel m_cfg;
-    bool m_valid;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Adds a directional ray from the previous temporary Cfg.
-  //////////////////////////////////////////////////////////////////////////////
-  struct AddTempRay : public Instruction {
-    AddTempRay(const CfgModel& _c) : Instruction("AddTempRay"), m_cfg(_c) {}
-    CfgModel m_cfg;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Adds a tempory edge in the scene.
-  //////////////////////////////////////////////////////////////////////////////
-  struct AddTempEdge : public Instruction {
-    AddTempEdge(const CfgModel& _s, const CfgModel& _t) :
-        Instruction("AddTempEdge"), m_source(_s), m_target(_t) {}
-    CfgModel m_source, m_target;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Removes the last temporary instruction called.
-  //////////////////////////////////////////////////////////////////////////////
-  struct ClearLastTemp : public Instruction {
-    ClearLastTemp() : Instruction("ClearLastTemp"), m_tempRay(NULL) {}
-    CfgModel* m_tempRay;
-    vector<CfgModel> m_lastTempCfgs;
-    vector<EdgeModel> m_lastTempEdges;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Removes all temporaries and comments.
-  //////////////////////////////////////////////////////////////////////////////
-  struct ClearAll : public Instruction {
-    ClearAll() : Instruction("ClearAll"), m_tempRay(NULL) {}
-    CfgModel* m_tempRay;
-    vector<CfgModel> m_tempCfgs;
-    vector<EdgeModel> m_tempEdges;
-    vector<EdgeModel> m_query;
-    vector<string> m_comments;
-    vector<RegionModel*> m_regions;
-  };
-
+  /// \brief The kinds of debug instructions.
   //////////////////////////////////////////////////////////////////////////////
-  /// \brief Removes all comments.
-  //////////////////////////////////////////////////////////////////////////////
-  struct ClearComments : public Instruction {
-    ClearComments() : Instruction("ClearComments") {}
-    vector<string> m_comments;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Removes a node from the debug map model.
-  //////////////////////////////////////////////////////////////////////////////
-  struct RemoveNode : public Instruction {
-    RemoveNode(const CfgModel& _c) : Instruction("RemoveNode"), m_cfg(_c) {}
-    CfgModel m_cfg;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Removes an edge from the debug map model.
-  //////////////////////////////////////////////////////////////////////////////
-  struct RemoveEdge : public Instruction {
-    RemoveEdge(const CfgModel& _s, const CfgModel& _t) :
-        Instruction("RemoveEdge"), m_edgeNum(-1), m_source(_s), m_target(_t) {}
-    int m_edgeNum;
-    CfgModel m_source, m_target;
+  enum Type : uint8_t {
+    Nothing,          ///< No change, as in the initial frame.
+    AddNode,          ///< Adds a node to the debug map model.
+    AddEdge,          ///< Adds an edge to the debug map model.
+    AddTempCfg,       ///< Adds a temporary cfg, black if valid or red if not.
+    AddTempRay,       ///< Adds a ray from the last temporary cfg.
+    AddTempEdge,      ///< Adds a temporary edge in the scene.
+    ClearLastTemp,    ///< Removes the last temporary cfg, edge, and ray.
+    ClearAll,         ///< Removes all temporaries, queries, and comments.
+    ClearComments,    ///< Removes all comments.
+    RemoveNode,       ///< Removes a node from the debug map model.
+    RemoveEdge,       ///< Removes an edge from the debug map model.
+    Comment,          ///< Adds a comment to the text box in the window.
+    QueryInstruction, ///< Highlights a path in the scene if one can be found.
+    AddRegion,        ///< Adds a user-guidance region to the scene.
+    RemoveRegion      ///< Removes a user-guidance region from the scene.
   };
 
   //////////////////////////////////////////////////////////////////////////////
-  /// \brief Adds a string comment to the text box in the window.
+  /// \brief A decoded debug instruction.
   //////////////////////////////////////////////////////////////////////////////
-  struct Comment : public Instruction {
-    Comment(const string& _s) : Instruction("Comment"), m_comment(_s) {}
-    string m_comment;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Highlights a path in the scene if one can be found.
-  //////////////////////////////////////////////////////////////////////////////
-  struct QueryInstruction : public Instruction {
-    QueryInstruction(const CfgModel& _s, const CfgModel& _t) :
-        Instruction("QueryInstruction"), m_source(_s), m_target(_t) {}
-    CfgModel m_source, m_target;
-    vector<EdgeModel> m_query;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Adds a user-guidance region to the scene.
-  //////////////////////////////////////////////////////////////////////////////
-  struct AddRegion : public Instruction {
-    AddRegion(RegionModel* _mod) : Instruction("AddRegion"),
-        m_regionModel(_mod) {}
-    RegionModel* m_regionModel;
-  };
-
-  //////////////////////////////////////////////////////////////////////////////
-  /// \brief Removes a user-guidance region to the scene.
-  //////////////////////////////////////////////////////////////////////////////
-  struct RemoveRegion : public Instruction {
-    RemoveRegion(RegionModel* _mod) : Instruction("RemoveRegion"),
-        m_regionModel(_mod) {}
-    RegionModel* m_regionModel;
+  struct Instruction {
+    Type m_type{Nothing};  ///< What the instruction does.
+    bool m_valid{false};   ///< For AddTempCfg, is the cfg valid?
+    uint32_t m_text{0};    ///< For comments and regions, the text pool entry.
+    uint32_t m_cfgs[2]{0, 0}; ///< The positions of the cfgs in the window,
+                              ///< source first for edges and queries.
   };
 }
 
+namespace TextParser {class MappedFile;}
 
 ////////////////////////////////////////////////////////////////////////////////
-/// \brief Stores a map model and temporary vectors of objects to display the
-///        debug at any given frame.
+/// \brief   Stores a map model and temporary vectors of objects to display the
+///          debug at any given frame.
+/// \details Loading only indexes the file: the offset of every \c blockSize-th
+///          instruction is kept, and one block at a time is decoded while
+///          frames are replayed. State that replaying forward overwrites is
+///          kept on undo stacks for replaying backward. Snapshots of the
+///          roadmap and scene (keyframes) are taken at regular intervals
+///          during load, so that a seek restores the closest keyframe and
+///          replays only the instructions after it.
 ////////////////////////////////////////////////////////////////////////////////
 class DebugModel : public LoadableModel {
 
@@ -167,10 +76,16 @@ class DebugModel : public LoadableModel {
     typedef MapModel<CfgModel, EdgeModel> MM;
 
     // Construction
-    DebugModel(const string& _filename);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \param[in] _filename The debug file.
+    /// \param[in] _keyframeBudget The memory, in bytes, which keyframes may
+    ///                            use. Keyframes are spaced further apart
+    ///                            until they fit.
+    DebugModel(const string& _filename,
+        size_t _keyframeBudget = size_t(256) << 20);
     ~DebugModel();
 
-    size_t GetSize() {return m_instructions.size();}
+    size_t GetSize() {return m_size;}
     vector<string> GetComments();
     MM* GetMapModel() {return m_mapModel;}
 
@@ -189,8 +104,184 @@ class DebugModel : public LoadableModel {
 
   private:
 
-    //instructions
-    vector<DebugInstructions::Instruction*> m_instructions;
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Temporary scene objects. Kept on the undo stack when a clear
+    ///        removes them or a query replaces them, and in keyframes.
+    struct Scene {
+      bool m_hasTempRay{false};
+      CfgModel m_tempRay;
+      CfgArray m_tempCfgs;
+      CfgArray m_tempEdges, m_query; ///< Edges as source and target pairs.
+      vector<string> m_comments;
+      vector<RegionModel*> m_regions;
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief An edge of the roadmap saved in a keyframe.
+    struct KeyEdge {
+      size_t m_source, m_target; ///< The edge VIDs.
+      size_t m_id;               ///< The edge ID.
+      Color4 m_color;            ///< The edge color.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief The full replay state after a given frame.
+    struct Keyframe {
+      size_t m_index{0};             ///< The frame index.
+      vector<size_t> m_vids;         ///< The vertex VIDs.
+      CfgArray m_cfgs;               ///< The vertex cfgs.
+      vector<Color4> m_colors;       ///< The vertex colors.
+      vector<KeyEdge> m_edges;       ///< The directed edges.
+      int m_edgeNum{0};              ///< The next edge ID.
+      Scene m_scene;                 ///< The temporary objects.
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Estimate the memory used by this keyframe.
+      size_t Bytes() const;
+    };
+
+    ///\name Instruction Access
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get an instruction, decoding its block if needed. The reference
+    ///        is valid until the next call.
+    /// \param[in] _i The instruction index, where 0 is the initial frame.
+    const DebugInstructions::Instruction& GetInstruction(size_t _i);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Build one of the cfgs of an instruction in the current window.
+    CfgModel GetCfg(const DebugInstructions::Instruction& _ins, size_t _n)
+        const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the region of a region instruction in the current window,
+    ///        making it on first use.
+    RegionModel* GetRegion(size_t _i,
+        const DebugInstructions::Instruction& _ins);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Decode a block of instructions into the window.
+    void Decode(size_t _block);
+
+    ///@}
+    ///\name Instruction Index
+    ///@{
+
+    static const size_t m_blockSize = 1024;  ///< Instructions per block.
+
+    unique_ptr<TextParser::MappedFile> m_file; ///< The mapped debug file.
+    vector<size_t> m_blocks;     ///< File offset of each block's first line.
+    size_t m_size{1};            ///< Number of frames, with the initial one.
+
+    ///@}
+    ///\name Decoded Window
+    ///@{
+
+    size_t m_block{size_t(-1)};  ///< The block in the window.
+    vector<DebugInstructions::Instruction> m_window; ///< The block's instructions.
+    CfgArray m_cfgs;             ///< The cfgs of the window.
+    vector<string> m_text;       ///< Comments and region lines of the window.
+    unordered_map<size_t, RegionModel*> m_regionModels; ///< Regions made so far.
+
+    ///@}
+    ///\name Keyframes
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Replay the whole file, taking a keyframe every
+    ///        \c m_keyframeSpacing frames. Whenever the keyframes outgrow the
+    ///        budget, every other one is dropped and the spacing doubles.
+    void BuildKeyframes();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Save the current replay state as a keyframe.
+    void Capture(Keyframe& _key);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Replace the replay state with a keyframe. The undo stacks are
+    ///        emptied, so replaying backward stops at the keyframe.
+    void Restore(const Keyframe& _key);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Bring the replay state from the previous frame to the current
+    ///        one, starting from the closest keyframe when that replays fewer
+    ///        instructions.
+    void Seek();
+
+    vector<Keyframe> m_keyframes;  ///< Keyframes by frame index, from frame 0.
+    size_t m_keyframeBudget;       ///< Memory keyframes may use, in bytes.
+    size_t m_keyframeSpacing{4 * m_blockSize}; ///< Frames between keyframes.
+    size_t m_undoBase{0};          ///< Earliest frame the undo stacks reach.
+
+    ///@}
+    ///\name Undo Stacks
+    ///@{
+
+    vector<pair<Color4, Color4>> m_edgeColors; ///< Source and target CC colors
+                                               ///< before each AddEdge.
+    vector<int> m_removedEdges;  ///< IDs of edges taken out by RemoveEdge.
+    vector<Scene> m_cleared;     ///< State taken out by clears and queries.
+
+    ///@}
+    ///\name CC Tracking
+    ///@{
+    /// The members of each CC, so that an AddEdge finds the CCs it joins and
+    /// recolors the smaller one without searching the graph. Removals can
+    /// split CCs, so they drop the tracking and the next AddEdge rebuilds it.
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief How an AddEdge joined two CCs, for undoing it.
+    struct CCMerge {
+      size_t m_into; ///< The CC which took in the other one.
+      size_t m_from; ///< The CC which was taken in, or m_into if the edge
+                     ///< was inside one CC.
+      size_t m_size; ///< The size of m_into before the merge.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Rebuild the CC members from the graph if they were dropped.
+    void TrackCCs();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Drop the CC members, e.g. after a removal.
+    void DropCCs();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Color the members of a CC from one on, and their edges.
+    void ColorCC(size_t _cc, size_t _first, const Color4& _c);
+
+    bool m_ccsTracked{false};              ///< Are the CC members current?
+    unordered_map<MM::VID, size_t> m_ccOf; ///< The CC of each vertex.
+    vector<vector<MM::VID>> m_ccMembers;   ///< The vertices of each CC.
+    vector<CCMerge> m_ccMerges;            ///< Undo stack of AddEdge merges.
+
+    ///@}
+    ///\name Temporaries Drawing
+    ///@{
+    /// Vertex arrays and robot transforms of the temporary cfgs and edges,
+    /// rebuilt only when the frame or the cfg shape changes.
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Rebuild the arrays from the temporary and query CfgArrays.
+    void BuildTempArrays();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Robot transforms and colors of the temporary cfgs of a robot.
+    struct TempRobots {
+      vector<GLfloat> m_transforms; ///< Body transforms of each cfg.
+      vector<Color4> m_colors;      ///< Color of each cfg.
+    };
+
+    bool m_tempArraysStale{true};     ///< Must the arrays be rebuilt?
+    CfgModel::Shape m_tempShape{CfgModel::Point}; ///< Shape they were built for.
+    vector<GLfloat> m_validTempPoints;   ///< Valid temporary cfg positions.
+    vector<GLfloat> m_invalidTempPoints; ///< Invalid temporary cfg positions.
+    map<size_t, TempRobots> m_tempRobots; ///< Robot mode instances by robot.
+    vector<GLfloat> m_tempLines;      ///< Temporary edge segments.
+    vector<GLfloat> m_queryLines;     ///< Query edge segments.
+
+    ///@}
 
     //indices for frame construction
     int m_index;
@@ -199,9 +290,10 @@ class DebugModel : public LoadableModel {
     //debug model components
     MM* m_mapModel;
     int m_edgeNum;
-    vector<CfgModel> m_tempCfgs;
-    vector<EdgeModel> m_tempEdges, m_query;
-    CfgModel* m_tempRay;
+    CfgArray m_tempCfgs;
+    CfgArray m_tempEdges, m_query; //edges as source and target pairs
+    bool m_hasTempRay{false};
+    CfgModel m_tempRay;
     vector<string> m_comments;
     vector<RegionModel*> m_regions;
 };
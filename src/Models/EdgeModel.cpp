@@ -2,8 +2,10 @@
 
 #include <limits.h>
 #include <cstdlib>
+#include <sstream>
 
 #include "CfgModel.h"
+#include "Utilities/TextParser.h"
 
 double EdgeModel::m_edgeThickness = 1;
 
@@ -59,6 +61,30 @@ RecalculateEdges(CfgModel _c) {
 #endif
 }
 
+bool
+EdgeModel::
+Parse(const char*& _p, const char* _end) {
+#ifdef PMPCfg
+  //The number of intermediates, each intermediate cfg, then the weight
+  size_t numIntermediates;
+  if(!TextParser::ParseUnsigned(_p, _end, numIntermediates))
+    return false;
+  vector<CfgModel>& intermediates = GetIntermediates();
+  intermediates.resize(numIntermediates);
+  for(auto& c : intermediates)
+    if(!c.Parse(_p, _end))
+      return false;
+  return TextParser::ParseDouble(_p, _end, GetWeight());
+#else
+  //Other edge types keep their own text layout
+  istringstream iss(string(_p, _end));
+  if(!(iss >> *this))
+    return false;
+  _p = iss.eof() ? _end : _p + size_t(iss.tellg());
+  return true;
+#endif
+}
+
 void
 EdgeModel::
 DrawRender() {
@@ -149,16 +175,3 @@ Print(ostream& _os) const {
   if(!m_isValid)
     _os << "**** Invalid! ****" << endl;
 }
-
-void
-EdgeModel::
-DrawRenderInCC() {
-  glVertex3dv(m_startCfg->GetPoint());
-
-  for(size_t i = 0; i < m_intermediates.size(); ++i) {
-    glVertex3dv(m_intermediates[i].GetPoint());
-    glVertex3dv(m_intermediates[i].GetPoint());
-  }
-
-  glVertex3dv(m_endCfg->GetPoint());
-}
@@ -61,6 +61,13 @@ class EdgeModel : public Model, public EdgeType {
     // \param[in] _c A configuration in the edge
     void RecalculateEdges(CfgModel _c);
     ////////////////////////////////////////////////////////////////////////////
+    /// \brief Read this edge's weight from text in the layout written by
+    ///        operator<<, without going through a stream.
+    /// \param[in,out] _p The text position, advanced past the weight.
+    /// \param[in] _end The end of the text.
+    /// \return False if the text does not hold a weight.
+    bool Parse(const char*& _p, const char* _end);
+    ////////////////////////////////////////////////////////////////////////////
     /// \brief Get the EID of this edge.
     size_t GetID() {return m_id;}
     ////////////////////////////////////////////////////////////////////////////
@@ -78,8 +85,6 @@ class EdgeModel : public Model, public EdgeType {
     void DrawSelected();
     void Print(ostream& _os) const;
 
-    void DrawRenderInCC();
-
     // Class properties
     static double m_edgeThickness; ///< Rendering thickness for edge lines.
 
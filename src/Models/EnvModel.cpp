@@ -1,12 +1,17 @@
 #include "EnvModel.h"
 
 #include <fstream>
+#include <set>
+
+#include <QtConcurrentMap>
 
 #include "Environment/BoundingBox.h"
 #include "Environment/BoundingBox2D.h"
 #include "Environment/BoundingSphere.h"
 #include "Environment/BoundingSphere2D.h"
 #include "Environment/ActiveMultiBody.h"
+#include "Environment/FixedBody.h"
+#include "Environment/FreeBody.h"
 #include "Environment/StaticMultiBody.h"
 #include "Environment/SurfaceMultiBody.h"
 
@@ -18,6 +23,7 @@
 #include "BoundingSphereModel.h"
 #include "BoundingSphere2DModel.h"
 #include "CfgModel.h"
+#include "PolyhedronModel.h"
 #include "RegionBoxModel.h"
 #include "RegionBox2DModel.h"
 #include "RegionSphereModel.h"
@@ -27,10 +33,34 @@
 #include "TempObjsModel.h"
 #include "WorkspaceDecompositionModel.h"
 #include "UserPathModel.h"
+#include "Utilities/PickBuffer.h"
 #include "Utilities/VizmoExceptions.h"
 
 /*------------------------------- Construction -------------------------------*/
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief A mesh to be loaded on the thread pool by EnvModel::LoadMeshes.
+////////////////////////////////////////////////////////////////////////////////
+struct MeshLoad {
+  string m_filename;
+  GMSPolyhedron::COMAdjust m_comAdjust;
+  shared_ptr<PolyhedronModel> m_model;
+};
+
+
+static void
+LoadMesh(MeshLoad& _load) {
+  //Failures are left for the body model to report on the GUI thread.
+  try {
+    _load.m_model.reset(new PolyhedronModel(_load.m_filename,
+          _load.m_comAdjust));
+  }
+  catch(...) {
+    _load.m_model.reset();
+  }
+}
+
+
 EnvModel::
 EnvModel(const string& _filename) : Model("Environment") {
   m_environment = new Environment();
@@ -178,6 +208,7 @@ AddAvoidRegion(RegionModelPtr _r, bool _lock) {
     lock = new QMutexLocker(&m_regionLock);
   _r->SetColor(Color4(0, 0, 0, 0.5));
   m_avoidRegions.push_back(_r);
+  AvoidRegionsChanged();
   VDAddRegion(_r.get());
   delete lock;
 }
@@ -223,6 +254,7 @@ DeleteRegion(RegionModelPtr _r) {
     rit = find(m_avoidRegions.begin(), m_avoidRegions.end(), _r);
     if(rit != m_avoidRegions.end()) {
       m_avoidRegions.erase(rit);
+      AvoidRegionsChanged();
     }
     else {
       rit = find(m_nonCommitRegions.begin(), m_nonCommitRegions.end(), _r);
@@ -279,6 +311,7 @@ LoadRegions(const string& _filename) {
   m_nonCommitRegions.clear();
   m_attractRegions.clear();
   m_avoidRegions.clear();
+  AvoidRegionsChanged();
 
   string line;
   getline(ifs,line);
@@ -429,6 +462,40 @@ AddWorkspaceDecompositionModel(const WorkspaceDecomposition* _wd) {
 }
 
 
+vector<shared_ptr<PolyhedronModel>>
+EnvModel::
+LoadMeshes() const {
+  vector<shared_ptr<Body>> bodies;
+  for(size_t i = 0; i < m_environment->NumRobots(); ++i) {
+    shared_ptr<ActiveMultiBody> robot = m_environment->GetRobot(i);
+    for(size_t j = 0; j < robot->NumFreeBody(); ++j)
+      bodies.push_back(robot->GetFreeBody(j));
+  }
+  for(size_t i = 0; i < m_environment->NumObstacles(); ++i)
+    bodies.push_back(m_environment->GetObstacle(i)->GetFixedBody(0));
+  for(size_t i = 0; i < m_environment->NumSurfaces(); ++i)
+    bodies.push_back(m_environment->GetSurface(i)->GetFixedBody(0));
+
+  //Queue each distinct mesh once
+  set<pair<string, GMSPolyhedron::COMAdjust>> queued;
+  vector<MeshLoad> loads;
+  for(auto& b : bodies) {
+    auto key = make_pair(BodyModel::MeshPath(b), b->GetCOMAdjust());
+    if(queued.insert(key).second)
+      loads.push_back(MeshLoad{key.first, key.second, nullptr});
+  }
+
+  //Parsing, normals, COM/radius, and wire edges need no GL context
+  QtConcurrent::blockingMap(loads, LoadMesh);
+
+  vector<shared_ptr<PolyhedronModel>> meshes;
+  for(auto& l : loads)
+    if(l.m_model)
+      meshes.push_back(l.m_model);
+  return meshes;
+}
+
+
 void
 EnvModel::
 Build() {
@@ -470,6 +537,9 @@ Build() {
     m_surfaces.emplace_back(
         new SurfaceMultiBodyModel(m_environment->GetSurface(i)));
 
+  //Load all meshes up front; the body models then find them in the cache
+  vector<shared_ptr<PolyhedronModel>> meshes = LoadMeshes();
+
   //Build boundary model
   if(!m_boundary)
     throw BuildException(WHERE, "Boundary is NULL");
@@ -604,32 +674,32 @@ DrawSelect() {
 
   size_t nameIndx = 0;
 
-  glPushName(EnvObjectName::Robots);
+  PickBuffer::PushName(EnvObjectName::Robots);
   for(auto& r : m_robots) {
-    glPushName(nameIndx++);
+    PickBuffer::PushName(nameIndx++);
     r->Restore();
     r->DrawSelect();
-    glPopName();
+    PickBuffer::PopName();
   }
-  glPopName();
+  PickBuffer::PopName();
 
   nameIndx = 0;
-  glPushName(EnvObjectName::Obstacles);
+  PickBuffer::PushName(EnvObjectName::Obstacles);
   for(auto& o : m_obstacles) {
-    glPushName(nameIndx++);
+    PickBuffer::PushName(nameIndx++);
     o->DrawSelect();
-    glPopName();
+    PickBuffer::PopName();
   }
-  glPopName();
+  PickBuffer::PopName();
 
   nameIndx = 0;
-  glPushName(EnvObjectName::Surfaces);
+  PickBuffer::PushName(EnvObjectName::Surfaces);
   for(auto& s : m_surfaces) {
-    glPushName(nameIndx++);
+    PickBuffer::PushName(nameIndx++);
     s->DrawSelect();
-    glPopName();
+    PickBuffer::PopName();
   }
-  glPopName();
+  PickBuffer::PopName();
 
   glEnable(GL_CULL_FACE);
   glEnable(GL_BLEND);
@@ -638,58 +708,58 @@ DrawSelect() {
     QMutexLocker lock(&m_regionLock);
 
     nameIndx = 0;
-    glPushName(EnvObjectName::AttractRegions);
+    PickBuffer::PushName(EnvObjectName::AttractRegions);
     for(auto& r : m_attractRegions) {
-      glPushName(nameIndx++);
+      PickBuffer::PushName(nameIndx++);
       r->DrawSelect();
-      glPopName();
+      PickBuffer::PopName();
     }
-    glPopName();
+    PickBuffer::PopName();
 
     nameIndx = 0;
-    glPushName(EnvObjectName::AvoidRegions);
+    PickBuffer::PushName(EnvObjectName::AvoidRegions);
     for(auto& r : m_avoidRegions) {
-      glPushName(nameIndx++);
+      PickBuffer::PushName(nameIndx++);
       r->DrawSelect();
-      glPopName();
+      PickBuffer::PopName();
     }
-    glPopName();
+    PickBuffer::PopName();
 
     nameIndx = 0;
-    glPushName(EnvObjectName::NonCommitRegions);
+    PickBuffer::PushName(EnvObjectName::NonCommitRegions);
     for(auto& r : m_nonCommitRegions) {
-      glPushName(nameIndx++);
+      PickBuffer::PushName(nameIndx++);
       r->DrawSelect();
-      glPopName();
+      PickBuffer::PopName();
     }
-    glPopName();
+    PickBuffer::PopName();
   }
 
   nameIndx = 0;
-  glPushName(EnvObjectName::UserPaths);
+  PickBuffer::PushName(EnvObjectName::UserPaths);
   for(auto& p : m_userPaths) {
-    glPushName(nameIndx++);
+    PickBuffer::PushName(nameIndx++);
     p->DrawSelect();
-    glPopName();
+    PickBuffer::PopName();
   }
-  glPopName();
+  PickBuffer::PopName();
   glDepthMask(GL_TRUE);
   glDisable(GL_BLEND);
   glDisable(GL_CULL_FACE);
 
-  glPushName(EnvObjectName::Decomposition);
+  PickBuffer::PushName(EnvObjectName::Decomposition);
   if(m_decompositionModel)
     m_decompositionModel->DrawSelect();
-  glPopName();
+  PickBuffer::PopName();
 
-  glPushName(EnvObjectName::Graph);
+  PickBuffer::PushName(EnvObjectName::Graph);
   if(m_graphModel)
     m_graphModel->DrawSelect();
-  glPopName();
+  PickBuffer::PopName();
 
-  glPushName(EnvObjectName::BoundaryObj);
+  PickBuffer::PushName(EnvObjectName::BoundaryObj);
   m_boundary->DrawSelect();
-  glPopName();
+  PickBuffer::PopName();
 }
 
 
@@ -1,6 +1,8 @@
 #ifndef ENV_MODEL_H_
 #define ENV_MODEL_H_
 
+#include <atomic>
+
 #include <QMutex>
 #include <QMutexLocker>
 
@@ -16,6 +18,7 @@ class ActiveMultiBodyModel;
 class AvatarModel;
 class BoundaryModel;
 class CfgModel;
+class PolyhedronModel;
 class StaticMultiBodyModel;
 class SurfaceMultiBodyModel;
 class TempObjsModel;
@@ -132,6 +135,13 @@ class EnvModel : public Model {
       return m_nonCommitRegions;
     }
     ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get a counter which changes whenever an avoid region is added,
+    ///        removed, or moved.
+    size_t GetAvoidRegionVersion() const {return m_avoidVersion;}
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Note that the avoid regions have changed, e.g. after moving one.
+    void AvoidRegionsChanged() {++m_avoidVersion;}
+    ////////////////////////////////////////////////////////////////////////////
     /// \brief Add a new attract region.
     void AddAttractRegion(RegionModelPtr _r, bool _lock = true);
     ////////////////////////////////////////////////////////////////////////////
@@ -215,6 +225,13 @@ class EnvModel : public Model {
 
   private:
 
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Load the mesh of every body on the thread pool, ahead of
+    ///        building the body models on the GUI thread.
+    /// \return Models holding the meshes in the PolyhedronModel cache. Keep
+    ///         them until the body models are built.
+    vector<shared_ptr<PolyhedronModel>> LoadMeshes() const;
+
     vector<shared_ptr<ActiveMultiBodyModel>> m_robots;    ///< All robots.
     vector<shared_ptr<StaticMultiBodyModel>> m_obstacles; ///< All obstacles.
     vector<shared_ptr<SurfaceMultiBodyModel>> m_surfaces; ///< All surfaces.
@@ -230,6 +247,7 @@ class EnvModel : public Model {
     vector<RegionModelPtr> m_avoidRegions;     ///< Avoid regions.
     vector<RegionModelPtr> m_nonCommitRegions; ///< Non-commit regions.
     mutable QMutex m_regionLock;               ///< Region Lock
+    atomic<size_t> m_avoidVersion{0};          ///< Avoid region changes.
 
     vector<UserPathModel*> m_userPaths;        ///< User paths.
     vector<TempObjsModel*> m_tempObjs;         ///< Temporary objects.
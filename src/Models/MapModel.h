@@ -7,11 +7,28 @@
 #include <containers/sequential/graph/algorithms/connected_components.h>
 #include <containers/sequential/graph/algorithms/graph_input_output.h>
 
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <map>
+#include <memory>
+#include <set>
+#include <unordered_map>
+#include <unordered_set>
+
 #include <QMutex>
 #include <QMutexLocker>
 
 #include "CCModel.h"
+#include "Utilities/BinaryRoadmap.h"
+#include "Utilities/Frustum.h"
+#include "Utilities/GLUtils.h"
 #include "Utilities/IO.h"
+#include "Utilities/ParseProgress.h"
+#include "Utilities/PickBox.h"
+#include "Utilities/SpatialIndex.h"
+#include "Utilities/TextParser.h"
 
 struct EdgeAccess {
   typedef double value_type;
@@ -30,7 +47,7 @@ class MapModel : public LoadableModel {
 
   public:
     typedef CCModel<CFG, WEIGHT> CCM;
-    typedef typename vector<CCM*>::iterator CCIT;
+    typedef typename vector<shared_ptr<CCM>>::iterator CCIT;
     typedef RoadmapGraph<CFG, WEIGHT> RGraph;
     typedef typename RGraph::GRAPH  Graph;
     typedef typename Graph::vertex_descriptor VID;
@@ -50,21 +67,80 @@ class MapModel : public LoadableModel {
     void SetEnvFileName(const string& _name) {m_envFileName = _name;}
     RGraph* GetGraph() {return m_graph;}
 
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Find the vertex holding a configuration through the Cfg2VID
+    ///        index. Vertices changed behind the index's back are not found;
+    ///        move them with MoveVertex instead.
+    /// \param[in] _target The configuration to look for.
+    /// \return The VID of the matching vertex, or -1 if there is none.
     VID Cfg2VID(const CFG& _target);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Set the grid size used to hash configurations for Cfg2VID,
+    ///        normally the environment's position resolution.
+    void SetIndexResolution(double _res);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Find the nodes whose workspace positions are closest to a point.
+    /// \param[in] _p The query point.
+    /// \param[in] _k The number of nodes to find.
+    /// \return The node VIDs, nearest first.
+    vector<VID> Nearest(const Point3d& _p, size_t _k);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Find the nodes and edges whose workspace positions touch a box.
+    ///        Call RefreshMap first so that recent changes are indexed.
+    /// \param[in] _min The box minimum.
+    /// \param[in] _max The box maximum.
+    /// \return The node VIDs as (v, v) and the edges as (source, target).
+    vector<pair<VID, VID>> Overlapping(const Point3d& _min,
+        const Point3d& _max);
 
     //Load functions
     //Moving generic load functions to virtual in Model.h
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Write the roadmap, in the binary format if the file name ends in
+    ///        .bmap and as a text .map otherwise.
     void Write(const string& _filename);
-    virtual void ParseFile();
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Read the roadmap from a text .map or a binary roadmap file.
+    virtual void ParseFile() {ParseFile(nullptr);}
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Read the roadmap in chunks, reporting progress after each one.
+    ///        Text lines are parsed on the thread pool and added to the graph
+    ///        in order on the calling thread. This may run on a worker thread
+    ///        as long as nothing else touches the graph until it returns; call
+    ///        Build afterwards.
+    /// \param[in] _progress Progress to report to and cancellation flag to
+    ///                      check, or null.
+    /// \throws ParseException if the file is malformed or the parse is
+    ///         canceled.
+    void ParseFile(ParseProgress* _progress);
 
     //Display fuctions
     virtual void SetRenderMode(RenderMode _mode); //Wire, solid, or invisible
     virtual void GetChildren(list<Model*>& _models);
 
     void Build();
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Select the node or edge of a pick name. Names from before the
+    ///        CC models last changed, or naming no CC, select nothing.
     void Select(GLuint* _index, vector<Model*>& _sel);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Select the visible nodes and edges under a window rectangle
+    ///        without drawing the roadmap.
+    /// \param[in] _box The rectangle in window coordinates.
+    /// \param[in] _all Select everything in the rectangle (true) or only the
+    ///                 item closest to the camera along the ray through its
+    ///                 center (false).
+    /// \param[out] _sel The selected models.
+    void Select(const Box& _box, bool _all, vector<Model*>& _sel);
     void DrawRender();
-    void DrawSelect();
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Nothing is drawn for picking. Drawing a pick ID per node and
+    ///        edge costs far more than the spatial index queries of
+    ///        Select(Box), which answers roadmap picks instead. The version
+    ///        is still noted so that Select(GLuint*) can reject stale names.
+    void DrawSelect() {m_pickVersion = GetVersion();}
     void DrawSelected() {}
     void Print(ostream& _os) const;
     void SetColor(const Color4& _c);
@@ -76,17 +152,201 @@ class MapModel : public LoadableModel {
     //and edges.
     void RefreshMap(bool lock = true);
 
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Delete a vertex from the graph and record the change for the
+    ///        next RefreshMap. Deleting through the graph directly forces
+    ///        the next refresh to rebuild every CC.
+    void DeleteVertex(VID _v);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Delete an edge from the graph and record the change for the
+    ///        next RefreshMap.
+    void DeleteEdge(VID _source, VID _target);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Add a vertex to the graph and the Cfg2VID index, unless an
+    ///        equal one is already there.
+    /// \return The VID of the new or existing vertex.
+    VID AddVertex(const CFG& _c);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Add an edge to the graph. Like edges added through the graph
+    ///        directly, the next RefreshMap finds it from the out-degree of
+    ///        its source vertex.
+    void AddEdge(VID _source, VID _target, const WEIGHT& _w);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Change the configuration of a vertex, keeping it in the Cfg2VID
+    ///        index and marking its CC dirty.
+    void MoveVertex(VID _v, const vector<double>& _data);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Record that the CC of a vertex must be rebuilt on the next
+    ///        RefreshMap, e.g. because the vertex or one of its edges moved.
+    void MarkDirty(VID _v);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Remove every vertex and edge, e.g. to refill the graph from a
+    ///        saved copy. The next RefreshMap rebuilds every CC.
+    void Clear();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the mutex guarding the graph and the CC models. Functions
+    ///        which change them or hand out models stored in the graph, such
+    ///        as RefreshMap, SetRenderMode, and Select, take it; DrawRender and
+    ///        GetChildren read the latest snapshot instead. It is recursive,
+    ///        so holders may still call the locking functions of this class.
     QMutex& AcquireMutex() {return m_lock;}
 
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the number of times the CC models have been rebuilt or
+    ///        updated, e.g. to tell whether CC pointers taken earlier under the
+    ///        mutex may be stale.
+    size_t GetVersion() const {return m_version.load(memory_order_acquire);}
+
   private:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Rebuild every CC model and the spatial index from the graph.
+    ///        Call with the mutex held.
+    void Rebuild();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Bring the CCs up to date with the changes made to the graph
+    ///        since the last refresh, touching only the affected CCs.
+    /// \return False if the changes could not be determined, in which case
+    ///         nothing was modified and a full Build is needed.
+    bool Update();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief The CCs as of the last publish: the CC models themselves and
+    ///        the geometry, color, and render mode of each. A snapshot is never
+    ///        modified once published, and it keeps its CC models alive after
+    ///        a refresh drops them, so DrawRender and GetChildren read it
+    ///        without the mutex while the next one is built. Robot mode draws
+    ///        from it too, posing the robot from the DOFs in the geometry.
+    ////////////////////////////////////////////////////////////////////////////
+    struct RenderSnapshot {
+      struct CC {
+        shared_ptr<CCM> m_model;  ///< The CC model.
+        shared_ptr<const typename CCM::Geometry> m_geometry; ///< Arrays.
+        Color4 m_color;          ///< CC color.
+        RenderMode m_renderMode; ///< CC render mode.
+      };
+      vector<CC> m_ccs;          ///< One entry per CC.
+      size_t m_sequence{0};      ///< Order in which snapshots were prepared.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Copy the current CC models into a new render snapshot. Only
+    ///        CCs which changed since the last call are copied. Call with the
+    ///        mutex held, and pass the result to PublishSnapshot.
+    shared_ptr<RenderSnapshot> PrepareSnapshot();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Build the LOD levels the snapshot lacks and make it the one
+    ///        DrawRender reads, unless a later one is already published. Call
+    ///        without the mutex, so the planner is not held up by the build.
+    void PublishSnapshot(shared_ptr<RenderSnapshot> _snapshot);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Read the graph from a memory-mapped binary roadmap file.
+    void ParseBinary();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief A vertex line of a text roadmap file, parsed off the graph.
+    struct VertexRecord {
+      VID m_vid;                           ///< The vertex VID.
+      CFG m_cfg;                           ///< The vertex property.
+      vector<pair<VID, WEIGHT>> m_edges;   ///< The outgoing edges.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Write the graph as a binary roadmap file.
+    void WriteBinary(const string& _filename);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Record the graph state that the next Update will compare with.
+    /// \param[in] _lastVID The largest VID currently in the graph.
+    void ResetChanges(VID _lastVID);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Compute the Cfg2VID index key of a configuration: its DOFs
+    ///        quantized at the index resolution and hashed.
+    size_t CfgKey(const CFG& _c) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Compute the keys under which a configuration equal to this one
+    ///        may be indexed: its own, and those of the neighboring cells of
+    ///        every DOF within m_indexSlack of a cell boundary.
+    /// \param[out] _keys The keys, starting with CfgKey(_c).
+    /// \return False if more than m_maxProbedDofs DOFs are near a boundary,
+    ///         in which case only CfgKey(_c) is given and an equal
+    ///         configuration may be indexed under a key that is not listed.
+    bool CfgKeys(const CFG& _c, vector<size_t>& _keys) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Remove a vertex from the Cfg2VID index.
+    void UnindexVertex(VI _vi);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Add the vertices created since the last call to the Cfg2VID
+    ///        index.
+    void IndexVertices();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the address of the first vertex property, which changes
+    ///        whenever the graph reallocates or shifts its vertex storage.
+    const CFG* StorageAddress();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Re-index the positions of some vertices and of the edges
+    ///        touching them. Deleted vertices are dropped from the index.
+    void IndexGeometry(const vector<VID>& _vids);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Add an edge's line segments to the spatial index.
+    void IndexEdge(VI _v, EI _ei);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Add the model for a node or edge to a selection if its CC is
+    ///        visible and selectable.
+    void SelectKey(const SpatialIndex::Key& _key, vector<Model*>& _sel);
+
     string m_envFileName;
 
-    vector<CCM*> m_ccModels;
+    vector<shared_ptr<CCM>> m_ccModels; ///< Shared with the render snapshots.
     RGraph* m_graph;
 
     bool m_delGraph;
 
-    mutable QMutex m_lock;
+    mutable QMutex m_lock{QMutex::Recursive};
+    atomic<size_t> m_version{0}; ///< Count of CC model rewrites.
+    shared_ptr<const RenderSnapshot> m_snapshot; ///< Use atomic_load/store.
+    size_t m_snapshotSequence{0}; ///< Snapshots prepared, under the mutex.
+    size_t m_pickVersion{size_t(-1)}; ///< m_version of the last pick pass.
+
+    ///\name Change Tracking
+    ///@{
+
+    VID m_lastVID{VID(-1)};      ///< Largest VID at the last refresh.
+    size_t m_numVertices{0};     ///< Number of vertices at the last refresh.
+    size_t m_deletedVertices{0}; ///< Vertices deleted since the last refresh.
+    unordered_map<VID, size_t> m_outDegrees; ///< Out-degrees at the last
+                                             ///< refresh.
+    const CFG* m_storage{nullptr}; ///< StorageAddress at the last refresh.
+    set<CCM*> m_dirtyCCs;        ///< CCs which lost vertices or edges.
+    bool m_rebuild{false};       ///< Force a full rebuild on the next refresh.
+
+    ///@}
+    ///\name Cfg2VID Index
+    ///@{
+
+    unordered_multimap<size_t, VID> m_cfgIndex; ///< VIDs by CfgKey.
+    double m_indexResolution{1e-6};  ///< Quantization step for CfgKey.
+    double m_indexSlack{0.01};       ///< Boundary distance, in cells, which
+                                     ///< CfgKeys also probes across.
+    size_t m_maxProbedDofs{4};       ///< Most DOFs probed across a boundary,
+                                     ///< bounding a lookup to 2^4 keys.
+    VID m_lastIndexedVID{VID(-1)};   ///< Largest VID in the index.
+
+    ///@}
+
+    SpatialIndex m_spatialIndex; ///< Node and edge positions for picking.
 };
 
 template <class CFG, class WEIGHT>
@@ -118,8 +378,6 @@ MapModel(const string& _filename) : LoadableModel("Map"), m_delGraph(true) {
 template <class CFG, class WEIGHT>
 MapModel<CFG, WEIGHT>::
 ~MapModel() {
-  for(CCIT ic = m_ccModels.begin(); ic != m_ccModels.end(); ic++)
-    delete *ic;
   if(m_delGraph)
     delete m_graph;
 }
@@ -129,10 +387,17 @@ MapModel<CFG, WEIGHT>::
 template<class CFG, class WEIGHT>
 void
 MapModel<CFG,WEIGHT>::
-ParseFile() {
+ParseFile(ParseProgress* _progress) {
   if(!FileExists(GetFilename()))
     throw ParseException(WHERE, "File '" + GetFilename() + "' does not exist");
 
+  if(BinaryRoadmap::IsBinary(GetFilename())) {
+    ParseBinary();
+    if(_progress)
+      _progress->m_items = m_graph->get_num_vertices();
+    return;
+  }
+
   ifstream ifs(GetFilename());
 
   //parse env filename
@@ -141,14 +406,62 @@ ParseFile() {
   getline(ifs, m_envFileName);
   getline(ifs, s);
 
-  //Get Graph Data
-  read_graph(*m_graph, ifs);
+  //Get Graph Data, in the layout of read_graph: a header with the vertex,
+  //edge, and largest VID counts, then a line for each vertex with its edges.
+  size_t numVertices, numEdges;
+  VID maxVID;
+  if(!(ifs >> numVertices >> numEdges >> maxVID))
+    throw ParseException(WHERE, "Bad graph header in '" + GetFilename() + "'.");
+  size_t offset = ifs.tellg();
+  ifs.close();
+
+  //The vertex lines are parsed in parallel and added to the graph in order
+  TextParser::MappedFile file(GetFilename());
+  if(_progress) {
+    _progress->m_size = file.size();
+    _progress->m_bytes = offset;
+  }
+  auto parse = [](const char* _p, const char* _end, VertexRecord& _r) {
+    size_t numAdjacent;
+    if(!TextParser::ParseUnsigned(_p, _end, _r.m_vid) ||
+        !_r.m_cfg.Parse(_p, _end) ||
+        !TextParser::ParseUnsigned(_p, _end, numAdjacent))
+      return false;
+    if(!numAdjacent)
+      return true;
+
+    _r.m_edges.resize(numAdjacent);
+    for(auto& edge : _r.m_edges)
+      if(!TextParser::ParseUnsigned(_p, _end, edge.first) ||
+          !edge.second.Parse(_p, _end))
+        return false;
+    return true;
+  };
+  size_t count = 0;
+  auto add = [&](VertexRecord& _r) {
+    m_graph->add_vertex(_r.m_vid, _r.m_cfg);
+    for(auto& edge : _r.m_edges)
+      m_graph->add_edge(_r.m_vid, edge.first, edge.second);
+    ++count;
+  };
+  TextParser::ParseRecords<VertexRecord>(file.begin() + offset, file.end(),
+      parse, add, _progress);
+
+  if(count != numVertices)
+    throw ParseException(WHERE, "Expected " + to_string(numVertices) +
+        " vertices in '" + GetFilename() + "' but found " + to_string(count) +
+        ".");
 }
 
 template <class CFG, class WEIGHT>
 void
 MapModel<CFG, WEIGHT>::
 Write(const string& _filename) {
+  if(BinaryRoadmap::HasBinaryExtension(_filename)) {
+    WriteBinary(_filename);
+    return;
+  }
+
   ofstream outfile(_filename.c_str());
 
   outfile << "#####ENVFILESTART##### \n";
@@ -158,24 +471,277 @@ Write(const string& _filename) {
   write_graph(*m_graph, outfile);
 }
 
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+ParseBinary() {
+  using namespace BinaryRoadmap;
+  Reader reader(GetFilename());
+  const Header& header = reader.GetHeader();
+  m_envFileName = reader.GetEnvFileName();
+
+  //Configurations are built straight from the mapped DOF rows
+  const size_t dofs = header.m_dofs;
+  const uint64_t* vids = reader.Get<uint64_t>(VIDs);
+  const double* values = reader.Get<double>(DOFs);
+  CFG cfg(header.m_robotIndex);
+  vector<double> data(dofs);
+  for(size_t i = 0; i < header.m_numVertices; ++i) {
+    if(m_graph->find_vertex(vids[i]) != m_graph->end())
+      throw ParseException(WHERE, "'" + GetFilename() + "' repeats VID " +
+          to_string(vids[i]) + ".");
+    data.assign(values + i * dofs, values + (i + 1) * dofs);
+    cfg.SetCfg(data);
+    m_graph->add_vertex(vids[i], cfg);
+  }
+
+  const uint64_t* offsets = reader.Get<uint64_t>(Offsets);
+  const uint64_t* targets = reader.Get<uint64_t>(Targets);
+  const double* weights = reader.Get<double>(Weights);
+  string label;
+  vector<CFG> intermediates;
+  for(size_t i = 0; i < header.m_numVertices; ++i)
+    for(size_t e = offsets[i]; e < offsets[i + 1]; ++e) {
+      if(m_graph->find_vertex(targets[e]) == m_graph->end())
+        throw ParseException(WHERE, "'" + GetFilename() + "' has an edge to "
+            "missing VID " + to_string(targets[e]) + ".");
+      size_t count;
+      const double* rows = reader.GetEdgeData(e, label, count);
+      intermediates.clear();
+      for(size_t j = 0; j < count; ++j) {
+        data.assign(rows + j * dofs, rows + (j + 1) * dofs);
+        cfg.SetCfg(data);
+        intermediates.push_back(cfg);
+      }
+      m_graph->add_edge(vids[i], targets[e],
+          WEIGHT(label, weights[e], intermediates));
+    }
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+WriteBinary(const string& _filename) {
+  using namespace BinaryRoadmap;
+  size_t dofs = 0, robot = 0;
+  if(m_graph->begin() != m_graph->end()) {
+    dofs = m_graph->begin()->property().GetData().size();
+    robot = m_graph->begin()->property().GetRobotIndex();
+  }
+
+  Writer out(_filename, dofs, robot, m_graph->get_num_vertices(),
+      m_graph->get_num_edges());
+
+  //Each section is a separate pass over the graph, so nothing is buffered
+  //beyond the blob index.
+  out.Begin(EnvName);
+  out.Write(m_envFileName.data(), m_envFileName.size());
+
+  out.Begin(VIDs);
+  for(VI vi = m_graph->begin(); vi != m_graph->end(); ++vi)
+    out.Write<uint64_t>(vi->descriptor());
+
+  out.Begin(DOFs);
+  for(VI vi = m_graph->begin(); vi != m_graph->end(); ++vi) {
+    const vector<double>& data = vi->property().GetData();
+    if(data.size() != dofs)
+      throw ParseException(WHERE, "Binary roadmaps need every configuration "
+          "to have the same number of DOFs.");
+    out.Write(data.data(), dofs * sizeof(double));
+  }
+
+  out.Begin(Offsets);
+  uint64_t numEdges = 0;
+  out.Write(numEdges);
+  for(VI vi = m_graph->begin(); vi != m_graph->end(); ++vi) {
+    for(EI ei = vi->begin(); ei != vi->end(); ++ei)
+      ++numEdges;
+    out.Write(numEdges);
+  }
+
+  out.Begin(Targets);
+  for(VI vi = m_graph->begin(); vi != m_graph->end(); ++vi)
+    for(EI ei = vi->begin(); ei != vi->end(); ++ei)
+      out.Write<uint64_t>((*ei).target());
+
+  out.Begin(Weights);
+  for(VI vi = m_graph->begin(); vi != m_graph->end(); ++vi)
+    for(EI ei = vi->begin(); ei != vi->end(); ++ei)
+      out.Write<double>((*ei).property().GetWeight());
+
+  out.Begin(Blob);
+  static const char padding[8] = {};
+  vector<uint64_t> blobIndex(1, 0);
+  blobIndex.reserve(numEdges + 1);
+  for(VI vi = m_graph->begin(); vi != m_graph->end(); ++vi)
+    for(EI ei = vi->begin(); ei != vi->end(); ++ei) {
+      WEIGHT& edge = (*ei).property();
+      string label = edge.GetLPLabel();
+      vector<CFG>& intermediates = edge.GetIntermediates();
+      uint32_t length = label.size(), count = intermediates.size();
+      out.Write(length);
+      out.Write(count);
+      out.Write(label.data(), length);
+      out.Write(padding, BlobPadding(length) - length);
+      for(auto& c : intermediates) {
+        if(c.GetData().size() != dofs)
+          throw ParseException(WHERE, "Binary roadmaps need every "
+              "configuration to have the same number of DOFs.");
+        out.Write(c.GetData().data(), dofs * sizeof(double));
+      }
+      blobIndex.push_back(blobIndex.back() + 8 + BlobPadding(length) +
+          count * dofs * sizeof(double));
+    }
+
+  out.Begin(BlobIndex);
+  out.Write(blobIndex.data(), blobIndex.size() * sizeof(uint64_t));
+  out.Close();
+}
+
 template <class CFG, class WEIGHT>
 typename MapModel<CFG, WEIGHT>::VID
 MapModel<CFG, WEIGHT>::
 Cfg2VID(const CFG& _target) {
-  for(VI vi = m_graph->begin(); vi != m_graph->end(); vi++)
-    if(_target == vi->property())
-      return vi->descriptor();
+  IndexVertices();
+
+  //Equal configurations can round to neighboring cells, so probe those too
+  vector<size_t> keys;
+  bool complete = CfgKeys(_target, keys);
+  for(auto key : keys) {
+    auto range = m_cfgIndex.equal_range(key);
+    for(auto it = range.first; it != range.second;) {
+      VI vi = m_graph->find_vertex(it->second);
+      //drop vertices which were deleted through the graph directly
+      if(vi == m_graph->end()) {
+        it = m_cfgIndex.erase(it);
+        continue;
+      }
+      if(_target == vi->property())
+        return it->second;
+      ++it;
+    }
+  }
+
+  //Too many DOFs lie near a boundary to probe every neighboring cell. This
+  //is rare, so scan instead.
+  if(!complete)
+    for(VI vi = m_graph->begin(); vi != m_graph->end(); ++vi)
+      if(_target == vi->property())
+        return vi->descriptor();
   return -1;
 }
 
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+SetIndexResolution(double _res) {
+  m_indexResolution = _res;
+  m_cfgIndex.clear();
+  m_lastIndexedVID = VID(-1);
+}
+
+template <class CFG, class WEIGHT>
+size_t
+MapModel<CFG, WEIGHT>::
+CfgKey(const CFG& _c) const {
+  size_t key = 0;
+  for(const auto& v : _c.GetData()) {
+    long long q = llround(v / m_indexResolution);
+    key ^= hash<long long>()(q) + 0x9e3779b9 + (key << 6) + (key >> 2);
+  }
+  return key;
+}
+
+template <class CFG, class WEIGHT>
+bool
+MapModel<CFG, WEIGHT>::
+CfgKeys(const CFG& _c, vector<size_t>& _keys) const {
+  const vector<double> data = _c.GetData();
+  vector<long long> cells(data.size()), neighbors(data.size());
+  vector<size_t> near;
+  for(size_t i = 0; i < data.size(); ++i) {
+    double q = data[i] / m_indexResolution;
+    cells[i] = llround(q);
+    double offset = q - cells[i];
+    if(fabs(offset) > 0.5 - m_indexSlack) {
+      near.push_back(i);
+      neighbors[i] = cells[i] + (offset > 0 ? 1 : -1);
+    }
+  }
+
+  //Each subset of the DOFs near a boundary names one neighboring cell. The
+  //empty subset, the configuration's own cell, comes first.
+  _keys.clear();
+  bool complete = near.size() <= m_maxProbedDofs;
+  if(!complete)
+    near.clear();
+  for(size_t mask = 0; mask < (size_t(1) << near.size()); ++mask) {
+    size_t key = 0;
+    for(size_t i = 0, n = 0; i < data.size(); ++i) {
+      long long q = cells[i];
+      if(n < near.size() && near[n] == i)
+        if(mask & (size_t(1) << n++))
+          q = neighbors[i];
+      key ^= hash<long long>()(q) + 0x9e3779b9 + (key << 6) + (key >> 2);
+    }
+    _keys.push_back(key);
+  }
+  return complete;
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+UnindexVertex(VI _vi) {
+  auto range = m_cfgIndex.equal_range(CfgKey(_vi->property()));
+  for(auto it = range.first; it != range.second; ++it)
+    if(it->second == _vi->descriptor()) {
+      m_cfgIndex.erase(it);
+      break;
+    }
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+IndexVertices() {
+  //Vertices are kept in VID order, so new ones follow the last indexed VID
+  //even when others were deleted in between and the count is unchanged. If
+  //that vertex is gone, index everything again.
+  VI vi = m_graph->begin();
+  if(m_lastIndexedVID != VID(-1)) {
+    vi = m_graph->find_vertex(m_lastIndexedVID);
+    if(vi == m_graph->end()) {
+      m_cfgIndex.clear();
+      vi = m_graph->begin();
+    }
+    else
+      ++vi;
+  }
+  for(; vi != m_graph->end(); ++vi) {
+    m_cfgIndex.emplace(CfgKey(vi->property()), vi->descriptor());
+    m_lastIndexedVID = vi->descriptor();
+  }
+}
+
 //////////Display functions//////////
 
 template <class CFG, class WEIGHT>
 void
 MapModel<CFG, WEIGHT>::
 Build() {
-  for(CCIT ic = m_ccModels.begin(); ic != m_ccModels.end(); ic++)
-    delete *ic;
+  QMutexLocker lock(&m_lock);
+  Rebuild();
+  m_version.fetch_add(1, memory_order_release);
+  shared_ptr<RenderSnapshot> snapshot = PrepareSnapshot();
+  lock.unlock();
+  PublishSnapshot(snapshot);
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+Rebuild() {
   m_ccModels.clear();
 
   //Get CCs
@@ -185,38 +751,422 @@ Build() {
   get_cc_stats(*m_graph, colorMap, ccs);
   m_ccModels.reserve(ccs.size());
   for(CIT ic = ccs.begin(); ic != ccs.end(); ic++) {
-    m_ccModels.push_back(new CCM(ic-ccs.begin(), ic->second, m_graph));
+    m_ccModels.emplace_back(new CCM(ic-ccs.begin(), ic->second, m_graph));
     m_ccModels.back()->SetRenderMode(m_renderMode);
   }
+
+  VID lastVID = VID(-1);
+  m_spatialIndex.Clear();
+  m_outDegrees.clear();
+  for(VI vi = m_graph->begin(); vi != m_graph->end(); ++vi) {
+    if(lastVID == VID(-1) || vi->descriptor() > lastVID)
+      lastVID = vi->descriptor();
+    m_outDegrees[vi->descriptor()] = vi->size();
+    m_spatialIndex.AddPoint(vi->descriptor(), vi->property().GetPoint());
+    for(EI ei = vi->begin(); ei != vi->end(); ++ei)
+      IndexEdge(vi, ei);
+  }
+  m_spatialIndex.Refresh();
+  ResetChanges(lastVID);
+}
+
+template <class CFG, class WEIGHT>
+bool
+MapModel<CFG, WEIGHT>::
+Update() {
+  if(m_rebuild)
+    return false;
+
+  //Collect the vertices added since the last refresh. VIDs are handed out in
+  //increasing order, so they all follow the last known VID.
+  VI vi = m_graph->begin();
+  if(m_lastVID != VID(-1)) {
+    vi = m_graph->find_vertex(m_lastVID);
+    if(vi == m_graph->end())
+      return false;
+    ++vi;
+  }
+  vector<VID> added;
+  unordered_set<VID> isAdded;
+  for(; vi != m_graph->end(); ++vi) {
+    added.push_back(vi->descriptor());
+    isAdded.insert(vi->descriptor());
+  }
+
+  //A vertex deleted behind our back shows up as a count mismatch.
+  if(m_graph->get_num_vertices() !=
+      m_numVertices - m_deletedVertices + added.size())
+    return false;
+
+  //Find the edges added or deleted between old vertices, such as those PMPL
+  //adds through the graph, by comparing the out-degree of each old vertex with
+  //the one recorded. Edges are appended to their source's list, so growth is
+  //the newest edges. Edges into a new vertex are handled with it, and a vertex
+  //which lost edges has its CC regrouped.
+  vector<pair<VID, VID>> addedEdges;
+  vector<VID> changed;
+  set<CCM*> lostEdges;
+  for(VI v = m_graph->begin(); m_lastVID != VID(-1) && v != m_graph->end() &&
+      v->descriptor() <= m_lastVID; ++v) {
+    auto degree = m_outDegrees.find(v->descriptor());
+    if(degree == m_outDegrees.end())
+      return false;
+    size_t now = v->size();
+    if(now == degree->second)
+      continue;
+    changed.push_back(v->descriptor());
+    if(now < degree->second) {
+      lostEdges.insert(v->property().GetCC());
+      continue;
+    }
+    EI ei = v->begin();
+    advance(ei, degree->second);
+    for(; ei != v->end(); ++ei)
+      if(!isAdded.count((*ei).target()))
+        addedEdges.emplace_back(v->descriptor(), (*ei).target());
+  }
+  m_dirtyCCs.insert(lostEdges.begin(), lostEdges.end());
+
+  //Dissolve the CCs that lost members. Their remaining nodes are regrouped
+  //together with the new vertices below.
+  vector<VID> pending = added;
+  unordered_set<VID> isPending(isAdded);
+  vector<VID> moved = added;
+  for(auto cc : m_dirtyCCs) {
+    for(auto& vid : cc->GetNodes()) {
+      moved.push_back(vid);
+      if(m_graph->find_vertex(vid) != m_graph->end()) {
+        pending.push_back(vid);
+        isPending.insert(vid);
+      }
+    }
+    m_ccModels.erase(find_if(m_ccModels.begin(), m_ccModels.end(),
+          [&](const shared_ptr<CCM>& _cc) {return _cc.get() == cc;}));
+  }
+
+  //If the vertex storage moved, the CC and edge pointers of the remaining
+  //nodes are stale.
+  if(!m_dirtyCCs.empty() || StorageAddress() != m_storage)
+    for(auto cc : m_ccModels)
+      cc->Relink();
+
+  //Union-find over the pending vertices and the untouched CCs, which are
+  //represented by their reference node.
+  unordered_map<VID, VID> parent;
+  function<VID(VID)> findSet = [&](VID _v) -> VID {
+    auto it = parent.find(_v);
+    if(it == parent.end() || it->second == _v)
+      return _v;
+    return it->second = findSet(it->second);
+  };
+  auto key = [&](VID _v) -> VID {
+    return isPending.count(_v) ? _v : m_graph->find_vertex(_v)->
+        property().GetCC()->GetRep();
+  };
+
+  vector<pair<VID, VID>> edges;
+  for(auto& vid : pending) {
+    VI v = m_graph->find_vertex(vid);
+    for(EI ei = v->begin(); ei != v->end(); ++ei) {
+      VID target = (*ei).target();
+      if(!CCM::SkipEdge(m_graph, vid, target))
+        edges.emplace_back(vid, target);
+      else if(!isPending.count(target))
+        edges.emplace_back(target, vid);
+      else
+        continue;
+      VID a = findSet(key(vid)), b = findSet(key(target));
+      if(a != b)
+        parent[a] = b;
+    }
+  }
+
+  //Edges added between existing vertices. Those touching a pending vertex
+  //were found above, and each bi-directional pair is drawn once.
+  for(auto& e : addedEdges) {
+    if(isPending.count(e.first) || isPending.count(e.second) ||
+        CCM::SkipEdge(m_graph, e.first, e.second) ||
+        !m_graph->IsEdge(e.first, e.second))
+      continue;
+    edges.push_back(e);
+    VID a = findSet(key(e.first)), b = findSet(key(e.second));
+    if(a != b)
+      parent[a] = b;
+  }
+
+  //Gather each group's pending nodes, edges, and existing CCs.
+  struct Group {
+    vector<VID> nodes;
+    vector<pair<VID, VID>> edges;
+    vector<CCM*> ccs;
+  };
+  map<VID, Group> groups;
+  for(auto& vid : pending)
+    groups[findSet(vid)].nodes.push_back(vid);
+  for(auto& e : edges)
+    groups[findSet(key(e.first))].edges.push_back(e);
+  for(auto cc : m_ccModels) {
+    auto it = groups.find(findSet(cc->GetRep()));
+    if(it != groups.end())
+      it->second.ccs.push_back(cc.get());
+  }
+
+  //Extend the largest existing CC of each group and fold the others into it.
+  //Groups made of pending nodes only become new CCs.
+  unordered_set<CCM*> merged;
+  for(auto& g : groups) {
+    Group& group = g.second;
+    if(group.ccs.empty()) {
+      if(group.nodes.empty())
+        continue;
+      m_ccModels.emplace_back(new CCM(m_ccModels.size(), group.nodes,
+          m_graph));
+      m_ccModels.back()->SetRenderMode(m_renderMode);
+      continue;
+    }
+    CCM* largest = *max_element(group.ccs.begin(), group.ccs.end(),
+        [](CCM* _a, CCM* _b) {
+          return _a->GetNodes().size() < _b->GetNodes().size();
+        });
+    for(auto cc : group.ccs)
+      if(cc != largest) {
+        largest->Merge(*cc);
+        merged.insert(cc);
+      }
+    largest->Extend(group.nodes, group.edges);
+  }
+
+  if(!merged.empty())
+    m_ccModels.erase(remove_if(m_ccModels.begin(), m_ccModels.end(),
+          [&](const shared_ptr<CCM>& _cc) {return merged.count(_cc.get());}),
+        m_ccModels.end());
+
+  //CC IDs are their positions in m_ccModels, which selection relies on.
+  for(size_t i = 0; i < m_ccModels.size(); ++i)
+    m_ccModels[i]->SetID(i);
+
+  //Nodes of dissolved CCs may have moved or lost edges, so index them again
+  //along with the new vertices and edges.
+  for(auto& e : addedEdges) {
+    moved.push_back(e.first);
+    moved.push_back(e.second);
+  }
+  IndexGeometry(moved);
+
+  //Record the out-degrees of every vertex which may have changed
+  changed.insert(changed.end(), moved.begin(), moved.end());
+  for(auto& vid : changed) {
+    VI v = m_graph->find_vertex(vid);
+    if(v == m_graph->end())
+      m_outDegrees.erase(vid);
+    else
+      m_outDegrees[vid] = v->size();
+  }
+
+  ResetChanges(added.empty() ? m_lastVID : added.back());
+  return true;
 }
 
 template <class CFG, class WEIGHT>
 void
 MapModel<CFG, WEIGHT>::
-DrawRender() {
-  QMutexLocker lock(&m_lock);
-  if(m_renderMode == INVISIBLE_MODE)
+ResetChanges(VID _lastVID) {
+  m_numVertices = m_graph->get_num_vertices();
+  m_lastVID = _lastVID;
+  m_deletedVertices = 0;
+  m_storage = StorageAddress();
+  m_dirtyCCs.clear();
+  m_rebuild = false;
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+MarkDirty(VID _v) {
+  //Vertices added since the last refresh do not belong to a CC yet.
+  VI vi = m_graph->find_vertex(_v);
+  if(vi == m_graph->end() || _v > m_lastVID || m_lastVID == VID(-1) ||
+      !vi->property().GetCC())
+    m_rebuild = true;
+  else
+    m_dirtyCCs.insert(vi->property().GetCC());
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+Clear() {
+  m_graph->clear();
+  m_cfgIndex.clear();
+  m_lastIndexedVID = VID(-1);
+  m_rebuild = true;
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+DeleteVertex(VID _v) {
+  MarkDirty(_v);
+  IndexVertices();
+
+  VI vi = m_graph->find_vertex(_v);
+  if(vi != m_graph->end()) {
+    UnindexVertex(vi);
+    //Keep the last indexed VID in the graph, so that IndexVertices does not
+    //mistake the deletion for a reload
+    if(_v == m_lastIndexedVID) {
+      if(vi == m_graph->begin())
+        m_lastIndexedVID = VID(-1);
+      else {
+        VI prev = vi;
+        m_lastIndexedVID = (--prev)->descriptor();
+      }
+    }
+  }
+
+  size_t numVertices = m_graph->get_num_vertices();
+  m_graph->delete_vertex(_v);
+  m_deletedVertices += numVertices - m_graph->get_num_vertices();
+}
+
+template <class CFG, class WEIGHT>
+typename MapModel<CFG, WEIGHT>::VID
+MapModel<CFG, WEIGHT>::
+AddVertex(const CFG& _c) {
+  //RoadmapGraph::AddVertex looks for duplicates by scanning every vertex, so
+  //look through the index instead and add to the graph directly
+  VID vid = Cfg2VID(_c);
+  if(vid != VID(-1))
+    return vid;
+
+  vid = m_graph->add_vertex(_c);
+  m_cfgIndex.emplace(CfgKey(_c), vid);
+  m_lastIndexedVID = vid;
+  return vid;
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+MoveVertex(VID _v, const vector<double>& _data) {
+  IndexVertices();
+  VI vi = m_graph->find_vertex(_v);
+  if(vi == m_graph->end())
     return;
 
-  //Draw each CC
-  for(CCIT ic = m_ccModels.begin(); ic != m_ccModels.end(); ic++)
-    (*ic)->DrawRender();
+  UnindexVertex(vi);
+  vi->property().SetCfg(_data);
+  m_cfgIndex.emplace(CfgKey(vi->property()), _v);
+  MarkDirty(_v);
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+AddEdge(VID _source, VID _target, const WEIGHT& _w) {
+  m_graph->add_edge(_source, _target, _w);
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+DeleteEdge(VID _source, VID _target) {
+  MarkDirty(_source);
+  m_graph->delete_edge(_source, _target);
+}
+
+template <class CFG, class WEIGHT>
+const CFG*
+MapModel<CFG, WEIGHT>::
+StorageAddress() {
+  return m_graph->begin() == m_graph->end() ? nullptr :
+      &m_graph->begin()->property();
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+IndexGeometry(const vector<VID>& _vids) {
+  unordered_set<VID> touched(_vids.begin(), _vids.end());
+  unordered_set<VID> neighbors;
+  for(auto& vid : touched)
+    for(auto& n : m_spatialIndex.Remove(vid))
+      neighbors.insert(n);
+
+  for(auto& vid : touched) {
+    VI vi = m_graph->find_vertex(vid);
+    if(vi == m_graph->end())
+      continue;
+    m_spatialIndex.AddPoint(vid, vi->property().GetPoint());
+    for(EI ei = vi->begin(); ei != vi->end(); ++ei)
+      IndexEdge(vi, ei);
+  }
+
+  //Edges leading into the touched vertices from untouched ones
+  for(auto& n : neighbors) {
+    VI vi = m_graph->find_vertex(n);
+    if(touched.count(n) || vi == m_graph->end())
+      continue;
+    for(EI ei = vi->begin(); ei != vi->end(); ++ei)
+      if(touched.count((*ei).target()))
+        IndexEdge(vi, ei);
+  }
+  m_spatialIndex.Refresh();
 }
 
 template <class CFG, class WEIGHT>
 void
 MapModel<CFG, WEIGHT>::
-DrawSelect() {
+IndexEdge(VI _v, EI _ei) {
+  VI target = m_graph->find_vertex((*_ei).target());
+  if(target == m_graph->end())
+    return;
+  vector<Point3d> points(1, _v->property().GetPoint());
+  for(auto& c : (*_ei).property().GetIntermediates())
+    points.push_back(c.GetPoint());
+  points.push_back(target->property().GetPoint());
+  m_spatialIndex.AddEdge(_v->descriptor(), target->descriptor(), points);
+}
+
+template <class CFG, class WEIGHT>
+vector<typename MapModel<CFG, WEIGHT>::VID>
+MapModel<CFG, WEIGHT>::
+Nearest(const Point3d& _p, size_t _k) {
+  QMutexLocker lock(&m_lock);
+  vector<VID> nearest;
+  for(auto& vid : m_spatialIndex.Nearest(_p, _k))
+    nearest.push_back(vid);
+  return nearest;
+}
+
+template <class CFG, class WEIGHT>
+vector<pair<typename MapModel<CFG, WEIGHT>::VID,
+    typename MapModel<CFG, WEIGHT>::VID>>
+MapModel<CFG, WEIGHT>::
+Overlapping(const Point3d& _min, const Point3d& _max) {
   QMutexLocker lock(&m_lock);
+  vector<SpatialIndex::Key> hits;
+  m_spatialIndex.Overlapping(_min, _max, hits);
+  vector<pair<VID, VID>> keys;
+  keys.reserve(hits.size());
+  for(auto& h : hits)
+    keys.emplace_back(h.first, h.second);
+  return keys;
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+DrawRender() {
   if(m_renderMode == INVISIBLE_MODE)
     return;
 
-  //Draw each CC
-  for(CCIT ic = m_ccModels.begin(); ic != m_ccModels.end(); ic++){
-    glPushName((*ic)->GetID());
-    (*ic)->DrawSelect();
-    glPopName();
-  }
+  //Draw each CC from the latest snapshot, leaving the mutex to the planner
+  shared_ptr<const RenderSnapshot> snapshot = atomic_load(&m_snapshot);
+  if(!snapshot)
+    return;
+  for(auto& cc : snapshot->m_ccs)
+    cc.m_geometry->Draw(cc.m_color, cc.m_renderMode);
 }
 
 template <class CFG, class WEIGHT>
@@ -227,15 +1177,23 @@ SetRenderMode(RenderMode _mode) {
   m_renderMode = _mode;
   for(CCIT ic = m_ccModels.begin(); ic != m_ccModels.end(); ic++)
     (*ic)->SetRenderMode(_mode);
+  shared_ptr<RenderSnapshot> snapshot = PrepareSnapshot();
+  lock.unlock();
+  PublishSnapshot(snapshot);
 }
 
 template <class CFG, class WEIGHT>
 void
 MapModel<CFG, WEIGHT>::
 GetChildren(list<Model*>& _models) {
-  //QMutexLocker lock(&m_lock);
-  for(CCIT ic = m_ccModels.begin(); ic != m_ccModels.end(); ic++)
-    _models.push_back(*ic);
+  //Read the CCs from the latest snapshot. A refresh may drop them once no
+  //snapshot holds them, so callers which keep them must hold the mutex for as
+  //long as they do.
+  shared_ptr<const RenderSnapshot> snapshot = atomic_load(&m_snapshot);
+  if(!snapshot)
+    return;
+  for(auto& cc : snapshot->m_ccs)
+    _models.push_back(cc.m_model.get());
 }
 
 template <class CFG, class WEIGHT>
@@ -251,11 +1209,68 @@ void
 MapModel<CFG, WEIGHT>::
 Select(GLuint* _index, vector<Model*>& _sel) {
   QMutexLocker lock(&m_lock);
-  if(!m_selectable || _index == NULL)
+  if(!m_selectable || _index == NULL || m_pickVersion != GetVersion() ||
+      _index[0] >= m_ccModels.size())
     return;
   m_ccModels[_index[0]]->Select(&_index[1], _sel);
 }
 
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+Select(const Box& _box, bool _all, vector<Model*>& _sel) {
+  QMutexLocker lock(&m_lock);
+  if(!m_selectable || m_renderMode == INVISIBLE_MODE)
+    return;
+
+  if(_all) {
+    Frustum frustum;
+    frustum.Update(min(_box.m_left, _box.m_right),
+        min(_box.m_bottom, _box.m_top), max(_box.m_left, _box.m_right),
+        max(_box.m_bottom, _box.m_top));
+    vector<SpatialIndex::Key> hits;
+    m_spatialIndex.PickFrustum(frustum, hits);
+    for(auto& key : hits)
+      SelectKey(key, _sel);
+    return;
+  }
+
+  //Accept items within half the box of the center ray. The tolerance is
+  //measured by the spread between the center ray and one through the corner.
+  double x = (_box.m_left + _box.m_right) / 2;
+  double y = (_box.m_bottom + _box.m_top) / 2;
+  double r = max(fabs(_box.m_right - _box.m_left), 5.) / 2;
+  Point3d origin, corner;
+  Vector3d dir, cornerDir;
+  GLUtils::WindowRay(x, y, origin, dir);
+  GLUtils::WindowRay(x + r, y, corner, cornerDir);
+
+  SpatialIndex::Key hit;
+  if(m_spatialIndex.PickRay(origin, dir, (corner - origin).norm(),
+        (cornerDir - dir).norm(), hit))
+    SelectKey(hit, _sel);
+}
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+SelectKey(const SpatialIndex::Key& _key, vector<Model*>& _sel) {
+  VI vi = m_graph->find_vertex(_key.first);
+  if(vi == m_graph->end())
+    return;
+  CCM* cc = vi->property().GetCC();
+  if(!cc || !cc->IsSelectable() || cc->GetRenderMode() == INVISIBLE_MODE)
+    return;
+
+  if(_key.first == _key.second) {
+    _sel.push_back(&vi->property());
+    return;
+  }
+  EI ei;
+  if(m_graph->find_edge(EID(_key.first, _key.second), vi, ei))
+    _sel.push_back(&(*ei).property());
+}
+
 template <class CFG, class WEIGHT>
 void
 MapModel<CFG, WEIGHT>::
@@ -264,6 +1279,9 @@ SetColor(const Color4& _c) {
   Model::SetColor(_c);
   for(CCIT ic = m_ccModels.begin(); ic != m_ccModels.end(); ++ic)
     (*ic)->SetColor(_c);
+  shared_ptr<RenderSnapshot> snapshot = PrepareSnapshot();
+  lock.unlock();
+  PublishSnapshot(snapshot);
 }
 
 template <class CFG, class WEIGHT>
@@ -273,17 +1291,68 @@ RandomizeCCColors() {
   QMutexLocker lock(&m_lock);
   for(CCIT ic = m_ccModels.begin(); ic != m_ccModels.end(); ++ic)
     (*ic)->SetColor(Color4(drand48(), drand48(), drand48(), 1));
+  shared_ptr<RenderSnapshot> snapshot = PrepareSnapshot();
+  lock.unlock();
+  PublishSnapshot(snapshot);
 }
 
 template <class CFG, class WEIGHT>
 void
 MapModel<CFG, WEIGHT>::
 RefreshMap(bool lock) {
-  QMutexLocker* locker = NULL;
+  //Without the lock the caller holds the mutex, and the publish runs under it
+  QMutexLocker locker(&m_lock);
+  if(!lock)
+    locker.unlock();
+  if(!Update())
+    Rebuild();
+  m_version.fetch_add(1, memory_order_release);
+  shared_ptr<RenderSnapshot> snapshot = PrepareSnapshot();
   if(lock)
-    locker = new QMutexLocker(&m_lock);
-  Build();
-  delete locker;
+    locker.unlock();
+  PublishSnapshot(snapshot);
+}
+
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+PrepareSnapshot() {
+  shared_ptr<RenderSnapshot> snapshot(new RenderSnapshot);
+  snapshot->m_sequence = ++m_snapshotSequence;
+  snapshot->m_ccs.resize(m_ccModels.size());
+  for(size_t i = 0; i < m_ccModels.size(); ++i) {
+    auto& cc = snapshot->m_ccs[i];
+    cc.m_model = m_ccModels[i];
+    cc.m_geometry = m_ccModels[i]->GetGeometry();
+    cc.m_color = m_ccModels[i]->GetColor();
+    cc.m_renderMode = m_ccModels[i]->GetRenderMode();
+  }
+  return snapshot;
+}
+
+
+template <class CFG, class WEIGHT>
+void
+MapModel<CFG, WEIGHT>::
+PublishSnapshot(shared_ptr<RenderSnapshot> _snapshot) {
+  //Build the missing LOD levels here rather than under the mutex, and give
+  //them back to the CC so that later snapshots reuse them
+  for(auto& cc : _snapshot->m_ccs) {
+    if(cc.m_geometry->m_lods)
+      continue;
+    auto geometry = make_shared<typename CCM::Geometry>(*cc.m_geometry);
+    geometry->m_lods = geometry->BuildLODs();
+    cc.m_model->SetLODs(geometry->m_lods);
+    cc.m_geometry = geometry;
+  }
+
+  //Another thread may have published a later snapshot meanwhile
+  shared_ptr<const RenderSnapshot> current = atomic_load(&m_snapshot);
+  shared_ptr<const RenderSnapshot> snapshot(_snapshot);
+  while(!current || current->m_sequence < snapshot->m_sequence)
+    if(atomic_compare_exchange_weak(&m_snapshot, &current, snapshot))
+      break;
 }
 
 #endif
@@ -5,11 +5,12 @@
 #include "Vizmo.h"
 #include "Utilities/IO.h"
 #include "Utilities/IOUtils.h"
+#include "Utilities/TextParser.h"
 
 PathModel::
 PathModel(const string& _filename) :
   LoadableModel("Path"),
-  m_glPathIndex(-1), m_frame(0),
+  m_frame(0),
   m_lineWidth(1), m_displayInterval(3) {
     SetFilename(_filename);
     m_renderMode = INVISIBLE_MODE;
@@ -48,82 +49,71 @@ ParseFile() {
   getline(ifs, garbage);
 
   size_t pathSize;
-  ifs >> pathSize;
-  m_path.resize(pathSize);
-
-  for(size_t i = 0; i < pathSize && ifs; ++i) {
-    ifs >> m_path[i];
-    m_path[i].SetRenderMode(WIRE_MODE);
-  }
+  if(!(ifs >> pathSize))
+    throw ParseException(WHERE, "Bad path size in '" + GetFilename() + "'.");
+  size_t offset = ifs.tellg();
+  ifs.close();
+
+  //The cfg lines are parsed in parallel and collected in order
+  TextParser::MappedFile file(GetFilename());
+  auto parse = [](const char* _p, const char* _end, CfgModel& _c) {
+    return _c.Parse(_p, _end);
+  };
+  auto add = [this, pathSize](CfgModel& _c) {
+    if(m_path.empty())
+      m_path.reserve(pathSize, _c.GetData().size());
+    m_path.push_back(_c);
+  };
+  TextParser::ParseRecords<CfgModel>(file.begin() + offset, file.end(), parse,
+      add);
+
+  if(m_path.size() != pathSize)
+    throw ParseException(WHERE, "Expected " + to_string(pathSize) +
+        " cfgs in '" + GetFilename() + "' but found " +
+        to_string(m_path.size()) + ".");
 }
 
 void
 PathModel::
 Build() {
-  CfgModel::Shape tmp = CfgModel::GetShape();
-  CfgModel::SetShape(CfgModel::Robot);
-
-  glMatrixMode(GL_MODELVIEW);
-
-  m_glPathIndex = glGenLists(1);
-  glNewList(m_glPathIndex, GL_COMPILE);
-
-  typedef vector<CfgModel>::iterator PIT;
-  typedef vector<Color4>::iterator CIT; //for the stop colors- small vector
-  vector<Color4> allColors; //for the indiv. colors that give the gradation- large vector
-
-  //set up all the colors for each frame along the path
-  if(m_stopColors.size() > 1) {
-    size_t numChunks = m_stopColors.size()-1;
-    size_t chunkSize = m_path.size()/numChunks;
-    for(CIT cit1 = m_stopColors.begin(), cit2 = cit1+1; cit2 != m_stopColors.end(); ++cit1, ++cit2){
-      for(size_t j=0; j<chunkSize; ++j) {
-        float percent = (float)j/(float)chunkSize;
-        allColors.push_back(Mix(*cit1, *cit2, percent));
-      }
-    }
-  }
-  else {
-    for(PIT pit = m_path.begin(); pit!=m_path.end(); ++pit)
-      allColors.push_back(m_stopColors[0]);
-  }
-
-  //for each color, draw the robot at each display interval
-  for(CIT cit = allColors.begin(); cit!=allColors.end(); ++cit) {
-    size_t i = cit-allColors.begin();
-    if(i % m_displayInterval == m_displayInterval/2){
-      m_path[i].SetColor(*cit);
-      m_path[i].DrawRender();
-    }
-  }
-
-  //gradient may not divide perfectly evenly, so remaining path components are
-  //given the last color
-  size_t remainder = m_path.size() % allColors.size();
-  for(size_t j = 0; j<remainder; ++j){
-    if(j%m_displayInterval==0){
-      m_path[allColors.size()+j].SetColor(allColors.back());
-      m_path[allColors.size()+j].DrawRender();
+  if(!m_robot)
+    m_robot = GetVizmo().GetEnv()->GetRobot(m_path.GetRobotIndex(0));
+
+  //The trace draws the robot at every m_displayInterval-th frame. Its
+  //transforms only change with the interval, and its colors with the gradient.
+  if(m_traceInterval != m_displayInterval) {
+    m_traceInterval = m_displayInterval;
+    m_traceTransforms.clear();
+    vector<double> cfg;
+    for(size_t i = m_displayInterval/2; i < m_path.size();
+        i += m_displayInterval) {
+      cfg.assign(m_path.GetData(i), m_path.GetData(i) + m_path.GetDOF(i));
+      m_robot->ConfigureRender(cfg);
+      m_robot->GetRenderTransforms(m_traceTransforms);
     }
   }
 
-  glEndList();
-
-  //set back
-  CfgModel::SetShape(tmp);
+  m_traceColors.clear();
+  for(size_t i = m_displayInterval/2; i < m_path.size(); i += m_displayInterval)
+    m_traceColors.push_back(GradientColor(i));
 }
 
 void
 PathModel::
 DrawRender() {
-  m_path[m_frame].DrawPathRobot();
+  if(m_frame < m_windowStart || m_frame >= m_windowStart + m_windowSize)
+    FillTransforms(m_frame);
+  m_robot->RestoreColor();
+  m_robot->SetRenderMode(SOLID_MODE);
+  m_robot->DrawRenderInstances(
+      &m_transforms[16 * m_numBodies * (m_frame - m_windowStart)], 1);
 
   if(m_renderMode == INVISIBLE_MODE)
     return; //not draw any thing else
 
   //set to line represnet
   glLineWidth(m_lineWidth);
-  glCallList(m_glPathIndex);
+  DrawTrace();
 }
 
 void
@@ -134,7 +124,16 @@ DrawSelect() {
 
   //set to line represnet
   glLineWidth(m_lineWidth);
-  glCallList(m_glPathIndex);
+  DrawTrace();
+}
+
+
+void
+PathModel::
+DrawTrace() {
+  m_robot->SetRenderMode(WIRE_MODE);
+  m_robot->DrawRenderInstances(m_traceTransforms.data(), m_traceColors.size(),
+      m_traceColors.data());
 }
 
 void
@@ -152,8 +151,52 @@ Mix(Color4& _a, Color4& _b, float _percent) {
 }
 
 
+Color4
+PathModel::
+GradientColor(size_t _frame) {
+  if(m_stopColors.size() < 2)
+    return m_stopColors[0];
+
+  //the path is split evenly between consecutive stop colors, and the frames
+  //left over at the end are given the last color
+  size_t numChunks = m_stopColors.size()-1;
+  size_t chunkSize = max<size_t>(m_path.size()/numChunks, 1);
+  size_t chunk = _frame/chunkSize;
+  size_t j = _frame%chunkSize;
+  if(chunk >= numChunks) {
+    chunk = numChunks-1;
+    j = chunkSize-1;
+  }
+  return Mix(m_stopColors[chunk], m_stopColors[chunk+1],
+      (float)j/(float)chunkSize);
+}
+
+
+void
+PathModel::
+FillTransforms(size_t _frame) {
+  //Most of the window lies ahead of the frame, but some is kept behind it for
+  //stepping backward.
+  m_windowStart = _frame > m_windowFrames / 4 ? _frame - m_windowFrames / 4 : 0;
+  m_windowSize = min(m_windowFrames, m_path.size() - m_windowStart);
+
+  m_transforms.clear();
+  vector<double> cfg;
+  for(size_t i = m_windowStart; i < m_windowStart + m_windowSize; ++i) {
+    cfg.assign(m_path.GetData(i), m_path.GetData(i) + m_path.GetDOF(i));
+    m_robot->ConfigureRender(cfg);
+    m_robot->GetRenderTransforms(m_transforms);
+  }
+  m_numBodies = m_transforms.size() / (16 * m_windowSize);
+}
+
+
 void
 PathModel::
 SavePath(const string& _filename) {
-  WritePath(_filename, m_path);
+  vector<CfgType> path;
+  path.reserve(m_path.size());
+  for(size_t i = 0; i < m_path.size(); ++i)
+    path.push_back(m_path[i]);
+  WritePath(_filename, path);
 }
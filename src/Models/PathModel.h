@@ -1,12 +1,17 @@
 #ifndef PATH_MODEL_H_
 #define PATH_MODEL_H_
 
+#include <memory>
+
 #include <Vector.h>
 using namespace mathtool;
 
+#include "CfgArray.h"
 #include "CfgModel.h"
 #include "Utilities/Color.h"
 
+class ActiveMultiBodyModel;
+
 class PathModel : public LoadableModel {
   public:
     PathModel(const string& _filename);
@@ -16,7 +21,7 @@ class PathModel : public LoadableModel {
 
     void SetLineWidth(float _width) {m_lineWidth = _width;}
     void SetDisplayInterval(int _disp) {m_displayInterval = _disp;}
-    const CfgModel& GetConfiguration(size_t _i) const {return m_path[_i];}
+    CfgModel GetConfiguration(size_t _i) const {return m_path[_i];}
 
     float GetLineWidth() {return m_lineWidth;}
     size_t GetDisplayInterval() {return m_displayInterval;}
@@ -35,10 +40,36 @@ class PathModel : public LoadableModel {
   private:
     Color4 Mix(Color4& _a, Color4& _b, float _percent);
 
-    vector<CfgModel> m_path; //path storage
-    size_t m_glPathIndex; //Display list index
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the gradient color of a frame.
+    Color4 GradientColor(size_t _frame);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Draw the robot at the trace frames in their gradient colors.
+    void DrawTrace();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Compute the robot's body transforms for the window of frames
+    ///        around a frame.
+    void FillTransforms(size_t _frame);
+
+    CfgArray m_path; //path storage
     size_t m_frame;          ///< Frame for playing path
 
+    //playback: body transforms of a window of frames, so that drawing a frame
+    //does not configure the robot
+    static const size_t m_windowFrames = 4096; ///< Frames computed at once.
+    shared_ptr<ActiveMultiBodyModel> m_robot;  ///< The robot of the path.
+    vector<GLfloat> m_transforms; ///< Body transforms of the window's frames.
+    size_t m_windowStart{0};      ///< The first frame of the window.
+    size_t m_windowSize{0};       ///< The number of frames in the window.
+    size_t m_numBodies{0};        ///< The number of bodies of the robot.
+
+    //trace: the robot drawn along the path at every m_displayInterval-th frame
+    size_t m_traceInterval{0};          ///< The interval of m_traceTransforms.
+    vector<GLfloat> m_traceTransforms;  ///< Body transforms of each copy.
+    vector<Color4> m_traceColors;       ///< Gradient color of each copy.
+
     //display options
     float m_lineWidth;
     size_t m_displayInterval;
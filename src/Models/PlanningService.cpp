@@ -0,0 +1,293 @@
+#include "PlanningService.h"
+
+#include <unordered_set>
+
+#include <QMutexLocker>
+
+#include "MapModel.h"
+#include "Vizmo.h"
+
+typedef MapModel<CfgModel, EdgeModel> MM;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Append a position to a float vertex array.
+static void
+PushPoint(vector<float>& _buffer, const Point3d& _p) {
+  _buffer.push_back(_p[0]);
+  _buffer.push_back(_p[1]);
+  _buffer.push_back(_p[2]);
+}
+
+/*------------------------------- Construction -------------------------------*/
+
+PlanningService::
+PlanningService(const string& _strategyLabel, int _sliceMs) :
+    QObject(), m_strategyLabel(_strategyLabel), m_sliceMs(_sliceMs) {
+}
+
+/*--------------------------------- Control ----------------------------------*/
+
+void
+PlanningService::
+Pause() {
+  m_paused = true;
+}
+
+
+void
+PlanningService::
+Resume() {
+  QMutexLocker lock(&m_pauseLock);
+  m_paused = false;
+  m_resumed.wakeAll();
+}
+
+
+void
+PlanningService::
+Cancel() {
+  QMutexLocker lock(&m_pauseLock);
+  m_canceled = true;
+  m_resumed.wakeAll();
+}
+
+
+PlanningService::Stats
+PlanningService::
+GetStats() const {
+  Stats s;
+  s.m_vertices = m_statVertices;
+  s.m_edges = m_statEdges;
+  s.m_ccs = m_statCCs;
+  s.m_verticesPerSecond = m_statVertexRate;
+  s.m_edgesPerSecond = m_statEdgeRate;
+  s.m_ccsPerSecond = m_statCCRate;
+  s.m_iterations = m_statIterations;
+  return s;
+}
+
+/*------------------------------ Planner Thread ------------------------------*/
+
+void
+PlanningService::
+Run() {
+  //The map model is current when planning starts
+  Synchronize();
+  m_sliceTimer.start();
+
+  bool completed = GetVizmo().Solve(m_strategyLabel);
+
+  //Solve refreshed the map model, so the renderer can drop its copy
+  Delta reset;
+  reset.m_reset = true;
+  m_deltas.Push(move(reset));
+  emit Finished(!completed);
+}
+
+
+void
+PlanningService::
+Checkpoint() {
+  ++m_iterations;
+  if(!m_checkpointed) {
+    m_checkpointed = true;
+    emit Checkpointed();
+  }
+  if(m_canceled)
+    throw PlanningCanceled();
+
+  if(m_sliceTimer.elapsed() >= m_sliceMs)
+    Publish();
+
+  if(!m_paused)
+    return;
+
+  //Show the whole roadmap in the map model while planning waits
+  Synchronize();
+  emit Progress();
+  {
+    QMutexLocker lock(&m_pauseLock);
+    while(m_paused && !m_canceled)
+      m_resumed.wait(&m_pauseLock);
+  }
+  if(m_canceled)
+    throw PlanningCanceled();
+  m_sliceTimer.restart();
+}
+
+
+void
+PlanningService::
+Publish() {
+  MM::RGraph* g = GetVizmo().GetMap()->GetGraph();
+  double seconds = m_sliceTimer.restart() / 1000.;
+
+  //Collect the vertices added since the last slice. VIDs are handed out in
+  //increasing order, so they all follow the last one published.
+  MM::VI vi = g->begin();
+  if(m_lastVID != VID(-1)) {
+    vi = g->find_vertex(m_lastVID);
+    if(vi == g->end()) {
+      Synchronize();
+      emit Progress();
+      return;
+    }
+    ++vi;
+  }
+  vector<VID> added;
+  unordered_set<VID> isAdded;
+  for(; vi != g->end(); ++vi) {
+    added.push_back(vi->descriptor());
+    isAdded.insert(vi->descriptor());
+  }
+
+  //Take every edge leaving a new vertex plus the reverse edges into it, and
+  //draw each pair once
+  Delta delta;
+  size_t addedEdges = 0;
+  for(auto& vid : added) {
+    m_parent[vid] = vid;
+    ++m_numCCs;
+  }
+  for(auto& vid : added) {
+    MM::VI v = g->find_vertex(vid);
+    const Point3d p = v->property().GetPoint();
+    PushPoint(delta.m_points, p);
+    for(MM::EI ei = v->begin(); ei != v->end(); ++ei) {
+      VID target = (*ei).target();
+      bool reverse = g->IsEdge(target, vid);
+      ++addedEdges;
+      if(!isAdded.count(target) && reverse)
+        ++addedEdges;
+      if(isAdded.count(target) && reverse && target < vid)
+        continue;
+      PushPoint(delta.m_lines, p);
+      PushPoint(delta.m_lines, g->find_vertex(target)->property().GetPoint());
+      Union(vid, target);
+    }
+  }
+
+  //Anything else, such as a deletion or an edge between two old vertices,
+  //shows up as a count mismatch and is handed to the map model instead
+  if(g->get_num_vertices() != m_numVertices + added.size() ||
+      g->get_num_edges() != m_numEdges + addedEdges) {
+    Synchronize();
+    emit Progress();
+    return;
+  }
+
+  if(!added.empty())
+    m_lastVID = added.back();
+  m_numVertices += added.size();
+  m_numEdges += addedEdges;
+  m_deltas.Push(move(delta));
+  UpdateStats(seconds);
+  emit Progress();
+}
+
+
+void
+PlanningService::
+Synchronize() {
+  MM* map = GetVizmo().GetMap();
+  map->RefreshMap();
+  MM::RGraph* g = map->GetGraph();
+
+  m_parent.clear();
+  m_numCCs = 0;
+  m_lastVID = VID(-1);
+  for(MM::VI vi = g->begin(); vi != g->end(); ++vi) {
+    m_parent[vi->descriptor()] = vi->descriptor();
+    ++m_numCCs;
+    m_lastVID = vi->descriptor();
+  }
+  for(MM::VI vi = g->begin(); vi != g->end(); ++vi)
+    for(MM::EI ei = vi->begin(); ei != vi->end(); ++ei)
+      Union(vi->descriptor(), (*ei).target());
+  m_numVertices = g->get_num_vertices();
+  m_numEdges = g->get_num_edges();
+
+  Delta reset;
+  reset.m_reset = true;
+  m_deltas.Push(move(reset));
+  UpdateStats(m_sliceTimer.isValid() ? m_sliceTimer.restart() / 1000. : 0);
+}
+
+
+void
+PlanningService::
+UpdateStats(double _seconds) {
+  //Roadmap edges are stored in both directions
+  size_t edges = m_numEdges / 2;
+  if(_seconds > 0) {
+    m_statVertexRate = (double(m_numVertices) - m_sliceVertices) / _seconds;
+    m_statEdgeRate = (double(edges) - m_sliceEdges) / _seconds;
+    m_statCCRate = (double(m_numCCs) - m_sliceCCs) / _seconds;
+  }
+  m_sliceVertices = m_numVertices;
+  m_sliceEdges = edges;
+  m_sliceCCs = m_numCCs;
+
+  m_statVertices = m_numVertices;
+  m_statEdges = edges;
+  m_statCCs = m_numCCs;
+  m_statIterations = m_iterations;
+}
+
+/*--------------------------- Connected Components ---------------------------*/
+
+PlanningService::VID
+PlanningService::
+Find(VID _v) {
+  VID root = _v;
+  while(m_parent[root] != root)
+    root = m_parent[root];
+  while(m_parent[_v] != root) {
+    VID next = m_parent[_v];
+    m_parent[_v] = root;
+    _v = next;
+  }
+  return root;
+}
+
+
+void
+PlanningService::
+Union(VID _u, VID _v) {
+  VID a = Find(_u), b = Find(_v);
+  if(a == b)
+    return;
+  m_parent[b] = a;
+  --m_numCCs;
+}
+
+/*--------------------------------- Renderer ---------------------------------*/
+
+void
+PlanningService::
+DrawRender() {
+  Delta delta;
+  while(m_deltas.Pop(delta)) {
+    if(delta.m_reset) {
+      m_points.clear();
+      m_lines.clear();
+    }
+    m_points.insert(m_points.end(), delta.m_points.begin(),
+        delta.m_points.end());
+    m_lines.insert(m_lines.end(), delta.m_lines.begin(), delta.m_lines.end());
+  }
+  if(m_points.empty() && m_lines.empty())
+    return;
+
+  glDisable(GL_LIGHTING);
+  glColor3f(.5, .5, .5);
+  glPointSize(CfgModel::GetPointSize());
+  glLineWidth(EdgeModel::m_edgeThickness);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, GL_FLOAT, 0, m_points.data());
+  glDrawArrays(GL_POINTS, 0, m_points.size() / 3);
+  glVertexPointer(3, GL_FLOAT, 0, m_lines.data());
+  glDrawArrays(GL_LINES, 0, m_lines.size() / 3);
+  glDisableClientState(GL_VERTEX_ARRAY);
+  glEnable(GL_LIGHTING);
+}
@@ -0,0 +1,197 @@
+#ifndef PLANNING_SERVICE_H_
+#define PLANNING_SERVICE_H_
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <unordered_map>
+#include <vector>
+using namespace std;
+
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QObject>
+#include <QWaitCondition>
+
+#include "Utilities/LockFreeQueue.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Thrown from PlanningService::Checkpoint to unwind a strategy which
+///        was canceled.
+////////////////////////////////////////////////////////////////////////////////
+struct PlanningCanceled {};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief   Runs an MPStrategy on a worker thread which the GUI can pause,
+///          resume, and cancel, and streams the growing roadmap to the
+///          renderer.
+/// \details Strategies call Vizmo::PlanningCheckpoint after each iteration,
+///          which lands in Checkpoint. Iterations are grouped into slices of
+///          a fixed duration. At the end of each slice the vertices and edges
+///          added since the last one are pushed onto a lock-free queue, the
+///          throughput counters are updated, and Progress is emitted. The
+///          renderer drains the queue in DrawRender, so the map model is only
+///          refreshed when planning pauses, ends, or makes a change which is
+///          not a plain addition. Pause and cancel requests are honored at the
+///          next checkpoint; a canceled strategy is unwound by throwing
+///          PlanningCanceled and skips its Finalize. Strategies which never
+///          reach a checkpoint never emit Checkpointed, and cannot be paused
+///          or canceled.
+////////////////////////////////////////////////////////////////////////////////
+class PlanningService : public QObject {
+
+  Q_OBJECT
+
+  public:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Throughput counters. Totals are for the whole roadmap, rates are
+    ///        over the last slice.
+    struct Stats {
+      size_t m_vertices{0};        ///< Number of roadmap vertices.
+      size_t m_edges{0};           ///< Number of undirected roadmap edges.
+      size_t m_ccs{0};             ///< Number of connected components.
+      double m_verticesPerSecond{0}; ///< Samples added per second.
+      double m_edgesPerSecond{0};  ///< Edges added per second.
+      double m_ccsPerSecond{0};    ///< Change in the CC count per second.
+      size_t m_iterations{0};      ///< Strategy iterations so far.
+    };
+
+    ///\name Construction
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \param[in] _strategyLabel The label of the strategy to run.
+    /// \param[in] _sliceMs The length of a slice in milliseconds.
+    PlanningService(const string& _strategyLabel, int _sliceMs = 100);
+
+    ///@}
+    ///\name Control
+    ///@{
+    /// These may be called from any thread.
+
+    void Pause();  ///< Stop at the next checkpoint until resumed.
+    void Resume(); ///< Continue after a pause.
+    void Cancel(); ///< Stop at the next checkpoint and skip Finalize.
+
+    bool IsPaused() const {return m_paused;}
+    bool IsCanceled() const {return m_canceled;}
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the counters as of the last slice.
+    Stats GetStats() const;
+
+    ///@}
+    ///\name Planner Thread
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief End an iteration: publish the slice if it is over, then wait
+    ///        out a pause.
+    /// \throws PlanningCanceled if planning was canceled.
+    void Checkpoint();
+
+    ///@}
+    ///\name Renderer
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Take the published changes and draw the part of the roadmap
+    ///        which the map model does not show yet.
+    void DrawRender();
+
+    ///@}
+
+  public slots:
+
+    void Run(); ///< Run the strategy. Connect to the thread's start.
+
+  signals:
+
+    void Progress();                 ///< A slice was published.
+    void Checkpointed();             ///< The first checkpoint was reached.
+    void Finished(bool _canceled);   ///< The strategy has returned.
+
+  private:
+
+    typedef size_t VID;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief The roadmap changes of one slice, as vertex positions and edge
+    ///        segments.
+    struct Delta {
+      bool m_reset{false};     ///< Does the map model now show everything?
+      vector<float> m_points;  ///< New vertex positions.
+      vector<float> m_lines;   ///< New edge endpoints, in pairs.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Publish the changes since the last slice and update the
+    ///        counters.
+    void Publish();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Refresh the map model, restart change tracking from the whole
+    ///        roadmap, and tell the renderer to drop what it has.
+    void Synchronize();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Update the counters after a slice of \p _seconds.
+    void UpdateStats(double _seconds);
+
+    ///\name Connected Components
+    ///@{
+    /// A disjoint set forest over the VIDs, kept up to date from the changes
+    /// found by Publish.
+
+    VID Find(VID _v);
+    void Union(VID _u, VID _v);
+
+    unordered_map<VID, VID> m_parent; ///< Parent of each vertex in the forest.
+    size_t m_numCCs{0};               ///< Number of trees in the forest.
+
+    ///@}
+
+    string m_strategyLabel;   ///< The label of the strategy to run.
+    int m_sliceMs;            ///< The length of a slice.
+
+    atomic<bool> m_paused{false};    ///< Was a pause requested?
+    atomic<bool> m_canceled{false};  ///< Was a cancel requested?
+    QMutex m_pauseLock;              ///< Guards waiting out a pause.
+    QWaitCondition m_resumed;        ///< Signaled on resume and cancel.
+
+    ///\name Change Tracking
+    ///@{
+    /// Owned by the planner thread.
+
+    QElapsedTimer m_sliceTimer;      ///< Time since the slice started.
+    VID m_lastVID{VID(-1)};          ///< The last vertex published.
+    size_t m_numVertices{0};         ///< Vertices published.
+    size_t m_numEdges{0};            ///< Directed edges published.
+    size_t m_iterations{0};          ///< Iterations so far.
+    bool m_checkpointed{false};      ///< Was Checkpointed emitted?
+    size_t m_sliceVertices{0};       ///< Vertices at the slice start.
+    size_t m_sliceEdges{0};          ///< Directed edges at the slice start.
+    size_t m_sliceCCs{0};            ///< CCs at the slice start.
+
+    ///@}
+    ///\name Counters
+    ///@{
+    /// Written by the planner thread at the end of each slice.
+
+    atomic<size_t> m_statVertices{0}, m_statEdges{0}, m_statCCs{0},
+        m_statIterations{0};
+    atomic<double> m_statVertexRate{0}, m_statEdgeRate{0}, m_statCCRate{0};
+
+    ///@}
+    ///\name Renderer State
+    ///@{
+
+    LockFreeQueue<Delta> m_deltas; ///< Published changes, oldest first.
+    vector<float> m_points;        ///< Vertices drawn by the renderer.
+    vector<float> m_lines;         ///< Edges drawn by the renderer.
+
+    ///@}
+};
+
+#endif
@@ -1,6 +1,7 @@
 #include "PolyhedronModel.h"
 
 #include <cmath>
+#include <cstdlib>
 #include <algorithm>
 #include <numeric>
 
@@ -9,55 +10,81 @@
 
 #include "Utilities/VizmoExceptions.h"
 
+map<PolyhedronModel::MeshKey, weak_ptr<PolyhedronModel::Mesh>>
+PolyhedronModel::m_meshCache;
+mutex PolyhedronModel::m_meshCacheLock;
+
 PolyhedronModel::PolyhedronModel(const string& _filename,
     GMSPolyhedron::COMAdjust _comAdjust)
   : Model(_filename), m_filename(_filename),
-  m_numVerts(0), m_solidID(0), m_wiredID(0), m_normalsID(0),
-  m_comAdjust(_comAdjust) {
+  m_path(CanonicalPath(_filename)), m_comAdjust(_comAdjust) {
     Build();
   }
 
 PolyhedronModel::PolyhedronModel(const PolyhedronModel& _p) : Model(_p),
-  m_filename(_p.m_filename), m_comAdjust(_p.m_comAdjust) {
-    Build();
+  m_filename(_p.m_filename), m_path(_p.m_path), m_comAdjust(_p.m_comAdjust),
+  m_mesh(_p.m_mesh) {
+  }
+
+void
+PolyhedronModel::Build() {
+  MeshKey key(m_path, m_comAdjust);
+  {
+    lock_guard<mutex> lock(m_meshCacheLock);
+    auto cached = m_meshCache.find(key);
+    if(cached != m_meshCache.end() && (m_mesh = cached->second.lock()))
+      return;
   }
 
-PolyhedronModel::~PolyhedronModel(){
-  glDeleteLists(m_wiredID, 1);
-  glDeleteLists(m_solidID, 1);
-  glDeleteLists(m_normalsID, 1);
+  //load outside the lock, keeping the first copy if another load won the race
+  m_mesh = make_shared<Mesh>();
+  BuildMesh();
+
+  lock_guard<mutex> lock(m_meshCacheLock);
+  weak_ptr<Mesh>& cached = m_meshCache[key];
+  if(shared_ptr<Mesh> mesh = cached.lock())
+    m_mesh = mesh;
+  else
+    cached = m_mesh;
+
+  //entries expire with the last model using them; drop those on each load
+  for(auto it = m_meshCache.begin(); it != m_meshCache.end();)
+    if(it->second.expired())
+      it = m_meshCache.erase(it);
+    else
+      ++it;
 }
 
 void
-PolyhedronModel::Build() {
+PolyhedronModel::
+BuildMesh() {
 
   IModel* imodel = CreateModelLoader(m_filename, false);
 
-  bool isObj = m_filename.substr(m_filename.rfind('.'),
-      m_filename.length()) == ".obj" && !imodel->GetNormals().empty();
-
   if(!imodel)
     throw BuildException(WHERE, "File '" + m_filename + "' does not exist.");
 
+  bool isObj = m_filename.substr(m_filename.rfind('.'),
+      m_filename.length()) == ".obj" && !imodel->GetNormals().empty();
+
   const PtVector& points = imodel->GetVertices();
-  m_numVerts = points.size();
+  m_mesh->m_numVerts = points.size();
 
   //compute center of mass and radius
   COM(points);
   Radius(points);
 
-  //build all rendering call lists
+  //build all vertex arrays
   vector<Vector3d> normals;
+  vector<GLuint> pointVertex;
   ComputeNormals(imodel, normals);
-  if(isObj) {
-    BuildSolidObj(imodel);
-    BuildNormalsObj(imodel);
-  }
-  else {
-    BuildSolidBYU(imodel, normals);
-    BuildNormalsBYU(imodel, normals);
-  }
-  BuildWired(imodel, normals);
+  m_mesh->m_smooth = isObj;
+  m_mesh->m_normalLines.clear();
+  if(isObj)
+    BuildSolidObj(imodel, pointVertex);
+  else
+    BuildSolidBYU(imodel, normals, pointVertex);
+  BuildWired(imodel, normals, pointVertex);
 
   delete imodel;
 }
@@ -65,40 +92,40 @@ PolyhedronModel::Build() {
 void
 PolyhedronModel::
 DrawRender() {
-  if(m_solidID == 0 || m_renderMode == INVISIBLE_MODE)
+  if(m_mesh->m_solidIndices.empty() || m_renderMode == INVISIBLE_MODE)
     return;
 
   if(m_renderMode == SOLID_MODE){
     glEnable(GL_POLYGON_OFFSET_FILL);
     glPolygonOffset(2.0, 2.0);
     glEnable(GL_NORMALIZE);
-    glCallList(m_solidID);
+    DrawSolid();
     glDisable(GL_NORMALIZE);
     glDisable(GL_POLYGON_OFFSET_FILL);
   }
   else
-    glCallList(m_wiredID);
+    DrawWired();
 }
 
 void
 PolyhedronModel::
 DrawSelect() {
-  if(m_solidID == 0 || m_renderMode == INVISIBLE_MODE)
+  if(m_mesh->m_solidIndices.empty() || m_renderMode == INVISIBLE_MODE)
     return;
 
-  glCallList(m_solidID);
+  DrawSolid();
 }
 
 void
 PolyhedronModel::
 DrawSelected() {
-  glCallList(m_wiredID);
+  DrawWired();
 }
 
 void
 PolyhedronModel::
 DrawHaptics() {
-  glCallList(m_solidID);
+  DrawSolid();
 }
 
 void
@@ -110,324 +137,337 @@ Print(ostream& _os) const {
 void
 PolyhedronModel::
 DrawNormals() {
-  if(m_showNormals)
-    glCallList(m_normalsID);
-}
+  if(!m_showNormals)
+    return;
 
-void
-PolyhedronModel::
-BuildSolidObj(IModel* _model) {
-  m_solidID = glGenLists(1);
-  glNewList(m_solidID, GL_COMPILE);
+  if(m_mesh->m_normalLines.empty())
+    BuildNormals();
 
-  glEnable(GL_LIGHTING);
+  glDisable(GL_LIGHTING);
+  glMatrixMode(GL_MODELVIEW);
   glPushMatrix();
+  AdjustCOM();
 
+  //lines are stored as (start, end) pairs; the points mark each end
+  glColor3f(0, 1, 0);
+  glLineWidth(2);
+  glPointSize(4);
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, GL_FLOAT, 0, m_mesh->m_normalLines.data());
+  glDrawArrays(GL_LINES, 0, m_mesh->m_normalLines.size() / 3);
+  glVertexPointer(3, GL_FLOAT, 6 * sizeof(GLfloat), &m_mesh->m_normalLines[3]);
+  glDrawArrays(GL_POINTS, 0, m_mesh->m_normalLines.size() / 6);
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  glPopMatrix();
+}
+
+Point3d
+PolyhedronModel::
+GetCenter() const {
+  const Point3d& com = m_mesh->m_com;
   switch(m_comAdjust) {
     case GMSPolyhedron::COMAdjust::COM:
-      glTranslated(-m_com[0], -m_com[1], -m_com[2]);
-      break;
+      return Point3d();
     case GMSPolyhedron::COMAdjust::Surface:
-      glTranslated(-m_com[0], 0, -m_com[2]);
-      break;
+      return Point3d(0, com[1], 0);
     case GMSPolyhedron::COMAdjust::None:
     default:
-      break;
-  }
-
-  PtVector& points = _model->GetVertices();
-  vector<Vector3d>& normals = _model->GetNormals();
-  vector<Vector2d>& textures = _model->GetTextureCoords();
-  const TriVector& triP = _model->GetTriP();
-  const TriVector& triN = _model->GetTriN();
-  const TriVector& triT = _model->GetTriT();
-
-  //draw
-  glBegin(GL_TRIANGLES);
-  for(size_t i = 0; i < triP.size(); ++i) {
-    for(size_t j = 0; j < 3; j++) {
-      if(!textures.empty())
-        glTexCoord2dv(textures[triT[i][j]]);
-      glNormal3dv(normals[triN[i][j]]);
-      glVertex3dv(points[triP[i][j]]);
-    }
+      return com;
   }
-  glEnd();
-
-  glPopMatrix();
-  glEndList();
 }
 
-//build models, given points and triangles
-void
+string
 PolyhedronModel::
-ComputeNormals(IModel* _model, vector<Vector3d>& _norms) {
-
-  const PtVector& points = _model->GetVertices();
-  const TriVector& tris = _model->GetTriP();
-
-  _norms.clear();
-  _norms.reserve(tris.size());
-  for(auto& tri : tris) {
-    Vector3d v1 = points[tri[1]] - points[tri[0]];
-    Vector3d v2 = points[tri[2]] - points[tri[0]];
-    _norms.emplace_back((v1%v2).normalize());
-  }
+CanonicalPath(const string& _filename) {
+  char* path = realpath(_filename.c_str(), NULL);
+  if(!path)
+    return _filename;
+  string canonical(path);
+  free(path);
+  return canonical;
 }
 
 void
 PolyhedronModel::
-BuildSolidBYU(IModel* _model, const vector<Vector3d>& _norms) {
-
-  m_solidID = glGenLists(1);
-  glNewList(m_solidID, GL_COMPILE);
-
-  glEnable(GL_LIGHTING);
-  glPushMatrix();
-
+AdjustCOM() const {
   switch(m_comAdjust) {
     case GMSPolyhedron::COMAdjust::COM:
-      glTranslated(-m_com[0], -m_com[1], -m_com[2]);
+      glTranslated(-m_mesh->m_com[0], -m_mesh->m_com[1], -m_mesh->m_com[2]);
       break;
     case GMSPolyhedron::COMAdjust::Surface:
-      glTranslated(-m_com[0], 0, -m_com[2]);
+      glTranslated(-m_mesh->m_com[0], 0, -m_mesh->m_com[2]);
       break;
     case GMSPolyhedron::COMAdjust::None:
     default:
       break;
   }
+}
 
-  const PtVector& points = _model->GetVertices();
-  const TriVector& tris = _model->GetTriP();
+void
+PolyhedronModel::
+DrawSolid() const {
+  if(m_mesh->m_solidIndices.empty())
+    return;
 
-  //draw
-  glBegin(GL_TRIANGLES);
-  typedef TriVector::const_iterator TRIT;
-  for(TRIT trit = tris.begin(); trit != tris.end(); ++trit) {
-    const Tri& tri = *trit;
-    glNormal3dv(_norms[trit - tris.begin()]);
-    for(int i=0; i < 3; i++)
-      glVertex3dv(points[tri[i]]);
+  glEnable(GL_LIGHTING);
+  glPushMatrix();
+  AdjustCOM();
+
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glEnableClientState(GL_NORMAL_ARRAY);
+  glVertexPointer(3, GL_FLOAT, sizeof(Vertex), m_mesh->m_vertices[0].m_position);
+  glNormalPointer(GL_FLOAT, sizeof(Vertex), m_mesh->m_vertices[0].m_normal);
+  if(m_mesh->m_textured) {
+    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), m_mesh->m_vertices[0].m_texture);
   }
-  glEnd();
+
+  glDrawElements(GL_TRIANGLES, m_mesh->m_solidIndices.size(), GL_UNSIGNED_INT,
+      m_mesh->m_solidIndices.data());
+
+  if(m_mesh->m_textured)
+    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+  glDisableClientState(GL_NORMAL_ARRAY);
+  glDisableClientState(GL_VERTEX_ARRAY);
 
   glPopMatrix();
-  glEndList();
 }
 
 void
 PolyhedronModel::
-BuildNormalsObj(IModel* _model) {
-  m_normalsID = glGenLists(1);
-  glNewList(m_normalsID, GL_COMPILE);
+DrawWired() const {
+  if(m_mesh->m_wiredIndices.empty())
+    return;
 
   glDisable(GL_LIGHTING);
   glMatrixMode(GL_MODELVIEW);
   glPushMatrix();
+  AdjustCOM();
 
-  switch(m_comAdjust) {
-    case GMSPolyhedron::COMAdjust::COM:
-      glTranslated(-m_com[0], -m_com[1], -m_com[2]);
-      break;
-    case GMSPolyhedron::COMAdjust::Surface:
-      glTranslated(-m_com[0], 0, -m_com[2]);
-      break;
-    case GMSPolyhedron::COMAdjust::None:
-    default:
-      break;
+  glEnableClientState(GL_VERTEX_ARRAY);
+  glVertexPointer(3, GL_FLOAT, sizeof(Vertex), m_mesh->m_vertices[0].m_position);
+  glDrawElements(GL_LINES, m_mesh->m_wiredIndices.size(), GL_UNSIGNED_INT,
+      m_mesh->m_wiredIndices.data());
+  glDisableClientState(GL_VERTEX_ARRAY);
+
+  glPopMatrix();
+}
+
+PolyhedronModel::Vertex
+PolyhedronModel::
+MakeVertex(const Point3d& _p, const Vector3d& _n, const Vector2d& _t) {
+  Vertex v;
+  for(size_t i = 0; i < 3; ++i) {
+    v.m_position[i] = _p[i];
+    v.m_normal[i] = _n[i];
   }
+  v.m_texture[0] = _t[0];
+  v.m_texture[1] = _t[1];
+  return v;
+}
 
-  PtVector& points = _model->GetVertices();
-  vector<Vector3d>& normals = _model->GetNormals();
+void
+PolyhedronModel::
+BuildSolidObj(IModel* _model, vector<GLuint>& _pointVertex) {
+  const PtVector& points = _model->GetVertices();
+  const vector<Vector3d>& normals = _model->GetNormals();
+  const vector<Vector2d>& textures = _model->GetTextureCoords();
   const TriVector& triP = _model->GetTriP();
   const TriVector& triN = _model->GetTriN();
+  const TriVector& triT = _model->GetTriT();
 
-  //draw
-  glColor3f(0, 1, 0);
-  glLineWidth(2);
-  glBegin(GL_LINES);
-  for(size_t i = 0; i < triP.size(); ++i) {
-    for(size_t j = 0; j < 3; ++j) {
-      const Vector3d& norm = normals[triN[i][j]];
-      Point3d start = points[triP[i][j]];
-      Point3d end = start + norm.normalize();
+  m_mesh->m_textured = !textures.empty();
 
-      glVertex3dv(start);
-      glVertex3dv(end);
-    }
-  }
-  glEnd();
+  //A corner reuses the first vertex built at its point when its normal and
+  //texture coordinate match; otherwise it gets its own vertex.
+  const GLuint none = GLuint(-1);
+  _pointVertex.assign(points.size(), none);
+  vector<pair<int, int>> attributes(points.size());
+
+  m_mesh->m_vertices.clear();
+  m_mesh->m_vertices.reserve(points.size());
+  m_mesh->m_solidIndices.clear();
+  m_mesh->m_solidIndices.reserve(3 * triP.size());
 
-  glPointSize(4);
-  glBegin(GL_POINTS);
   for(size_t i = 0; i < triP.size(); ++i) {
     for(size_t j = 0; j < 3; ++j) {
-      const Vector3d& norm = normals[triN[i][j]];
-      Point3d start = points[triP[i][j]];
-      Point3d end = start + norm.normalize();
-
-      glVertex3dv(end);
+      int p = triP[i][j];
+      pair<int, int> attribute(triN[i][j], m_mesh->m_textured ? triT[i][j] : -1);
+
+      GLuint& first = _pointVertex[p];
+      if(first != none && attributes[p] == attribute) {
+        m_mesh->m_solidIndices.push_back(first);
+        continue;
+      }
+
+      GLuint v = m_mesh->m_vertices.size();
+      m_mesh->m_vertices.push_back(m_mesh->m_textured ?
+          MakeVertex(points[p], normals[attribute.first],
+            textures[attribute.second]) :
+          MakeVertex(points[p], normals[attribute.first]));
+      m_mesh->m_solidIndices.push_back(v);
+      if(first == none) {
+        first = v;
+        attributes[p] = attribute;
+      }
     }
   }
-  glEnd();
-
-
-  glPopMatrix();
-  glEndList();
 }
 
+//build models, given points and triangles
 void
 PolyhedronModel::
-BuildNormalsBYU(IModel* _model, const vector<Vector3d>& _norms) {
-  m_normalsID = glGenLists(1);
-  glNewList(m_normalsID, GL_COMPILE);
-
-  glDisable(GL_LIGHTING);
-  glMatrixMode(GL_MODELVIEW);
-  glPushMatrix();
-
-  switch(m_comAdjust) {
-    case GMSPolyhedron::COMAdjust::COM:
-      glTranslated(-m_com[0], -m_com[1], -m_com[2]);
-      break;
-    case GMSPolyhedron::COMAdjust::Surface:
-      glTranslated(-m_com[0], 0, -m_com[2]);
-      break;
-    case GMSPolyhedron::COMAdjust::None:
-    default:
-      break;
-  }
+ComputeNormals(IModel* _model, vector<Vector3d>& _norms) {
 
   const PtVector& points = _model->GetVertices();
   const TriVector& tris = _model->GetTriP();
 
-  //draw
-  glColor3f(0, 1, 0);
-  glLineWidth(2);
-  glBegin(GL_LINES);
-  typedef TriVector::const_iterator TRIT;
-  for(TRIT trit = tris.begin(); trit != tris.end(); ++trit) {
-    const Tri& tri = *trit;
-    const Vector3d& norm = _norms[distance(tris.begin(), trit)];
-    Point3d center = (points[tri[0]] + points[tri[1]] + points[tri[2]])/3;
-    Point3d endp = center + norm.normalize();
-
-    glVertex3dv(center);
-    glVertex3dv(endp);
-  }
-  glEnd();
-
-  glPointSize(4);
-  glBegin(GL_POINTS);
-  typedef TriVector::const_iterator TRIT;
-  for(TRIT trit = tris.begin(); trit != tris.end(); ++trit) {
-    const Tri& tri = *trit;
-    const Vector3d& norm = _norms[distance(tris.begin(), trit)];
-    Point3d center = (points[tri[0]] + points[tri[1]] + points[tri[2]])/3;
-    Point3d endp = center + norm.normalize();
-
-    glVertex3dv(endp);
+  _norms.clear();
+  _norms.reserve(tris.size());
+  for(auto& tri : tris) {
+    Vector3d v1 = points[tri[1]] - points[tri[0]];
+    Vector3d v2 = points[tri[2]] - points[tri[0]];
+    _norms.emplace_back((v1%v2).normalize());
   }
-  glEnd();
-
-  glPopMatrix();
-  glEndList();
 }
 
-//compute the model graph for wire frame
 void
 PolyhedronModel::
-BuildModelGraph(IModel* _model) {
+BuildSolidBYU(IModel* _model, const vector<Vector3d>& _norms,
+    vector<GLuint>& _pointVertex) {
+
   const PtVector& points = _model->GetVertices();
   const TriVector& tris = _model->GetTriP();
 
-  //create nodes
-  for(size_t i = 0; i < points.size(); ++i)
-    m_modelGraph.add_vertex(i, i);
+  m_mesh->m_textured = false;
+
+  //Faces are flat shaded, so every corner needs its own vertex.
+  _pointVertex.assign(points.size(), GLuint(-1));
+  m_mesh->m_vertices.clear();
+  m_mesh->m_vertices.reserve(3 * tris.size());
+  m_mesh->m_solidIndices.clear();
+  m_mesh->m_solidIndices.reserve(3 * tris.size());
 
-  //create edge from triangles
   for(size_t i = 0; i < tris.size(); ++i) {
     for(size_t j = 0; j < 3; ++j) {
-      int a = tris[i][j];
-      int b = tris[i][(j+1)%3];
-      //see if edge (a, b) exists
-      ModelGraph::vertex_iterator vit;
-      ModelGraph::adj_edge_iterator eit;
-      ModelGraph::edge_descriptor eid(a, b);
-      bool found = m_modelGraph.find_edge(eid, vit, eit);
-
-      if(found) //set the right triangle
-        (*eit).property()[1] = i;
-      else //add new edge and set left triangle
-        m_modelGraph.add_edge(a, b, Vector<int, 2>(i, -1));
+      int p = tris[i][j];
+      GLuint v = m_mesh->m_vertices.size();
+      if(_pointVertex[p] == GLuint(-1))
+        _pointVertex[p] = v;
+      m_mesh->m_vertices.push_back(MakeVertex(points[p], _norms[i]));
+      m_mesh->m_solidIndices.push_back(v);
     }
   }
 }
 
 void
 PolyhedronModel::
-BuildWired(IModel* _model, const vector<Vector3d>& _norms) {
-
-  //create model graph
-  BuildModelGraph(_model);
+BuildNormals() {
+  size_t numLines = m_mesh->m_smooth ? m_mesh->m_vertices.size() : m_mesh->m_solidIndices.size() / 3;
+  m_mesh->m_normalLines.clear();
+  m_mesh->m_normalLines.reserve(6 * numLines);
+
+  for(size_t i = 0; i < numLines; ++i) {
+    //vertex normals start at the vertex, face normals at the face center
+    Vector3d start, norm;
+    if(m_mesh->m_smooth) {
+      start = m_mesh->m_vertices[i].Position();
+      norm = m_mesh->m_vertices[i].Normal();
+    }
+    else {
+      const GLuint* tri = &m_mesh->m_solidIndices[3 * i];
+      start = (m_mesh->m_vertices[tri[0]].Position() + m_mesh->m_vertices[tri[1]].Position() +
+          m_mesh->m_vertices[tri[2]].Position()) / 3;
+      norm = m_mesh->m_vertices[tri[0]].Normal();
+    }
+    Vector3d end = start + norm.normalize();
 
-  //build model
-  m_wiredID = glGenLists(1);
-  glNewList(m_wiredID, GL_COMPILE);
+    for(size_t j = 0; j < 3; ++j)
+      m_mesh->m_normalLines.push_back(start[j]);
+    for(size_t j = 0; j < 3; ++j)
+      m_mesh->m_normalLines.push_back(end[j]);
+  }
+}
 
-  glDisable(GL_LIGHTING);
-  glMatrixMode(GL_MODELVIEW);
-  glPushMatrix();
+//compute the mesh edges for wire frame
+void
+PolyhedronModel::
+BuildEdges(IModel* _model, vector<MeshEdge>& _edges) {
+  const TriVector& tris = _model->GetTriP();
 
-  switch(m_comAdjust) {
-    case GMSPolyhedron::COMAdjust::COM:
-      glTranslated(-m_com[0], -m_com[1], -m_com[2]);
-      break;
-    case GMSPolyhedron::COMAdjust::Surface:
-      glTranslated(-m_com[0], 0, -m_com[2]);
-      break;
-    case GMSPolyhedron::COMAdjust::None:
-    default:
-      break;
+  //list every triangle side under its sorted endpoint pair; sorting brings
+  //the sides of each edge together, in triangle order
+  typedef pair<uint64_t, int> Side;
+  vector<Side> sides;
+  sides.reserve(3 * tris.size());
+  for(size_t i = 0; i < tris.size(); ++i) {
+    for(size_t j = 0; j < 3; ++j) {
+      uint64_t a = uint32_t(tris[i][j]);
+      uint64_t b = uint32_t(tris[i][(j+1)%3]);
+      if(a > b)
+        swap(a, b);
+      sides.emplace_back(a << 32 | b, i);
+    }
   }
+  sort(sides.begin(), sides.end());
+
+  //the first triangle of an edge is its left side and the last its right
+  _edges.clear();
+  for(size_t i = 0; i < sides.size();) {
+    size_t j = i;
+    while(j + 1 < sides.size() && sides[j + 1].first == sides[i].first)
+      ++j;
+
+    MeshEdge e;
+    e.m_source = sides[i].first >> 32;
+    e.m_target = sides[i].first & 0xffffffff;
+    e.m_left = sides[i].second;
+    e.m_right = j > i ? sides[j].second : -1;
+    _edges.push_back(e);
+
+    i = j + 1;
+  }
+}
 
-  const PtVector& points = _model->GetVertices();
+void
+PolyhedronModel::
+BuildWired(IModel* _model, const vector<Vector3d>& _norms,
+    const vector<GLuint>& _pointVertex) {
 
-  glBegin(GL_LINES);
-  typedef ModelGraph::edge_iterator EIT;
-  for(EIT eit = m_modelGraph.edges_begin();
-      eit != m_modelGraph.edges_end(); ++eit) {
+  //create edge table
+  vector<MeshEdge> edges;
+  BuildEdges(_model, edges);
 
-    int tril = (*eit).property()[0];
-    int trir = (*eit).property()[1];
+  //keep only boundary and crease edges
+  m_mesh->m_wiredIndices.clear();
+  for(auto& e : edges) {
+    int tril = e.m_left;
+    int trir = e.m_right;
 
     if(tril == -1 || trir == -1 || 1-fabs(_norms[tril] * _norms[trir]) > 1e-3) {
-      glVertex3dv(points[(*eit).source()]);
-      glVertex3dv(points[(*eit).target()]);
+      m_mesh->m_wiredIndices.push_back(_pointVertex[e.m_source]);
+      m_mesh->m_wiredIndices.push_back(_pointVertex[e.m_target]);
     }
   }
-  glEnd();
-
-  glPopMatrix();
-  glEndList();
 }
 
 void
 PolyhedronModel::
 COM(const PtVector& _points) {
-  m_com = accumulate(_points.begin(), _points.end(), Point3d(0, 0, 0));
-  m_com /= _points.size();
+  m_mesh->m_com = accumulate(_points.begin(), _points.end(), Point3d(0, 0, 0));
+  m_mesh->m_com /= _points.size();
 }
 
 void
 PolyhedronModel::
 Radius(const PtVector& _points) {
-  m_radius = 0;
+  m_mesh->m_radius = 0;
   for(PtVector::const_iterator i = _points.begin(); i!=_points.end(); ++i) {
-    double d = (*i - m_com).normsqr();
-    if(d > m_radius)
-      m_radius = d;
+    double d = (*i - m_mesh->m_com).normsqr();
+    if(d > m_mesh->m_radius)
+      m_mesh->m_radius = d;
   }
-  m_radius = sqrt(m_radius);
+  m_mesh->m_radius = sqrt(m_mesh->m_radius);
 }
 
@@ -1,7 +1,10 @@
 #ifndef POLYHEDRONMODEL_H_
 #define POLYHEDRONMODEL_H_
 
-#include <containers/sequential/graph/graph.h>
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <mutex>
 
 #include "Environment/GMSPolyhedron.h"
 
@@ -17,11 +20,14 @@ class PolyhedronModel : public Model {
 
     PolyhedronModel(const string& _filename, GMSPolyhedron::COMAdjust _comAdjust);
     PolyhedronModel(const PolyhedronModel& _p);
-    ~PolyhedronModel();
 
-    size_t GetNumVertices() const {return m_numVerts;}
-    double GetRadius() const {return m_radius;}
-    const Point3d& GetCOM() const {return m_com;}
+    size_t GetNumVertices() const {return m_mesh->m_numVerts;}
+    double GetRadius() const {return m_mesh->m_radius;}
+    const Point3d& GetCOM() const {return m_mesh->m_com;}
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the center of the bounding sphere in model coordinates, i.e.
+    ///        after the COM adjustment.
+    Point3d GetCenter() const;
 
     void Build();
     void Select(GLuint* _index, vector<Model*>& sel) {}
@@ -33,38 +39,96 @@ class PolyhedronModel : public Model {
     void DrawNormals();
 
   protected:
-    //build models, given points and triangles
-    void BuildSolidObj(IModel* _model);
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief An interleaved vertex for the client-side vertex arrays.
+    ////////////////////////////////////////////////////////////////////////////
+    struct Vertex {
+      Vector3d Position() const {
+        return Vector3d(m_position[0], m_position[1], m_position[2]);
+      }
+      Vector3d Normal() const {
+        return Vector3d(m_normal[0], m_normal[1], m_normal[2]);
+      }
+
+      GLfloat m_position[3];
+      GLfloat m_normal[3];
+      GLfloat m_texture[2];
+    };
+
+    //build vertex arrays, given points and triangles. _pointVertex maps each
+    //model point to one of the vertices built at its position.
+    void BuildSolidObj(IModel* _model, vector<GLuint>& _pointVertex);
 
     void ComputeNormals(IModel* _model, vector<Vector3d>& _norms);
-    void BuildSolidBYU(IModel* _model, const vector<Vector3d>& _norms);
+    void BuildSolidBYU(IModel* _model, const vector<Vector3d>& _norms,
+        vector<GLuint>& _pointVertex);
 
-    void BuildNormalsObj(IModel* _model);
-    void BuildNormalsBYU(IModel* _model, const vector<Vector3d>& _norms);
+    //build the normal line array from the solid vertex array
+    void BuildNormals();
 
-    void BuildModelGraph(IModel* _model);
-    void BuildWired(IModel* _model, const vector<Vector3d>& _norms);
+    //load the file into m_mesh
+    void BuildMesh();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief An undirected mesh edge and the triangles on either side.
+    ////////////////////////////////////////////////////////////////////////////
+    struct MeshEdge {
+      uint32_t m_source, m_target; ///< Point indices.
+      int m_left, m_right;         ///< Triangle indices, -1 if none.
+    };
+
+    //compute the unique edges of the mesh for the wire frame
+    static void BuildEdges(IModel* _model, vector<MeshEdge>& _edges);
+    void BuildWired(IModel* _model, const vector<Vector3d>& _norms,
+        const vector<GLuint>& _pointVertex);
 
     //set m_com to center of mass of _points
     void COM(const PtVector& _points);
     //set m_radius to distance furthest point in _points to m_com
     void Radius(const PtVector& _points);
 
-  private:
-    string m_filename;
+    //apply the COM adjustment to the current modelview matrix
+    void AdjustCOM() const;
+    //draw the vertex arrays, replacing the old solid and wired display lists
+    void DrawSolid() const;
+    void DrawWired() const;
 
-    size_t m_numVerts;
+    static Vertex MakeVertex(const Point3d& _p, const Vector3d& _n,
+        const Vector2d& _t = Vector2d());
 
-    GLuint m_solidID; //the compiled model id for solid model
-    GLuint m_wiredID; //the compiled model id for wire frame
-    GLuint m_normalsID; //the compiled model id for normals
+    //resolve links and relative components so each file has one cache key
+    static string CanonicalPath(const string& _filename);
 
-    double m_radius; //radius
-    Point3d m_com; //Center of Mass
+  private:
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Geometry loaded from one file, shared by all models of that file
+    ///        with the same COM adjustment.
+    ////////////////////////////////////////////////////////////////////////////
+    struct Mesh {
+      size_t m_numVerts{0};
+
+      vector<Vertex> m_vertices;      ///< Vertices shared by all passes.
+      vector<GLuint> m_solidIndices;  ///< Triangles for the solid model.
+      vector<GLuint> m_wiredIndices;  ///< Line segments for the wire frame.
+      vector<GLfloat> m_normalLines;  ///< Normal line endpoints, built on demand.
+      bool m_smooth{false};           ///< Are normals per vertex (obj files)?
+      bool m_textured{false};         ///< Are texture coordinates loaded?
+
+      double m_radius{0}; //radius
+      Point3d m_com; //Center of Mass
+    };
+    typedef pair<string, GMSPolyhedron::COMAdjust> MeshKey;
+
+    string m_filename;
+    string m_path; ///< Canonical path of m_filename, for the mesh cache.
     GMSPolyhedron::COMAdjust m_comAdjust; ///< Adjustment of COM
 
-    typedef stapl::sequential::graph<stapl::UNDIRECTED, stapl::NONMULTIEDGES, int, Vector<int, 2> > ModelGraph;
-    ModelGraph m_modelGraph; //model graph for wired model
+    shared_ptr<Mesh> m_mesh; ///< The geometry, possibly shared.
+
+    static map<MeshKey, weak_ptr<Mesh>> m_meshCache; ///< Meshes in use, and
+                                                     ///< expired ones until
+                                                     ///< the next load.
+    static mutex m_meshCacheLock;                    ///< Guards m_meshCache.
 };
 
 #endif
@@ -1,6 +1,7 @@
 #ifndef REGION_MODEL_H_
 #define REGION_MODEL_H_
 
+#include <limits>
 #include <memory>
 
 #include "Environment/Boundary.h"
@@ -32,6 +33,30 @@ class RegionModel : public Model {
       return GetBoundary()->InBoundary(_p);
     }
     const Point3d& GetCenter() const {return m_center;}
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the axis-aligned bounding box of the region. Planar regions
+    ///        are unbounded in z.
+    void GetBoundingBox(Point3d& _min, Point3d& _max) const {
+      bool flat = m_shape == BOX2D || m_shape == SPHERE2D;
+      if(m_shape == SPHERE || m_shape == SPHERE2D) {
+        double r = GetLongLength() / 2;
+        for(size_t i = 0; i < 3; ++i) {
+          _min[i] = m_center[i] - r;
+          _max[i] = m_center[i] + r;
+        }
+      }
+      else {
+        shared_ptr<Boundary> b = GetBoundary();
+        for(size_t i = 0; i < (flat ? 2 : 3); ++i) {
+          _min[i] = b->GetRange(i).first;
+          _max[i] = b->GetRange(i).second;
+        }
+      }
+      if(flat) {
+        _min[2] = -numeric_limits<double>::max();
+        _max[2] = numeric_limits<double>::max();
+      }
+    }
 
     Shape GetShape() const {return m_shape;}
     string GetSampler() const {return m_sampler;}
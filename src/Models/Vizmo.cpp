@@ -1,18 +1,33 @@
 #include "Vizmo.h"
 
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
 #include <iostream>
+#include <limits>
+#include <sstream>
+#include <thread>
 using namespace std;
 
+#include <QCoreApplication>
+#include <QProgressDialog>
 #include <QTreeWidget>
+#include <QtConcurrentFilter>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
 
 #include "AvatarModel.h"
 #include "CfgModel.h"
 #include "DebugModel.h"
 #include "EnvModel.h"
+#include "MapModel.h"
 #include "Model.h"
 #include "PathModel.h"
+#include "PlanningService.h"
 #include "QueryModel.h"
 #include "ActiveMultiBodyModel.h"
+#include "BodyModel.h"
+#include "RegionModel.h"
 
 #include "GUI/MainWindow.h"
 
@@ -25,7 +40,9 @@ using namespace std;
 #include "PHANToM/Manager.h"
 #include "SpaceMouse/SpaceMouseManager.h"
 
+#include "Utilities/ParseProgress.h"
 #include "Utilities/PickBox.h"
+#include "Utilities/PickBuffer.h"
 
 /*------------------------------- Singletons ---------------------------------*/
 
@@ -81,7 +98,7 @@ InitModels() {
 
     // Create map model.
     if(!m_mapFilename.empty()) {
-      m_mapModel = new MapModel<CfgModel, EdgeModel>(m_mapFilename);
+      m_mapModel = LoadMap(m_mapFilename);
       m_loadedModels.push_back(m_mapModel);
       cout << "Loaded Map File : " << m_mapFilename << endl;
     }
@@ -148,9 +165,16 @@ Clean() {
 void
 Vizmo::
 Draw() {
-  typedef vector<Model*>::iterator MIT;
+  //Models skip whatever lies outside the camera's view during this pass
+  m_frustum.Update();
+  m_culling = true;
   for(auto& model : m_loadedModels)
     model->DrawRender();
+  m_culling = false;
+
+  //Draw the part of the roadmap which is still being planned
+  if(m_planningService)
+    m_planningService->DrawRender();
 
   glColor3f(1,1,0); //Selections are yellow, so set the color once now
   for(auto& model : m_selectedModels)
@@ -162,113 +186,37 @@ Draw() {
 void
 Vizmo::
 Select(const Box& _box) {
-  //prepare for selection mode
-  GLuint hitBuffer[1024];
-  glSelectBuffer(1024, hitBuffer);
-  glRenderMode(GL_SELECT);
-
-  //get view port
-  GLint viewport[4];
-  glGetIntegerv(GL_VIEWPORT, viewport);
-
-  //initialize stack
-  glInitNames();
-
-  //change view volume
-  glMatrixMode(GL_PROJECTION);
-
-  double pm[16]; //current projection matrix
-  glGetDoublev(GL_PROJECTION_MATRIX, pm);
-
-  glPushMatrix();
-  glLoadIdentity();
-
-  double x = (_box.m_left + _box.m_right)/2;
-  double y = (_box.m_top + _box.m_bottom)/2;
-  double w = fabs(_box.m_right - _box.m_left); if(w<5) w=5;
-  double h = fabs(_box.m_top - _box.m_bottom); if(h<5) h=5;
-
-  gluPickMatrix(x, y, w, h, viewport);
-  glMultMatrixd(pm); //apply current proj matrix
-
-  //draw
-  glMatrixMode(GL_MODELVIEW);
-  typedef vector<Model*>::iterator MIT;
-  for(MIT mit = m_loadedModels.begin(); mit != m_loadedModels.end(); ++mit) {
-    glPushName(mit-m_loadedModels.begin());
-    (*mit)->DrawSelect();
-    glPopName();
+  //get the pick rectangle in window coordinates, at least 5x5 pixels
+  double w = max(fabs(_box.m_right - _box.m_left), 5.);
+  double h = max(fabs(_box.m_top - _box.m_bottom), 5.);
+  double x = (_box.m_left + _box.m_right - w) / 2;
+  double y = (_box.m_top + _box.m_bottom - h) / 2;
+
+  //draw each model in its ID colors, then read back the visible IDs. The
+  //roadmap is picked from its spatial index instead of being drawn.
+  bool all = w * h > 100;
+  PickBuffer::Begin(x, y, w, h);
+  for(size_t i = 0; i < m_loadedModels.size(); ++i) {
+    if(m_loadedModels[i] == m_mapModel)
+      continue;
+    PickBuffer::PushName(i);
+    m_loadedModels[i]->DrawSelect();
+    PickBuffer::PopName();
   }
-
-  glMatrixMode(GL_PROJECTION);
-  glPopMatrix();
-
-  GLuint hits = glRenderMode(GL_RENDER);
+  vector<vector<GLuint>> hits = PickBuffer::End(all);
 
   //unselect everything first
   m_selectedModels.clear();
 
-  if(hits > 0)
-    SearchSelectedItems(hits, hitBuffer, (w*h) > 100);
-}
-
-
-void
-Vizmo::
-SearchSelectedItems(int _hit, void* _buffer, bool _all) {
-  //init local data
-  GLuint* ptr = (GLuint*)_buffer;
-  unsigned int* selName = NULL;
-
-  //input error
-  if(!ptr)
+  //A click on a roadmap item takes precedence over the other models
+  if(m_mapModel)
+    m_mapModel->Select(_box, all, m_selectedModels);
+  if(!all && !m_selectedModels.empty())
     return;
 
-  double z1; //near z for hit object
-  double closeDistance = 1e3;
-
-  for(int i=0; i<_hit; i++) {
-    unsigned int* curName=NULL;
-    GLuint nameSize = *ptr; ptr++;
-    z1 = ((double)*ptr)/0x7fffffff; ptr++; //near z
-    ptr++; //far z, we don't use this info
-
-    curName = new unsigned int[nameSize];
-    if(!curName)
-      return;
-
-    for(unsigned int iN=0; iN<nameSize; ++iN){
-      curName[iN] = *ptr;
-      ptr++;
-    }
-
-    if(!_all) {//not all
-      if( z1<closeDistance ) {
-        closeDistance = z1;     // set current nearset to z1
-        delete [] selName;      //free preallocated mem
-        if((selName=new unsigned int[nameSize])==NULL) return;
-        memcpy(selName,curName,sizeof(unsigned int)*nameSize);
-      }
-    }
-    else{ //select all
-      if(curName[0] <= m_loadedModels.size()) {
-        Model* selectModel = m_loadedModels[curName[0]];
-        selectModel->Select(&curName[1], m_selectedModels);
-      }
-    }
-
-    delete[] curName;  //free preallocated mem
-  }
-
-  //only the closest
-  if(!_all) {
-    // analyze selected item
-    if(selName && selName[0] <= m_loadedModels.size()) {
-      Model* selectModel = m_loadedModels[selName[0]];
-      selectModel->Select(&selName[1], m_selectedModels);
-    }
-  }
-  delete[] selName;
+  for(auto& name : hits)
+    if(name[0] < m_loadedModels.size())
+      m_loadedModels[name[0]]->Select(&name[1], m_selectedModels);
 }
 
 /*-------------------------- Environment Functions ---------------------------*/
@@ -296,6 +244,89 @@ GetMaxEnvDist() {
 
 /*----------------------------- Roadmap Functions ----------------------------*/
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Parse a roadmap file on a worker thread, keeping any error message
+///        for the GUI thread to report.
+static void
+ParseMap(MapModel<CfgModel, EdgeModel>* _map, ParseProgress* _progress,
+    string* _error) {
+  try {
+    _map->ParseFile(_progress);
+  }
+  catch(PMPLException& _e) {
+    *_error = _e.what();
+  }
+  catch(exception& _e) {
+    *_error = _e.what();
+  }
+}
+
+
+MapModel<CfgModel, EdgeModel>*
+Vizmo::
+LoadMap(const string& _filename) {
+  typedef MapModel<CfgModel, EdgeModel> Map;
+  Map* map = new Map();
+  map->SetFilename(_filename);
+
+  //Without a window there is nothing to keep responsive
+  if(!GetMainWindow()) {
+    try {
+      map->ParseFile();
+    }
+    catch(...) {
+      delete map;
+      throw;
+    }
+    map->Build();
+    return map;
+  }
+
+  //Parse on a worker while the GUI thread shows progress. The graph is not
+  //touched here until the worker finishes.
+  ParseProgress progress;
+  string error;
+  QFuture<void> parse = QtConcurrent::run(ParseMap, map, &progress, &error);
+
+  QProgressDialog dialog(("Loading " + _filename + "...").c_str(), "Cancel",
+      0, 1000, GetMainWindow());
+  dialog.setWindowModality(Qt::WindowModal);
+  dialog.setMinimumDuration(500);
+
+  QTime timer;
+  timer.start();
+  while(!parse.isFinished()) {
+    QCoreApplication::processEvents(QEventLoop::AllEvents, 50);
+    if(dialog.wasCanceled())
+      progress.m_cancel = true;
+
+    double seconds = max(timer.elapsed(), 1) / 1000.;
+    size_t bytes = progress.m_bytes, size = progress.m_size,
+           vertices = progress.m_items;
+    if(size)
+      dialog.setValue(1000. * bytes / size);
+    ostringstream oss;
+    oss << "Loading " << _filename << "\n"
+        << fixed << setprecision(1) << bytes / 1e6 << " of " << size / 1e6
+        << " MB (" << bytes / 1e6 / seconds << " MB/s, "
+        << size_t(vertices / seconds) << " vertices/s)";
+    dialog.setLabelText(oss.str().c_str());
+
+    this_thread::sleep_for(chrono::milliseconds(20));
+  }
+  dialog.reset();
+
+  if(!error.empty()) {
+    delete map;
+    throw ParseException(WHERE, error);
+  }
+
+  //Build the display structures on the GUI thread
+  map->Build();
+  return map;
+}
+
+
 void
 Vizmo::
 ReadMap(const string& _name) {
@@ -401,6 +432,157 @@ GetAllStrategies() const {
 }
 
 
+////////////////////////////////////////////////////////////////////////////////
+/// \brief The workspace volume of an avoid region, grown by the reach of the
+///        robot so that any cfg whose base stays outside it cannot place part
+///        of the robot inside the region.
+struct AvoidVolume {
+  bool m_sphere;       ///< Is the region a sphere rather than a box?
+  Point3d m_min, m_max; ///< The grown bounding box.
+  Point3d m_center;    ///< For spheres, the center.
+  double m_radius;     ///< For spheres, the grown radius.
+  double m_reach;      ///< For boxes, the growth.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the grown volume of an avoid region.
+static AvoidVolume
+MakeAvoidVolume(const EnvModel::RegionModelPtr& _r, double _reach) {
+  AvoidVolume v;
+  v.m_reach = _reach;
+  RegionModel::Shape shape = _r->GetShape();
+  v.m_sphere = shape == RegionModel::SPHERE || shape == RegionModel::SPHERE2D;
+  v.m_center = _r->GetCenter();
+  v.m_radius = _r->GetLongLength() / 2 + _reach;
+  _r->GetBoundingBox(v.m_min, v.m_max);
+  for(size_t i = 0; i < 3; ++i) {
+    v.m_min[i] -= _reach;
+    v.m_max[i] += _reach;
+  }
+  return v;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Check whether a segment of robot base positions comes close enough
+///        to an avoid region for the robot to enter it.
+static bool
+NearAvoidVolume(const AvoidVolume& _v, const Point3d& _a, const Point3d& _b) {
+  Vector3d d = _b - _a;
+  if(_v.m_sphere) {
+    double len = d.normsqr();
+    double t = len > 0 ? max(0., min(1., (_v.m_center - _a) * d / len)) : 0;
+    return (_a + t * d - _v.m_center).norm() <= _v.m_radius;
+  }
+
+  //Distance to the ungrown box, which is convex along the segment
+  auto dist = [&](double _t) {
+    Point3d p = _a + _t * d;
+    double sq = 0;
+    for(size_t i = 0; i < 3; ++i) {
+      double e = max(max(_v.m_min[i] + _v.m_reach - p[i],
+          p[i] - _v.m_max[i] + _v.m_reach), 0.);
+      sq += e * e;
+    }
+    return sq;
+  };
+  double lo = 0, hi = 1;
+  for(size_t i = 0; i < 40 && hi - lo > 1e-9; ++i) {
+    double m1 = lo + (hi - lo) / 3, m2 = hi - (hi - lo) / 3;
+    if(dist(m1) < dist(m2))
+      hi = m2;
+    else
+      lo = m1;
+  }
+  double reach = _v.m_reach * _v.m_reach;
+  return min(dist(0.5 * (lo + hi)), min(dist(0), dist(1))) <= reach;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief A copy of the robots and of the avoid region checker for one worker
+///        thread, so that re-checks run in parallel without configuring the
+///        environment's robots.
+struct AvoidRegionWorker {
+  typedef AvoidRegionValidity<VizmoTraits> Checker;
+
+  AvoidRegionWorker(const string& _envFile, const Checker& _vc) : m_vc(_vc) {
+    m_env.Read(_envFile);
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Check a cfg with this worker's robot.
+  bool IsValid(CfgModel& _cfg) {
+    return m_vc.IsValid(_cfg, *m_env.GetRobot(_cfg.GetRobotIndex()));
+  }
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Check the straight line between two cfgs at the environment
+  ///        resolution, as the AvoidRegionSL local planner does.
+  bool IsConnected(const CfgModel& _a, const CfgModel& _b, double _posRes,
+      double _oriRes) {
+    CfgModel incr(_a.GetRobotIndex()), tick = _a;
+    int nTicks;
+    incr.FindIncrement(_a, _b, &nTicks, _posRes, _oriRes);
+    for(int i = 1; i < nTicks; ++i) {
+      tick += incr;
+      if(!IsValid(tick))
+        return false;
+    }
+    return true;
+  }
+
+  Environment m_env; ///< The worker's copy of the environment and robots.
+  Checker m_vc;      ///< The worker's copy of the checker.
+};
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Idle avoid region workers, kept between re-checks since each reads
+///        the environment file. A worker is taken by one thread at a time.
+class AvoidRegionWorkers {
+
+  public:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Drop the idle workers if they were made for another environment
+    ///        or checker.
+    void Reset(const string& _envFile, const AvoidRegionWorker::Checker* _vc) {
+      QMutexLocker lock(&m_lock);
+      if(_envFile == m_envFile && _vc == m_vc)
+        return;
+      m_idle.clear();
+      m_envFile = _envFile;
+      m_vc = _vc;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Take an idle worker, or make one if there are none.
+    unique_ptr<AvoidRegionWorker> Acquire() {
+      QMutexLocker lock(&m_lock);
+      if(m_idle.empty()) {
+        lock.unlock();
+        return unique_ptr<AvoidRegionWorker>(
+            new AvoidRegionWorker(m_envFile, *m_vc));
+      }
+      unique_ptr<AvoidRegionWorker> worker = move(m_idle.back());
+      m_idle.pop_back();
+      return worker;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Return a worker to the idle list.
+    void Release(unique_ptr<AvoidRegionWorker> _worker) {
+      QMutexLocker lock(&m_lock);
+      m_idle.push_back(move(_worker));
+    }
+
+  private:
+
+    QMutex m_lock;                                    ///< Guards the list.
+    vector<unique_ptr<AvoidRegionWorker>> m_idle;     ///< Idle workers.
+    string m_envFile;                                 ///< Their environment.
+    const AvoidRegionWorker::Checker* m_vc{nullptr};  ///< Their checker.
+};
+
+
 void
 Vizmo::
 ProcessAvoidRegions() {
@@ -410,62 +592,124 @@ ProcessAvoidRegions() {
   const vector<RegionModelPtr>& avoidRegions = GetVizmo().GetEnv()->
       GetAvoidRegions();
 
-  //check that some avoid region needs processing
-  bool skipCheck = true;
-  for(typename vector<RegionModelPtr>::const_iterator rit = avoidRegions.begin();
-      rit != avoidRegions.end(); ++rit) {
-    if(!(*rit)->IsProcessed()) {
-      skipCheck = false;
-      (*rit)->Processed();
+  //collect the avoid regions which are new or changed since the last check
+  vector<RegionModelPtr> changed;
+  for(auto& r : avoidRegions) {
+    if(!r->IsProcessed()) {
+      changed.push_back(r);
+      r->Processed();
     }
   }
-  if(skipCheck)
+  if(changed.empty())
     return;
 
-  //check is needed. get env, graph, vc, and lp
+  //check is needed. get env, graph, and vc
   typedef Roadmap<VizmoTraits> RGraph;
   typedef RGraph::GraphType GraphType;
   typedef typename GraphType::vertex_descriptor VID;
-  typedef typename GraphType::vertex_iterator VI;
-  typedef typename GraphType::edge_descriptor EID;
-  typedef typename GraphType::adj_edge_iterator EI;
+  typedef pair<VID, VID> Key;
 
   GraphType* g = GetVizmoProblem()->GetRoadmap()->GetGraph();
+  if(g->get_num_vertices() == 0)
+    return;
   Environment* env = GetVizmo().GetEnv()->GetEnvironment();
-  auto vc = GetVizmoProblem()->GetValidityChecker("AvoidRegionValidity");
-  auto lp = GetVizmoProblem()->GetLocalPlanner("AvoidRegionSL");
+  auto vc = dynamic_pointer_cast<AvoidRegionWorker::Checker>(
+      GetVizmoProblem()->GetValidityChecker("AvoidRegionValidity"));
+  auto map = GetVizmo().GetMap();
+
+  //bound how far the robot reaches from its base position. Without a bound,
+  //every node and edge is re-checked.
+  double reach = GetVizmo().GetEnv()->GetRobot(
+      g->begin()->property().GetRobotIndex())->GetReach();
+
+  vector<Key> candidates;
+  if(reach < 0) {
+    for(auto vit = g->begin(); vit != g->end(); ++vit)
+      candidates.emplace_back(vit->descriptor(), vit->descriptor());
+    for(auto eit = g->edges_begin(); eit != g->edges_end(); ++eit)
+      candidates.emplace_back(min((*eit).source(), (*eit).target()),
+          max((*eit).source(), (*eit).target()));
+    sort(candidates.begin(), candidates.end());
+    candidates.erase(unique(candidates.begin(), candidates.end()),
+        candidates.end());
+  }
+  else {
+    //find the nodes and edges near the changed regions through the spatial
+    //index, then narrow them down on the worker pool
+    reach += env->GetPositionRes();
+    vector<AvoidVolume> volumes;
+    map->RefreshMap();
+    for(auto& r : changed) {
+      volumes.push_back(MakeAvoidVolume(r, reach));
+      auto keys = map->Overlapping(volumes.back().m_min, volumes.back().m_max);
+      candidates.insert(candidates.end(), keys.begin(), keys.end());
+    }
+    sort(candidates.begin(), candidates.end());
+    candidates.erase(unique(candidates.begin(), candidates.end()),
+        candidates.end());
+
+    QtConcurrent::blockingFilter(candidates, [&](const Key& _k) {
+      Point3d a = g->GetVertex(_k.first).GetPoint();
+      Point3d b = g->GetVertex(_k.second).GetPoint();
+      for(auto& v : volumes)
+        if(NearAvoidVolume(v, a, b))
+          return true;
+      return false;
+    });
+  }
+
+  //re-validate the candidates with avoid region validity on the worker pool.
+  //Each worker configures its own copy of the robot, so the checks do not
+  //touch the environment's robot.
+  static AvoidRegionWorkers workers;
+  workers.Reset(GetVizmo().GetEnvFileName(), vc.get());
+  double posRes = env->GetPositionRes(), oriRes = env->GetOrientationRes();
+  vector<char> valid = QtConcurrent::blockingMapped<vector<char>>(candidates,
+      function<char(const Key&)>([&](const Key& _k) {
+        unique_ptr<AvoidRegionWorker> worker = workers.Acquire();
+        CfgModel a = g->GetVertex(_k.first);
+        bool v = _k.first == _k.second ? worker->IsValid(a) :
+            worker->IsConnected(a, g->GetVertex(_k.second), posRes, oriRes);
+        workers.Release(move(worker));
+        return char(v);
+      }));
 
   vector<VID> verticesToDel;
-  vector<EID> edgesToDel;
-
-  //re-validate graph with avoid region validity
-  //loop over the graph testing vertices for deletion
-  for(auto vit = g->begin(); vit != g->end(); ++vit)
-    if(!vc->IsValid(vit->property(), vc->GetNameAndLabel()))
-      verticesToDel.push_back(vit->descriptor());
-
-  //loop over the graph testing edges for deletion
-  for(auto eit = g->edges_begin(); eit != g->edges_end(); ++eit) {
-    LPOutput<VizmoTraits> lpOutput;
-    CfgModel collisionCfg;
-    if(!lp->IsConnected(g->GetVertex((*eit).source()),
-          g->GetVertex((*eit).target()), collisionCfg, &lpOutput,
-          env->GetPositionRes(), env->GetOrientationRes()))
-      edgesToDel.push_back((*eit).descriptor());
+  vector<Key> edgesToDel;
+  for(size_t i = 0; i < candidates.size(); ++i) {
+    const Key& k = candidates[i];
+    if(valid[i])
+      continue;
+    if(k.first == k.second) {
+      verticesToDel.push_back(k.first);
+      continue;
+    }
+
+    //the index holds each edge once, so remove both directions
+    for(auto& e : {k, Key(k.second, k.first)}) {
+      auto vi = g->find_vertex(e.first);
+      for(auto ei = vi->begin(); ei != vi->end(); ++ei)
+        if((*ei).target() == e.second) {
+          edgesToDel.push_back(e);
+          break;
+        }
+    }
   }
+  if(verticesToDel.empty() && edgesToDel.empty())
+    return;
 
-  //handle deletion of invalid edges and vertices
-  QMutexLocker locker(&GetVizmo().GetMap()->AcquireMutex());
+  //handle deletion of invalid edges and vertices in one batch
+  QMutexLocker locker(&map->AcquireMutex());
   for(auto& e : edgesToDel)
-    g->delete_edge(e);
+    map->DeleteEdge(e.first, e.second);
   for(auto& v : verticesToDel)
-    g->delete_vertex(v);
+    map->DeleteVertex(v);
 
-  GetVizmo().GetMap()->RefreshMap(false);
+  map->RefreshMap(false);
 }
 
 
-void
+bool
 Vizmo::
 Solve(const string& _strategy) {
   SRand(m_seed);
@@ -495,12 +739,32 @@ Solve(const string& _strategy) {
   if(name.find("Region"))
     AddInitialRegions();
 
-  mps->operator()();
+  bool completed = true;
+  try {
+    mps->operator()();
+  }
+  catch(PlanningCanceled&) {
+    //Finalize was skipped, so undo what the strategies' Initialize does
+    completed = false;
+    GetMap()->SetSelectable(true);
+    GetEnv()->SetSelectable(true);
+  }
 
   //Close the debug file
   VDClose();
 
   GetVizmo().GetMap()->RefreshMap();
+  return completed;
+}
+
+
+void
+Vizmo::
+PlanningCheckpoint() {
+  if(m_planningService)
+    m_planningService->Checkpoint();
+  else
+    GetMap()->RefreshMap();
 }
 
 /*---------------------------------- Timing ----------------------------------*/
@@ -9,6 +9,7 @@ using namespace std;
 
 #include "Models/CfgModel.h"
 #include "Models/EdgeModel.h"
+#include "Utilities/Frustum.h"
 
 //class ActiveMultiBodyModel;
 class Box;
@@ -17,6 +18,7 @@ class EnvModel;
 template<typename, typename> class MapModel;
 class Model;
 class PathModel;
+class PlanningService;
 class QueryModel;
 namespace Haptics {class Manager;}
 class SpaceMouseManager;
@@ -57,6 +59,18 @@ class Vizmo {
 
     void Draw();     ///< Display the OpenGL scene.
 
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the view frustum for culling, or null outside of Draw.
+    const Frustum* GetFrustum() const {return m_culling ? &m_frustum : nullptr;}
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Set the on-screen size in pixels of the node clusters used to
+    ///        draw large roadmaps, or 0 to always draw roadmaps in full.
+    void SetLODPixelSize(double _p) {m_lodPixelSize = _p;}
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the roadmap cluster size in pixels, or 0 if LOD is off.
+    double GetLODPixelSize() const {return m_lodPixelSize;}
+
     ///@}
     ///\name Selection
     ///@{
@@ -178,14 +192,29 @@ class Vizmo {
     vector<string> GetAllStrategies() const;
 
     ////////////////////////////////////////////////////////////////////////////
-    /// \brief Check each avoid region and remove any configurations found
-    ///        within.
+    /// \brief Check each new or changed avoid region and remove any
+    ///        configurations found within. Only the nodes and edges near
+    ///        those regions are re-validated.
     void ProcessAvoidRegions();
 
     ////////////////////////////////////////////////////////////////////////////
     /// \brief Execute an interactive or PMPL strategy.
     /// \param[in] _strategy The label of the strategy to use.
-    void Solve(const string& _strategy);
+    /// \return False if the planning service canceled the strategy.
+    bool Solve(const string& _strategy);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Set the service running the current strategy, or null when none
+    ///        is running. Call from the GUI thread.
+    void SetPlanningService(PlanningService* _s) {m_planningService = _s;}
+    PlanningService* GetPlanningService() const {return m_planningService;}
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Mark the end of a strategy iteration. The planning service may
+    ///        publish progress, pause, or cancel here; without one the map
+    ///        model is refreshed.
+    /// \throws PlanningCanceled if planning was canceled.
+    void PlanningCheckpoint();
 
     ///@}
     ///\name Timing
@@ -219,14 +248,12 @@ class Vizmo {
   private:
 
     ////////////////////////////////////////////////////////////////////////////
-    /// \ingroup Selection
-    /// \brief Parse the hit buffer and store selected objects into
-    ///        \ref m_selectedModels.
-    /// \param[in] _hit The number of objects in the selection.
-    /// \param[in] _buffer The hit buffer.
-    /// \param[in] _all Determines whether all objects or only the closest
-    ///                 object will be stored in the hit buffer.
-    void SearchSelectedItems(int _hit, void* _buffer, bool _all);
+    /// \brief Read a roadmap file on a worker thread while showing its progress
+    ///        in a cancelable dialog, then build it on the GUI thread.
+    /// \param[in] _filename The roadmap file.
+    /// \return The built map model.
+    /// \throws ParseException if the file is malformed or loading is canceled.
+    MapModel<CfgModel, EdgeModel>* LoadMap(const string& _filename);
 
     ///\name Loaded File Names
     ///@{
@@ -266,7 +293,12 @@ class Vizmo {
     ///\name Other Internal State
     ///@{
 
+    Frustum m_frustum;                         ///< The view volume for Draw.
+    bool m_culling{false};                     ///< Is Draw culling models?
+    double m_lodPixelSize{0};                  ///< Roadmap LOD cluster size.
+
     long m_seed;                               ///< The program's random seed.
+    PlanningService* m_planningService{nullptr}; ///< The running planner.
     map<string, pair<QTime, double>> m_timers; ///< Timers.
 
     ///@}
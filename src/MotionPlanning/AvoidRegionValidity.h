@@ -1,17 +1,34 @@
 #ifndef AVOID_REGION_VALIDITY_H_
 #define AVOID_REGION_VALIDITY_H_
 
+#include <algorithm>
+#include <limits>
+#include <unordered_map>
+
 #include "Environment/ActiveMultiBody.h"
 
+#include "Models/EnvModel.h"
 #include "Models/RegionModel.h"
 #include "Models/Vizmo.h"
 
 #include "ValidityCheckers/ValidityCheckerMethod.h"
 
 ////////////////////////////////////////////////////////////////////////////////
-/// \brief Checks whether a configuration is completely outside of all avoid
-///        regions, returning false if any part of the robot lies within any
-///        avoid region.
+/// \brief   Checks whether a configuration is completely outside of all avoid
+///          regions, returning false if any part of the robot lies within any
+///          avoid region.
+/// \details By default a bounding volume hierarchy is built over the avoid
+///          regions whenever they change. Each body's bounding sphere is
+///          tested against it first, and only the regions it touches are
+///          tested against the body's mesh vertices. Setting
+///          \c broadPhase="false" tests every vertex of every body against
+///          every region instead, which is kept for comparison. The number
+///          of checks and the time spent in them are recorded in the stat
+///          class under the checker's name.
+///
+///          IsValid(_cfg, _robot) checks against a robot other than the
+///          environment's. Threads which each own a copy of the checker and
+///          a robot may use it at once.
 ////////////////////////////////////////////////////////////////////////////////
 template<class MPTraits>
 class AvoidRegionValidity : public ValidityCheckerMethod<MPTraits> {
@@ -32,6 +49,23 @@ class AvoidRegionValidity : public ValidityCheckerMethod<MPTraits> {
     AvoidRegionValidity(MPProblemType* _problem, XMLNode& _node);
 
     ///@}
+    ///\name MPBaseObject Overrides
+    ///@{
+
+    virtual void Print(ostream& _os) const override;
+
+    ///@}
+    ///\name Checks With Another Robot
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Check a configuration of a robot other than the environment's.
+    ///        The robot is configured here, and no stats are recorded.
+    bool IsValid(CfgType& _cfg, ActiveMultiBody& _robot);
+
+    using ValidityCheckerMethod<MPTraits>::IsValid;
+
+    ///@}
 
   protected:
 
@@ -42,6 +76,94 @@ class AvoidRegionValidity : public ValidityCheckerMethod<MPTraits> {
         const string& _callName) override;
 
     ///@}
+
+  private:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief The workspace volume of an avoid region.
+    struct Volume {
+      Point3d m_min, m_max;  ///< The bounding box, unbounded in z if planar.
+      bool m_sphere;         ///< Is the region a sphere rather than a box?
+      bool m_flat;           ///< Does the region ignore z?
+      Point3d m_center;      ///< For spheres, the center.
+      double m_radius;       ///< For spheres, the radius.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief A tree node bounding a range of m_order.
+    struct Node {
+      Point3d m_min, m_max;   ///< The bounding box of the node's regions.
+      size_t m_first, m_last; ///< The node's range in m_order.
+      size_t m_left{0};       ///< The first child, or 0 for a leaf.
+      size_t m_right{0};      ///< The second child.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief The mesh vertices of a body in its own frame, split by
+    ///        coordinate so the kernels vectorize, and their bounding sphere.
+    struct BodyPoints {
+      vector<double> m_x, m_y, m_z;
+      Vector3d m_center;
+      double m_radius{0};
+    };
+
+    ///\name Checks
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Test every vertex of every body of a configured robot against
+    ///        every region.
+    bool IsValidReference(ActiveMultiBody& _robot);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Test the bodies of a configured robot against the region tree
+    ///        first, and only the regions they touch against their vertices.
+    bool IsValidBroadPhase(ActiveMultiBody& _robot);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Check whether any of a set of points lies within a volume.
+    static bool AnyInside(const Volume& _v, const double* _x, const double* _y,
+        const double* _z, size_t _n);
+
+    ///@}
+    ///\name Region Tree
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Rebuild the region tree if the avoid region version has changed
+    ///        since it was built.
+    void UpdateRegions();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Build the subtree over m_order[_first, _last).
+    /// \return The index of the subtree root in m_nodes.
+    size_t Build(size_t _first, size_t _last);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Find the regions which a sphere may touch.
+    /// \param[out] _hits The indices of the regions in m_volumes.
+    void Overlapping(const Point3d& _center, double _radius,
+        vector<size_t>& _hits) const;
+
+    ///@}
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the vertices of a body, gathering them on first use.
+    const BodyPoints& GetBodyPoints(GMSPolyhedron& _poly);
+
+    bool m_broadPhase{true};   ///< Use the region tree?
+    string m_checksStat;       ///< The stat counting the checks.
+    string m_clockName;        ///< The clock timing the checks.
+
+    size_t m_version{numeric_limits<size_t>::max()}; ///< The tree's version.
+    vector<Volume> m_volumes;  ///< The volumes of the avoid regions.
+    vector<size_t> m_order;    ///< Volume indices in leaf order.
+    vector<Node> m_nodes;      ///< The tree, rooted at the first node.
+
+    unordered_map<const GMSPolyhedron*, BodyPoints> m_bodies; ///< Body vertices.
+    vector<double> m_x, m_y, m_z; ///< Vertices of the current body in world
+                                  ///< coordinates.
+    vector<size_t> m_hits;     ///< Regions touched by the current body.
 };
 
 /*----------------------------- Construction ---------------------------------*/
@@ -50,6 +172,8 @@ template<class MPTraits>
 AvoidRegionValidity<MPTraits>::
 AvoidRegionValidity() : ValidityCheckerMethod<MPTraits>() {
   this->m_name = "AvoidRegionValidity";
+  m_checksStat = this->m_name + "::Checks";
+  m_clockName = this->m_name + "::IsValid";
 }
 
 
@@ -58,40 +182,77 @@ AvoidRegionValidity<MPTraits>::
 AvoidRegionValidity(MPProblemType* _problem, XMLNode& _node) :
     ValidityCheckerMethod<MPTraits>(_problem, _node) {
   this->m_name = "AvoidRegionValidity";
+  m_broadPhase = _node.Read("broadPhase", false, m_broadPhase,
+      "Test bodies against a tree of the regions before their vertices");
+  m_checksStat = this->GetNameAndLabel() + "::Checks";
+  m_clockName = this->GetNameAndLabel() + "::IsValid";
 }
 
+/*------------------------- MPBaseObject Overrides ---------------------------*/
 
-/*------------------------------- Helpers ------------------------------------*/
+template<class MPTraits>
+void
+AvoidRegionValidity<MPTraits>::
+Print(ostream& _os) const {
+  ValidityCheckerMethod<MPTraits>::Print(_os);
+  _os << "\tbroad phase = " << m_broadPhase << endl;
+}
+
+/*------------------------ Checks With Another Robot -------------------------*/
 
 template<class MPTraits>
 bool
 AvoidRegionValidity<MPTraits>::
-IsValidImpl(CfgType& _cfg, CDInfo& _cdInfo, const string& _callName) {
-  //get environment, avoid regions, and robot
-  Environment* env = this->GetEnvironment();
-  vector<EnvModel::RegionModelPtr> avoidRegions =
-    GetVizmo().GetEnv()->GetAvoidRegions();
-  shared_ptr<ActiveMultiBody> robot = env->GetRobot(_cfg.GetRobotIndex());
+IsValid(CfgType& _cfg, ActiveMultiBody& _robot) {
+  _robot.Configure(_cfg.GetData());
+  return m_broadPhase ? IsValidBroadPhase(_robot) : IsValidReference(_robot);
+}
 
+/*---------------------- ValidityCheckerMethod Overrides ---------------------*/
+
+template<class MPTraits>
+bool
+AvoidRegionValidity<MPTraits>::
+IsValidImpl(CfgType& _cfg, CDInfo& _cdInfo, const string& _callName) {
+  StatClass* stats = this->GetStatClass();
+  stats->IncStat(m_checksStat);
+  stats->StartClock(m_clockName);
+  shared_ptr<ActiveMultiBody> robot = this->GetEnvironment()->GetRobot(
+      _cfg.GetRobotIndex());
   _cfg.ConfigureRobot();
+  bool valid = m_broadPhase ? IsValidBroadPhase(*robot) :
+      IsValidReference(*robot);
+  stats->StopClock(m_clockName);
+  return valid;
+}
+
+/*--------------------------------- Checks -----------------------------------*/
+
+template<class MPTraits>
+bool
+AvoidRegionValidity<MPTraits>::
+IsValidReference(ActiveMultiBody& _robot) {
+  //get avoid regions
+  const vector<EnvModel::RegionModelPtr>& avoidRegions =
+    GetVizmo().GetEnv()->GetAvoidRegions();
 
-  //check each region to ensure _cfg does not enter it
+  //check each region to ensure the robot does not enter it
   for(auto& r : avoidRegions) {
     shared_ptr<Boundary> b = r->GetBoundary();
 
     //first check if robot's center is within the boundary
-    if(b->InBoundary(_cfg.GetRobotCenterPosition()))
+    if(b->InBoundary(_robot.GetCenterOfMass()))
       return false;
 
     //if center is outside boundary, check each component of the robot to ensure
     //that none lie within the avoid region
-    for(size_t m = 0; m < robot->NumFreeBody(); ++m) {
+    for(size_t m = 0; m < _robot.NumFreeBody(); ++m) {
       typedef vector<Vector3d>::const_iterator VIT;
-      Transformation& worldTransformation = robot->GetFreeBody(m)->
+      Transformation& worldTransformation = _robot.GetFreeBody(m)->
         WorldTransformation();
 
       //first check bounding polyhedron for this component
-      GMSPolyhedron &bb = robot->GetFreeBody(m)->GetBoundingBoxPolyhedron();
+      GMSPolyhedron &bb = _robot.GetFreeBody(m)->GetBoundingBoxPolyhedron();
       bool bbValid = true;
       for(VIT v = bb.m_vertexList.begin(); v != bb.m_vertexList.end(); ++v)
         if(b->InBoundary(worldTransformation * (*v)))
@@ -102,7 +263,7 @@ IsValidImpl(CfgType& _cfg, CDInfo& _cdInfo, const string& _callName) {
         continue;
 
       //if the bounding polyhedron is not valid, check component's geometry
-      GMSPolyhedron &poly = robot->GetFreeBody(m)->GetPolyhedron();
+      GMSPolyhedron &poly = _robot.GetFreeBody(m)->GetPolyhedron();
       for(VIT v = poly.m_vertexList.begin(); v != poly.m_vertexList.end(); ++v)
         if(b->InBoundary(worldTransformation * (*v)))
           return false;
@@ -111,6 +272,267 @@ IsValidImpl(CfgType& _cfg, CDInfo& _cdInfo, const string& _callName) {
   return true;
 }
 
+
+template<class MPTraits>
+bool
+AvoidRegionValidity<MPTraits>::
+IsValidBroadPhase(ActiveMultiBody& _robot) {
+  UpdateRegions();
+  if(m_volumes.empty())
+    return true;
+
+  //first check if robot's center is within any region
+  Point3d center = _robot.GetCenterOfMass();
+  m_hits.clear();
+  Overlapping(center, 0, m_hits);
+  for(auto i : m_hits)
+    if(AnyInside(m_volumes[i], &center[0], &center[1], &center[2], 1))
+      return false;
+
+  //then check the vertices of each body against the regions its bounding
+  //sphere touches
+  for(size_t m = 0; m < _robot.NumFreeBody(); ++m) {
+    const Transformation& t = _robot.GetFreeBody(m)->WorldTransformation();
+    const BodyPoints& body = GetBodyPoints(
+        _robot.GetFreeBody(m)->GetPolyhedron());
+
+    m_hits.clear();
+    Overlapping(t * body.m_center, body.m_radius, m_hits);
+    if(m_hits.empty())
+      continue;
+
+    //move the vertices to world coordinates
+    const auto& r = t.rotation().matrix();
+    const Vector3d& p = t.translation();
+    size_t n = body.m_x.size();
+    m_x.resize(n);
+    m_y.resize(n);
+    m_z.resize(n);
+    const double* x = body.m_x.data();
+    const double* y = body.m_y.data();
+    const double* z = body.m_z.data();
+    for(size_t i = 0; i < n; ++i) {
+      m_x[i] = r[0][0] * x[i] + r[0][1] * y[i] + r[0][2] * z[i] + p[0];
+      m_y[i] = r[1][0] * x[i] + r[1][1] * y[i] + r[1][2] * z[i] + p[1];
+      m_z[i] = r[2][0] * x[i] + r[2][1] * y[i] + r[2][2] * z[i] + p[2];
+    }
+
+    for(auto i : m_hits)
+      if(AnyInside(m_volumes[i], m_x.data(), m_y.data(), m_z.data(), n))
+        return false;
+  }
+  return true;
+}
+
+
+template<class MPTraits>
+bool
+AvoidRegionValidity<MPTraits>::
+AnyInside(const Volume& _v, const double* _x, const double* _y,
+    const double* _z, size_t _n) {
+  //Test in chunks without branching inside them, stopping at the first chunk
+  //with a hit
+  static const size_t chunk = 64;
+  for(size_t first = 0; first < _n; first += chunk) {
+    size_t last = min(first + chunk, _n);
+    bool hit = false;
+    if(_v.m_sphere) {
+      const double cx = _v.m_center[0], cy = _v.m_center[1],
+          cz = _v.m_center[2];
+      const double zw = _v.m_flat ? 0 : 1;
+      const double r2 = _v.m_radius * _v.m_radius;
+      for(size_t i = first; i < last; ++i) {
+        double dx = _x[i] - cx, dy = _y[i] - cy, dz = (_z[i] - cz) * zw;
+        hit |= dx * dx + dy * dy + dz * dz <= r2;
+      }
+    }
+    else {
+      const double x0 = _v.m_min[0], y0 = _v.m_min[1], z0 = _v.m_min[2];
+      const double x1 = _v.m_max[0], y1 = _v.m_max[1], z1 = _v.m_max[2];
+      for(size_t i = first; i < last; ++i)
+        hit |= (_x[i] >= x0) & (_x[i] <= x1) & (_y[i] >= y0) & (_y[i] <= y1) &
+            (_z[i] >= z0) & (_z[i] <= z1);
+    }
+    if(hit)
+      return true;
+  }
+  return false;
+}
+
+/*------------------------------- Region Tree --------------------------------*/
+
+template<class MPTraits>
+void
+AvoidRegionValidity<MPTraits>::
+UpdateRegions() {
+  //the environment counts every addition, removal, and move of an avoid
+  //region, so an unchanged count means an unchanged tree
+  EnvModel* env = GetVizmo().GetEnv();
+  size_t version = env->GetAvoidRegionVersion();
+  if(version == m_version)
+    return;
+  m_version = version;
+
+  const vector<EnvModel::RegionModelPtr>& avoidRegions =
+      env->GetAvoidRegions();
+  m_volumes.resize(avoidRegions.size());
+  for(size_t i = 0; i < avoidRegions.size(); ++i) {
+    const EnvModel::RegionModelPtr& r = avoidRegions[i];
+    Volume& v = m_volumes[i];
+    RegionModel::Shape shape = r->GetShape();
+    v.m_sphere = shape == RegionModel::SPHERE ||
+        shape == RegionModel::SPHERE2D;
+    v.m_flat = shape == RegionModel::BOX2D || shape == RegionModel::SPHERE2D;
+    v.m_center = r->GetCenter();
+    v.m_radius = r->GetLongLength() / 2;
+    r->GetBoundingBox(v.m_min, v.m_max);
+  }
+
+  m_order.resize(m_volumes.size());
+  for(size_t i = 0; i < m_order.size(); ++i)
+    m_order[i] = i;
+  m_nodes.clear();
+  if(!m_volumes.empty())
+    Build(0, m_volumes.size());
+}
+
+
+template<class MPTraits>
+size_t
+AvoidRegionValidity<MPTraits>::
+Build(size_t _first, size_t _last) {
+  size_t index = m_nodes.size();
+  m_nodes.push_back(Node());
+
+  Point3d mn(numeric_limits<double>::max(), numeric_limits<double>::max(),
+      numeric_limits<double>::max());
+  Point3d mx = -1 * mn;
+  for(size_t i = _first; i < _last; ++i) {
+    const Volume& v = m_volumes[m_order[i]];
+    for(size_t j = 0; j < 3; ++j) {
+      mn[j] = min(mn[j], v.m_min[j]);
+      mx[j] = max(mx[j], v.m_max[j]);
+    }
+  }
+
+  Node& node = m_nodes[index];
+  node.m_min = mn;
+  node.m_max = mx;
+  node.m_first = _first;
+  node.m_last = _last;
+  if(_last - _first <= 2)
+    return index;
+
+  //Split at the median center along the widest axis. Planar regions are
+  //unbounded in z, so their centers are taken at zero.
+  auto center = [&](size_t _i, size_t _axis) {
+    const Volume& v = m_volumes[_i];
+    return _axis == 2 && v.m_flat ? 0. : 0.5 * (v.m_min[_axis] +
+        v.m_max[_axis]);
+  };
+  size_t axis = 0;
+  double widest = -1;
+  for(size_t j = 0; j < 3; ++j) {
+    double lo = numeric_limits<double>::max(), hi = -lo;
+    for(size_t i = _first; i < _last; ++i) {
+      lo = min(lo, center(m_order[i], j));
+      hi = max(hi, center(m_order[i], j));
+    }
+    if(hi - lo > widest) {
+      widest = hi - lo;
+      axis = j;
+    }
+  }
+  size_t mid = (_first + _last) / 2;
+  nth_element(m_order.begin() + _first, m_order.begin() + mid,
+      m_order.begin() + _last, [&](size_t _a, size_t _b) {
+        return center(_a, axis) < center(_b, axis);
+      });
+
+  size_t left = Build(_first, mid);
+  size_t right = Build(mid, _last);
+  m_nodes[index].m_left = left;
+  m_nodes[index].m_right = right;
+  return index;
+}
+
+
+template<class MPTraits>
+void
+AvoidRegionValidity<MPTraits>::
+Overlapping(const Point3d& _center, double _radius, vector<size_t>& _hits)
+    const {
+  auto boxDistanceSqr = [&](const Point3d& _min, const Point3d& _max,
+      bool _flat) {
+    double d = 0;
+    for(size_t i = 0; i < (_flat ? 2 : 3); ++i) {
+      double e = max(max(_min[i] - _center[i], _center[i] - _max[i]), 0.);
+      d += e * e;
+    }
+    return d;
+  };
+  double r2 = _radius * _radius;
+
+  vector<size_t> stack;
+  if(!m_nodes.empty())
+    stack.push_back(0);
+  while(!stack.empty()) {
+    const Node& node = m_nodes[stack.back()];
+    stack.pop_back();
+    if(boxDistanceSqr(node.m_min, node.m_max, false) > r2)
+      continue;
+    if(node.m_left) {
+      stack.push_back(node.m_left);
+      stack.push_back(node.m_right);
+      continue;
+    }
+    for(size_t i = node.m_first; i < node.m_last; ++i) {
+      const Volume& v = m_volumes[m_order[i]];
+      if(v.m_sphere) {
+        Vector3d d = _center - v.m_center;
+        if(v.m_flat)
+          d[2] = 0;
+        if(d.norm() <= v.m_radius + _radius)
+          _hits.push_back(m_order[i]);
+      }
+      else if(boxDistanceSqr(v.m_min, v.m_max, v.m_flat) <= r2)
+        _hits.push_back(m_order[i]);
+    }
+  }
+}
+
+/*--------------------------------- Helpers ----------------------------------*/
+
+template<class MPTraits>
+const typename AvoidRegionValidity<MPTraits>::BodyPoints&
+AvoidRegionValidity<MPTraits>::
+GetBodyPoints(GMSPolyhedron& _poly) {
+  BodyPoints& body = m_bodies[&_poly];
+  if(body.m_x.size() == _poly.m_vertexList.size() && !body.m_x.empty())
+    return body;
+
+  body.m_x.clear();
+  body.m_y.clear();
+  body.m_z.clear();
+  Vector3d mn(numeric_limits<double>::max(), numeric_limits<double>::max(),
+      numeric_limits<double>::max());
+  Vector3d mx = -1 * mn;
+  for(auto& v : _poly.m_vertexList) {
+    body.m_x.push_back(v[0]);
+    body.m_y.push_back(v[1]);
+    body.m_z.push_back(v[2]);
+    for(size_t i = 0; i < 3; ++i) {
+      mn[i] = min(mn[i], v[i]);
+      mx[i] = max(mx[i], v[i]);
+    }
+  }
+  body.m_center = body.m_x.empty() ? Vector3d() : 0.5 * (mn + mx);
+  body.m_radius = 0;
+  for(auto& v : _poly.m_vertexList)
+    body.m_radius = max(body.m_radius, (v - body.m_center).norm());
+  return body;
+}
+
 /*----------------------------------------------------------------------------*/
 
 #endif
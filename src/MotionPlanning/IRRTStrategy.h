@@ -159,6 +159,7 @@ void
 IRRTStrategy<MPTraits>::
 Iterate() {
   BasicRRTStrategy<MPTraits>::Iterate();
+  GetVizmo().PlanningCheckpoint();
 }
 
 
@@ -213,6 +213,8 @@ Run() {
 
     //connect cfgs with path connector
     ConnectPath(vids);
+
+    GetVizmo().PlanningCheckpoint();
   }
 
   //try to connect all endpoints
@@ -111,6 +111,7 @@ RegionRRT<MPTraits>::
 Iterate() {
   BasicRRTStrategy<MPTraits>::Iterate();
   GetVizmo().ProcessAvoidRegions();
+  GetVizmo().PlanningCheckpoint();
   //usleep(10000);
 }
 
@@ -190,7 +190,7 @@ Iterate() {
     RecommendRegions(vids, m_iteration);
 
   GetVizmo().ProcessAvoidRegions();
-  GetVizmo().GetMap()->RefreshMap();
+  GetVizmo().PlanningCheckpoint();
 }
 
 
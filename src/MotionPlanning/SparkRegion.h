@@ -91,7 +91,7 @@ Iterate() {
       this->CheckNarrowPassageSample(*vit);
   }
 
-  GetVizmo().GetMap()->RefreshMap();
+  GetVizmo().PlanningCheckpoint();
 }
 
 
@@ -0,0 +1,232 @@
+#include "BinaryRoadmap.h"
+
+#include <cstdio>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "VizmoExceptions.h"
+
+namespace BinaryRoadmap {
+
+  static const char magic[8] = {'V', 'Z', 'R', 'D', 'M', 'A', 'P', 0};
+  static const uint32_t version = 1;
+
+
+  bool
+  IsBinary(const string& _filename) {
+    ifstream ifs(_filename, ios::binary);
+    char buffer[sizeof(magic)];
+    return ifs.read(buffer, sizeof(magic)) &&
+        memcmp(buffer, magic, sizeof(magic)) == 0;
+  }
+
+
+  size_t
+  BlobPadding(size_t _length) {
+    return (_length + 7) / 8 * 8;
+  }
+
+
+  bool
+  HasBinaryExtension(const string& _filename) {
+    size_t pos = _filename.rfind('.');
+    return pos != string::npos && _filename.substr(pos) == ".bmap";
+  }
+
+  /*--------------------------------- Reader ---------------------------------*/
+
+  Reader::
+  Reader(const string& _filename) {
+    int fd = open(_filename.c_str(), O_RDONLY);
+    if(fd < 0)
+      throw ParseException(WHERE, "Cannot open '" + _filename + "'.");
+
+    struct stat info;
+    if(fstat(fd, &info) == 0 && size_t(info.st_size) >= sizeof(Header)) {
+      m_size = info.st_size;
+      void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(data != MAP_FAILED)
+        m_data = static_cast<const char*>(data);
+    }
+    close(fd);
+    if(!m_data)
+      throw ParseException(WHERE, "Cannot map '" + _filename + "'.");
+
+    //The sections are read in order, so let the kernel read ahead
+    madvise(const_cast<char*>(m_data), m_size, MADV_SEQUENTIAL);
+
+    m_header = reinterpret_cast<const Header*>(m_data);
+    string error;
+    if(memcmp(m_header->m_magic, magic, sizeof(magic)) != 0)
+      error = "is not a binary roadmap";
+    else if(m_header->m_version != version)
+      error = "has unsupported version " + to_string(m_header->m_version);
+    else
+      for(size_t i = 0; i < NumSections && error.empty(); ++i)
+        if(m_header->m_offsets[i] % 8 ||
+            m_header->m_offsets[i] > m_size ||
+            m_header->m_sizes[i] > m_size - m_header->m_offsets[i])
+          error = "has a truncated or corrupt section";
+
+    //Check the fixed-size sections against the counts, bounding the counts
+    //first so that the products cannot overflow
+    const Header& h = *m_header;
+    if(error.empty() && (h.m_numVertices > m_size / 8 ||
+        h.m_numEdges > m_size / 8 ||
+        (h.m_dofs && h.m_numVertices > m_size / 8 / h.m_dofs)))
+      error = "has inconsistent section sizes";
+    if(error.empty() && (
+        h.m_sizes[VIDs] != 8 * h.m_numVertices ||
+        h.m_sizes[DOFs] != 8 * h.m_numVertices * h.m_dofs ||
+        h.m_sizes[Offsets] != 8 * (h.m_numVertices + 1) ||
+        h.m_sizes[Targets] != 8 * h.m_numEdges ||
+        h.m_sizes[Weights] != 8 * h.m_numEdges ||
+        h.m_sizes[BlobIndex] != 8 * (h.m_numEdges + 1) ||
+        Get<uint64_t>(Offsets)[h.m_numVertices] != h.m_numEdges ||
+        Get<uint64_t>(BlobIndex)[h.m_numEdges] != h.m_sizes[Blob]))
+      error = "has inconsistent section sizes";
+    if(error.empty())
+      error = CheckEdges();
+
+    if(!error.empty()) {
+      munmap(const_cast<char*>(m_data), m_size);
+      throw ParseException(WHERE, "'" + _filename + "' " + error + ".");
+    }
+  }
+
+
+  Reader::
+  ~Reader() {
+    munmap(const_cast<char*>(m_data), m_size);
+  }
+
+
+  string
+  Reader::
+  CheckEdges() const {
+    const Header& h = *m_header;
+    const uint64_t* offsets = Get<uint64_t>(Offsets);
+    if(offsets[0] != 0)
+      return "has corrupt edge offsets";
+    for(size_t i = 0; i < h.m_numVertices; ++i)
+      if(offsets[i] > offsets[i + 1])
+        return "has corrupt edge offsets";
+
+    //Each blob entry must hold its fixed part, its padded label, and its
+    //intermediates before the next entry starts
+    const uint64_t* index = Get<uint64_t>(BlobIndex);
+    const char* blob = Get<char>(Blob);
+    const uint64_t rowSize = 8 * uint64_t(h.m_dofs);
+    if(index[0] != 0)
+      return "has a corrupt edge blob";
+    for(size_t e = 0; e < h.m_numEdges; ++e) {
+      if(index[e] % 8 || index[e] > index[e + 1] ||
+          index[e + 1] - index[e] < 8)
+        return "has a corrupt edge blob";
+      uint64_t available = index[e + 1] - index[e] - 8;
+      uint32_t length, count;
+      memcpy(&length, blob + index[e], sizeof(length));
+      memcpy(&count, blob + index[e] + 4, sizeof(count));
+      if(BlobPadding(length) > available)
+        return "has a corrupt edge blob";
+      available -= BlobPadding(length);
+      if(count && (!rowSize || count > available / rowSize))
+        return "has a corrupt edge blob";
+    }
+    return "";
+  }
+
+
+  string
+  Reader::
+  GetEnvFileName() const {
+    return string(Get<char>(EnvName), m_header->m_sizes[EnvName]);
+  }
+
+
+  const double*
+  Reader::
+  GetEdgeData(size_t _edge, string& _label, size_t& _count) const {
+    const char* p = Get<char>(Blob) + Get<uint64_t>(BlobIndex)[_edge];
+    uint32_t length, count;
+    memcpy(&length, p, sizeof(length));
+    memcpy(&count, p + 4, sizeof(count));
+    _label.assign(p + 8, length);
+    _count = count;
+    p += 8 + BlobPadding(length);
+    return reinterpret_cast<const double*>(p);
+  }
+
+  /*--------------------------------- Writer ---------------------------------*/
+
+  Writer::
+  Writer(const string& _filename, uint32_t _dofs, uint64_t _robotIndex,
+      uint64_t _numVertices, uint64_t _numEdges) : m_filename(_filename),
+      m_tempName(_filename + ".tmp"),
+      m_file(m_tempName, ios::binary | ios::trunc) {
+    if(!m_file)
+      throw ParseException(WHERE, "Cannot write '" + m_tempName + "'.");
+
+    memset(&m_header, 0, sizeof(m_header));
+    memcpy(m_header.m_magic, magic, sizeof(magic));
+    m_header.m_version = version;
+    m_header.m_dofs = _dofs;
+    m_header.m_robotIndex = _robotIndex;
+    m_header.m_numVertices = _numVertices;
+    m_header.m_numEdges = _numEdges;
+
+    //Reserve room for the header, which is filled in by Close
+    Write(m_header);
+  }
+
+
+  Writer::
+  ~Writer() {
+    //A writer destroyed without Close, e.g. by an exception, drops its file
+    if(!m_closed) {
+      m_file.close();
+      remove(m_tempName.c_str());
+    }
+  }
+
+
+  void
+  Writer::
+  Begin(Section _s) {
+    if(m_section >= 0)
+      m_header.m_sizes[m_section] = m_position - m_header.m_offsets[m_section];
+
+    static const char padding[8] = {};
+    Write(padding, (8 - m_position % 8) % 8);
+    m_section = _s;
+    m_header.m_offsets[_s] = m_position;
+  }
+
+
+  void
+  Writer::
+  Write(const void* _data, size_t _size) {
+    m_file.write(static_cast<const char*>(_data), _size);
+    m_position += _size;
+  }
+
+
+  void
+  Writer::
+  Close() {
+    if(m_section >= 0)
+      m_header.m_sizes[m_section] = m_position - m_header.m_offsets[m_section];
+    m_file.seekp(0);
+    m_file.write(reinterpret_cast<const char*>(&m_header), sizeof(m_header));
+    m_file.close();
+    if(m_file.fail())
+      throw ParseException(WHERE, "Failed writing binary roadmap.");
+    if(rename(m_tempName.c_str(), m_filename.c_str()) != 0)
+      throw ParseException(WHERE, "Cannot replace '" + m_filename + "'.");
+    m_closed = true;
+  }
+}
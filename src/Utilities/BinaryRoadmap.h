@@ -0,0 +1,156 @@
+#ifndef BINARY_ROADMAP_H_
+#define BINARY_ROADMAP_H_
+
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <vector>
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief   Reading and writing of the binary roadmap format (.bmap).
+/// \details A file holds a fixed header followed by sections at 8-byte aligned
+///          offsets recorded in the header:
+///          \arg \c EnvName   The environment file name, as in a .map header.
+///          \arg \c VIDs      One uint64 VID per vertex.
+///          \arg \c DOFs      Fixed-stride double DOF values, one row per
+///                            vertex.
+///          \arg \c Offsets   CSR row offsets, numVertices + 1 uint64 values
+///                            indexing the edge arrays by source vertex.
+///          \arg \c Targets   One uint64 target VID per edge.
+///          \arg \c Weights   One double weight per edge.
+///          \arg \c Blob      Per-edge variable data: a uint32 local planner
+///                            label length, a uint32 intermediate count, the
+///                            label padded to 8 bytes, and the intermediates'
+///                            DOF rows.
+///          \arg \c BlobIndex numEdges + 1 uint64 offsets into the blob.
+///          Values are stored in host byte order. The reader maps the file
+///          into memory and hands out pointers to the sections directly.
+////////////////////////////////////////////////////////////////////////////////
+namespace BinaryRoadmap {
+
+  enum Section {EnvName, VIDs, DOFs, Offsets, Targets, Weights, Blob,
+    BlobIndex, NumSections};
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief The fixed-size file header.
+  struct Header {
+    char m_magic[8];          ///< Identifies the format.
+    uint32_t m_version;       ///< Format version.
+    uint32_t m_dofs;          ///< DOFs per configuration.
+    uint64_t m_robotIndex;    ///< The robot the configurations belong to.
+    uint64_t m_numVertices;   ///< Number of vertices.
+    uint64_t m_numEdges;      ///< Number of edges.
+    uint64_t m_offsets[NumSections]; ///< File offset of each section.
+    uint64_t m_sizes[NumSections];   ///< Size of each section in bytes.
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Check whether a file is in the binary roadmap format.
+  bool IsBinary(const string& _filename);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Check whether a file name asks for the binary roadmap format.
+  bool HasBinaryExtension(const string& _filename);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the space taken by an edge label in the blob.
+  size_t BlobPadding(size_t _length);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief A read-only memory mapping of a binary roadmap file.
+  class Reader {
+
+    public:
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Map a file and check its header, its section bounds, and that
+      ///        the row offsets and blob entries stay inside their sections.
+      /// \throws ParseException if the file cannot be mapped or is malformed.
+      Reader(const string& _filename);
+      ~Reader();
+
+      Reader(const Reader&) = delete;
+      Reader& operator=(const Reader&) = delete;
+
+      const Header& GetHeader() const {return *m_header;}
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Get the environment file name stored in the file.
+      string GetEnvFileName() const;
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Get a pointer to the start of a section.
+      template <typename T>
+      const T* Get(Section _s) const {
+        return reinterpret_cast<const T*>(m_data + m_header->m_offsets[_s]);
+      }
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Decode the variable data of an edge.
+      /// \param[in] _edge The edge index.
+      /// \param[out] _label The local planner label.
+      /// \param[out] _count The number of intermediates.
+      /// \return The intermediates' DOF rows.
+      const double* GetEdgeData(size_t _edge, string& _label, size_t& _count)
+          const;
+
+    private:
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Check the CSR offsets and the blob entries.
+      /// \return An error message, or empty if they are consistent.
+      string CheckEdges() const;
+
+      const char* m_data{nullptr};     ///< The mapped file.
+      size_t m_size{0};                ///< The mapped size.
+      const Header* m_header{nullptr}; ///< The header at the file start.
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief   A sequential writer for binary roadmap files.
+  /// \details Write the sections in any order by calling Begin and then Write
+  ///          for each. Close fills in the header. The file is written under
+  ///          a temporary name and only replaces the target in Close, so a
+  ///          failed write leaves an existing file intact.
+  class Writer {
+
+    public:
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \throws ParseException if the file cannot be opened.
+      Writer(const string& _filename, uint32_t _dofs, uint64_t _robotIndex,
+          uint64_t _numVertices, uint64_t _numEdges);
+      ~Writer();
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Start a section at the next aligned offset.
+      void Begin(Section _s);
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Append raw bytes to the current section.
+      void Write(const void* _data, size_t _size);
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Append a value to the current section.
+      template <typename T>
+      void Write(const T& _value) {Write(&_value, sizeof(T));}
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \brief Finish the last section and write the header.
+      /// \throws ParseException if any write failed.
+      void Close();
+
+    private:
+
+      string m_filename;        ///< The target file.
+      string m_tempName;        ///< The file being written.
+      bool m_closed{false};     ///< Was the file renamed into place?
+      ofstream m_file;          ///< The output file.
+      Header m_header;          ///< The header being filled in.
+      int m_section{-1};        ///< The section being written.
+      uint64_t m_position{0};   ///< Current file offset.
+  };
+}
+
+#endif
@@ -0,0 +1,112 @@
+#include "Frustum.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+using namespace std;
+
+#ifdef __APPLE__
+  #include <OpenGL/gl.h>
+#else
+  #include <gl.h>
+#endif
+
+
+void
+Frustum::
+Update() {
+  GLint viewport[4];
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  Update(viewport[0], viewport[1], viewport[0] + viewport[2],
+      viewport[1] + viewport[3]);
+}
+
+
+void
+Frustum::
+Update(double _left, double _bottom, double _right, double _top) {
+  GLint viewport[4];
+  double modelView[16], proj[16], m[16];
+
+  glGetIntegerv(GL_VIEWPORT, viewport);
+  glGetDoublev(GL_MODELVIEW_MATRIX, modelView);
+  glGetDoublev(GL_PROJECTION_MATRIX, proj);
+
+  //m = proj * modelView, column-major
+  for(size_t c = 0; c < 4; ++c)
+    for(size_t r = 0; r < 4; ++r) {
+      m[4*c + r] = 0;
+      for(size_t k = 0; k < 4; ++k)
+        m[4*c + r] += proj[4*k + r] * modelView[4*c + k];
+    }
+
+  //Bounds of the rectangle in normalized device coordinates
+  double bounds[3][2] = {
+    {2 * (_left - viewport[0]) / viewport[2] - 1,
+      2 * (_right - viewport[0]) / viewport[2] - 1},
+    {2 * (_bottom - viewport[1]) / viewport[3] - 1,
+      2 * (_top - viewport[1]) / viewport[3] - 1},
+    {-1, 1}};
+
+  //Each clip plane bounds the x, y, or z row by a multiple of the w row.
+  for(size_t i = 0; i < 6; ++i) {
+    size_t row = i / 2;
+    double* p = m_planes[i];
+    for(size_t c = 0; c < 4; ++c)
+      p[c] = i % 2 ? bounds[row][1] * m[4*c + 3] - m[4*c + row] :
+          m[4*c + row] - bounds[row][0] * m[4*c + 3];
+
+    double norm = sqrt(p[0]*p[0] + p[1]*p[1] + p[2]*p[2]);
+    for(size_t c = 0; c < 4; ++c)
+      p[c] /= norm;
+  }
+
+  for(size_t c = 0; c < 4; ++c)
+    m_depth[c] = m[4*c + 3];
+  m_pixelScale = proj[5] * viewport[3] / 2;
+}
+
+
+bool
+Frustum::
+IsOutside(const Point3d& _center, double _radius) const {
+  for(size_t i = 0; i < 6; ++i) {
+    const double* p = m_planes[i];
+    if(p[0]*_center[0] + p[1]*_center[1] + p[2]*_center[2] + p[3] < -_radius)
+      return true;
+  }
+  return false;
+}
+
+
+bool
+Frustum::
+IsOutside(const Point3d& _a, const Point3d& _b) const {
+  //Clip the segment against each plane in turn
+  double t0 = 0, t1 = 1;
+  for(size_t i = 0; i < 6; ++i) {
+    const double* p = m_planes[i];
+    double da = p[0]*_a[0] + p[1]*_a[1] + p[2]*_a[2] + p[3];
+    double db = p[0]*_b[0] + p[1]*_b[1] + p[2]*_b[2] + p[3];
+    if(da < 0 && db < 0)
+      return true;
+    if(da < 0)
+      t0 = max(t0, da / (da - db));
+    else if(db < 0)
+      t1 = min(t1, da / (da - db));
+    if(t0 > t1)
+      return true;
+  }
+  return false;
+}
+
+
+double
+Frustum::
+PixelRadius(const Point3d& _center, double _radius) const {
+  double w = m_depth[0]*_center[0] + m_depth[1]*_center[1] +
+      m_depth[2]*_center[2] + m_depth[3];
+  if(w <= _radius)
+    return numeric_limits<double>::infinity();
+  return _radius * m_pixelScale / w;
+}
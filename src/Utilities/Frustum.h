@@ -0,0 +1,69 @@
+#ifndef FRUSTUM_H_
+#define FRUSTUM_H_
+
+#include "Vector.h"
+using namespace mathtool;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief   The world-space view volume of the OpenGL scene, used to skip
+///          objects that are off screen or too small to see.
+/// \details The planes are extracted from the current projection and modelview
+///          matrices, so the frustum follows whatever camera was last applied.
+////////////////////////////////////////////////////////////////////////////////
+class Frustum {
+
+  public:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Recompute the frustum from the current GL matrices and viewport.
+    void Update();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Recompute the frustum from the current GL matrices, narrowed to
+    ///        the part of the view behind a window rectangle.
+    /// \param[in] _left The left edge in window coordinates.
+    /// \param[in] _bottom The bottom edge in window coordinates.
+    /// \param[in] _right The right edge in window coordinates.
+    /// \param[in] _top The top edge in window coordinates.
+    void Update(double _left, double _bottom, double _right, double _top);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Check whether a bounding sphere lies entirely outside the view.
+    /// \param[in] _center The sphere center in world coordinates.
+    /// \param[in] _radius The sphere radius.
+    bool IsOutside(const Point3d& _center, double _radius) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Check whether a line segment lies entirely outside the view.
+    /// \param[in] _a The first endpoint in world coordinates.
+    /// \param[in] _b The second endpoint in world coordinates.
+    bool IsOutside(const Point3d& _a, const Point3d& _b) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Estimate the on-screen radius of a bounding sphere in pixels.
+    /// \param[in] _center The sphere center in world coordinates.
+    /// \param[in] _radius The sphere radius.
+    /// \return The projected radius, or infinity if the sphere reaches the eye.
+    double PixelRadius(const Point3d& _center, double _radius) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Check whether a bounding sphere projects smaller than the
+    ///        minimum feature size.
+    bool IsSmall(const Point3d& _center, double _radius) const {
+      return PixelRadius(_center, _radius) < m_minPixelRadius;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Set the projected radius in pixels below which objects are
+    ///        considered too small to draw in full.
+    void SetMinPixelRadius(double _r) {m_minPixelRadius = _r;}
+
+  private:
+
+    double m_planes[6][4];        ///< Inward-facing planes (a, b, c, d).
+    double m_depth[4];            ///< Row of the view matrix giving clip w.
+    double m_pixelScale{0};       ///< Pixels per unit size at unit depth.
+    double m_minPixelRadius{1};   ///< Small-feature threshold in pixels.
+};
+
+#endif
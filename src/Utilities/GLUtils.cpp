@@ -77,6 +77,27 @@ namespace GLUtils {
   }
 
 
+  void
+  WindowRay(double _x, double _y, Point3d& _origin, Vector3d& _dir) {
+    //Get matrix info
+    int viewPort[4];
+    double modelViewM[16], projM[16];
+
+    glGetIntegerv(GL_VIEWPORT, viewPort);
+    glGetDoublev(GL_MODELVIEW_MATRIX, modelViewM);
+    glGetDoublev(GL_PROJECTION_MATRIX, projM);
+
+    Point3d e;
+    gluUnProject(_x, _y, 0,
+        modelViewM, projM, viewPort,
+        &_origin[0], &_origin[1], &_origin[2]);
+    gluUnProject(_x, _y, 1.0,
+        modelViewM, projM, viewPort,
+        &e[0], &e[1], &e[2]);
+    _dir = (e - _origin).normalize();
+  }
+
+
   void
   DrawCircle(double _r, bool _fill, unsigned short _segments) {
     GLfloat incr = TWOPI / _segments;
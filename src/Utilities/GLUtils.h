@@ -51,6 +51,14 @@ namespace GLUtils {
   /// \return         The projected point in world coordinates.
   Point3d ProjectToWorld(double _x, double _y, const Point3d& _ref = Point3d(),
       const Vector3d& _n = Vector3d(0, 0, 1.));
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the world-space ray shot from a point in window coordinates
+  ///        along the screen-in direction.
+  /// \param[in]  _x      The input window-x coordinate.
+  /// \param[in]  _y      The input window-y coordinate.
+  /// \param[out] _origin The ray origin on the near plane.
+  /// \param[out] _dir    The unit ray direction.
+  void WindowRay(double _x, double _y, Point3d& _origin, Vector3d& _dir);
 
   // Drawing helpers
   //////////////////////////////////////////////////////////////////////////////
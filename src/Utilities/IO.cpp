@@ -2,6 +2,8 @@
 
 #include <fstream>
 
+#include "BinaryRoadmap.h"
+
 #include <Models/EnvModel.h>
 #include <Models/Vizmo.h>
 
@@ -12,6 +14,9 @@ string ParseMapHeader(const string& _filename) {
   if(!FileExists(_filename))
     throw ParseException(WHERE, "File '" + _filename + "' does not exist.");
 
+  if(BinaryRoadmap::IsBinary(_filename))
+    return envDir + BinaryRoadmap::Reader(_filename).GetEnvFileName();
+
   ifstream ifs(_filename);
 
   //Open file for reading data
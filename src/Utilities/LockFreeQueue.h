@@ -0,0 +1,71 @@
+#ifndef LOCK_FREE_QUEUE_H_
+#define LOCK_FREE_QUEUE_H_
+
+#include <atomic>
+#include <utility>
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief   An unbounded queue for handing values from one producer thread to
+///          one consumer thread without locking.
+/// \details The queue is a linked list which always holds a stub node. The
+///          producer links new nodes after the last one, and the consumer
+///          moves the value out of the node after the stub, which then
+///          becomes the stub. Each end is touched by one thread only, so the
+///          link between them is the only shared state.
+////////////////////////////////////////////////////////////////////////////////
+template <typename T>
+class LockFreeQueue {
+
+  public:
+
+    LockFreeQueue() : m_last(new Node), m_stub(m_last) {}
+
+    ~LockFreeQueue() {
+      while(m_stub) {
+        Node* next = m_stub->m_next.load(memory_order_relaxed);
+        delete m_stub;
+        m_stub = next;
+      }
+    }
+
+    LockFreeQueue(const LockFreeQueue&) = delete;
+    LockFreeQueue& operator=(const LockFreeQueue&) = delete;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Add a value. Call from the producer thread only.
+    void Push(T&& _value) {
+      Node* node = new Node;
+      node->m_value = move(_value);
+      m_last->m_next.store(node, memory_order_release);
+      m_last = node;
+    }
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Take the oldest value. Call from the consumer thread only.
+    /// \param[out] _value The value taken.
+    /// \return False if the queue was empty.
+    bool Pop(T& _value) {
+      Node* next = m_stub->m_next.load(memory_order_acquire);
+      if(!next)
+        return false;
+      _value = move(next->m_value);
+      delete m_stub;
+      m_stub = next;
+      return true;
+    }
+
+  private:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief A list node.
+    struct Node {
+      T m_value{};                     ///< The value, empty in the stub.
+      atomic<Node*> m_next{nullptr};   ///< The next node.
+    };
+
+    Node* m_last; ///< The last node, owned by the producer.
+    Node* m_stub; ///< The stub before the oldest value, owned by the consumer.
+};
+
+#endif
@@ -0,0 +1,19 @@
+#ifndef PARSE_PROGRESS_H_
+#define PARSE_PROGRESS_H_
+
+#include <atomic>
+#include <cstddef>
+using namespace std;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Progress and cancellation state shared between a file parse running
+///        on a worker thread and the GUI thread watching it.
+////////////////////////////////////////////////////////////////////////////////
+struct ParseProgress {
+  atomic<size_t> m_bytes{0};    ///< Bytes parsed so far.
+  atomic<size_t> m_size{0};     ///< Total bytes to parse.
+  atomic<size_t> m_items{0};    ///< Records (e.g., vertices) parsed so far.
+  atomic<bool> m_cancel{false}; ///< Set by the watcher to stop the parse.
+};
+
+#endif
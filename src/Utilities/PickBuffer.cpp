@@ -0,0 +1,157 @@
+#include "PickBuffer.h"
+
+#include <cstdlib>
+#include <limits>
+#include <set>
+
+
+namespace PickBuffer {
+
+  static bool active = false;      ///< Is a pick pass running?
+  static vector<GLuint> nameStack; ///< The current name path.
+  static vector<GLuint> names;     ///< All name paths, back to back.
+  static vector<size_t> ends;      ///< End of each ID's path in names.
+  static GLint rect[4];            ///< The pick rectangle.
+  static GLuint texture = 0;       ///< Texture enabling the constant color.
+
+  static const size_t maxID = (1 << 24) - 1; ///< IDs must fit in 24-bit RGB.
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Give the current name path a new ID and draw in its color.
+  static void
+  ApplyName() {
+    //ID 0 is the background; paths past the last ID are unpickable
+    size_t id = ends.size() + 1;
+    if(id <= maxID) {
+      names.insert(names.end(), nameStack.begin(), nameStack.end());
+      ends.push_back(names.size());
+    }
+    else
+      id = 0;
+
+    GLfloat color[4] = {(id & 0xff) / 255.f, ((id >> 8) & 0xff) / 255.f,
+        ((id >> 16) & 0xff) / 255.f, 1};
+    glTexEnvfv(GL_TEXTURE_ENV, GL_TEXTURE_ENV_COLOR, color);
+  }
+
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the name path of an ID.
+  static vector<GLuint>
+  GetPath(size_t _id) {
+    size_t start = _id > 1 ? ends[_id - 2] : 0;
+    vector<GLuint> path(names.begin() + start, names.begin() + ends[_id - 1]);
+    //models read one name past the path for empty paths, as with GL_SELECT
+    path.push_back(0);
+    return path;
+  }
+
+
+  void
+  PushName(GLuint _name) {
+    if(!active)
+      return;
+    nameStack.push_back(_name);
+    ApplyName();
+  }
+
+
+  void
+  PopName() {
+    if(!active || nameStack.empty())
+      return;
+    nameStack.pop_back();
+    ApplyName();
+  }
+
+
+  void
+  Begin(int _x, int _y, int _w, int _h) {
+    rect[0] = _x;
+    rect[1] = _y;
+    rect[2] = _w;
+    rect[3] = _h;
+
+    glPushAttrib(GL_ALL_ATTRIB_BITS);
+
+    //A texture unit in GL_COMBINE mode replaces the fragment color with the
+    //constant environment color, whatever the models set for color, lighting,
+    //or material. The texture itself only has to be complete.
+    if(!texture) {
+      GLubyte white[4] = {255, 255, 255, 255};
+      glGenTextures(1, &texture);
+      glBindTexture(GL_TEXTURE_2D, texture);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+      glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+      glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, 1, 1, 0, GL_RGBA,
+          GL_UNSIGNED_BYTE, white);
+    }
+    glEnable(GL_TEXTURE_2D);
+    glBindTexture(GL_TEXTURE_2D, texture);
+    glTexEnvi(GL_TEXTURE_ENV, GL_TEXTURE_ENV_MODE, GL_COMBINE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_RGB, GL_REPLACE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_RGB, GL_CONSTANT);
+    glTexEnvi(GL_TEXTURE_ENV, GL_COMBINE_ALPHA, GL_REPLACE);
+    glTexEnvi(GL_TEXTURE_ENV, GL_SOURCE0_ALPHA, GL_CONSTANT);
+
+    //Keep the colors exact
+    glBlendFunc(GL_ONE, GL_ZERO);
+    glDisable(GL_DITHER);
+    glDisable(GL_FOG);
+    glShadeModel(GL_FLAT);
+
+    //Only the pick rectangle is drawn and read
+    glEnable(GL_SCISSOR_TEST);
+    glScissor(_x, _y, _w, _h);
+    glClearColor(0, 0, 0, 0);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    active = true;
+    nameStack.clear();
+    names.clear();
+    ends.clear();
+    ApplyName();
+  }
+
+
+  vector<vector<GLuint>>
+  End(bool _all) {
+    vector<GLubyte> pixels(4 * rect[2] * rect[3]);
+    glPixelStorei(GL_PACK_ALIGNMENT, 1);
+    glReadPixels(rect[0], rect[1], rect[2], rect[3], GL_RGBA, GL_UNSIGNED_BYTE,
+        pixels.data());
+    glPopAttrib();
+    active = false;
+
+    //Collect the IDs in the rectangle, or the one closest to its center
+    set<size_t> ids;
+    size_t closest = 0;
+    int closestDist = numeric_limits<int>::max();
+    for(int y = 0; y < rect[3]; ++y) {
+      for(int x = 0; x < rect[2]; ++x) {
+        const GLubyte* p = &pixels[4 * (y * rect[2] + x)];
+        size_t id = p[0] | p[1] << 8 | p[2] << 16;
+        if(id == 0 || id > ends.size())
+          continue;
+        if(_all)
+          ids.insert(id);
+        else {
+          int dist = abs(2 * x - rect[2]) + abs(2 * y - rect[3]);
+          if(dist < closestDist) {
+            closestDist = dist;
+            closest = id;
+          }
+        }
+      }
+    }
+    if(closest)
+      ids.insert(closest);
+
+    vector<vector<GLuint>> paths;
+    for(auto id : ids)
+      if(ends[id - 1] > (id > 1 ? ends[id - 2] : 0))
+        paths.push_back(GetPath(id));
+    return paths;
+  }
+}
@@ -0,0 +1,48 @@
+#ifndef PICK_BUFFER_H_
+#define PICK_BUFFER_H_
+
+#include <vector>
+using namespace std;
+
+#ifdef __APPLE__
+  #include <OpenGL/gl.h>
+#else
+  #include <gl.h>
+#endif
+
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief   Provides color-ID picking in place of the GL_SELECT render mode.
+/// \details Models label what they draw in DrawSelect with PushName and
+///          PopName, as with the GL name stack. During a pick pass each name
+///          path is drawn in its own flat color, and the colors read back from
+///          the pick rectangle identify the name paths of the visible objects.
+///          Outside of a pick pass the name functions do nothing.
+////////////////////////////////////////////////////////////////////////////////
+namespace PickBuffer {
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Push a name onto the name stack.
+  /// \param[in] _name The name to push.
+  void PushName(GLuint _name);
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Pop the last name off of the name stack.
+  void PopName();
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Start a pick pass over a window rectangle. Draw the scene with the
+  ///        current matrices after this call.
+  /// \param[in] _x The left edge in window coordinates.
+  /// \param[in] _y The bottom edge in window coordinates.
+  /// \param[in] _w The rectangle width.
+  /// \param[in] _h The rectangle height.
+  void Begin(int _x, int _y, int _w, int _h);
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Finish a pick pass and restore the GL state.
+  /// \param[in] _all Return every object visible in the rectangle (true) or
+  ///                 only the one nearest its center (false).
+  /// \return The name paths of the picked objects.
+  vector<vector<GLuint>> End(bool _all);
+}
+
+#endif
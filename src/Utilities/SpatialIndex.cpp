@@ -0,0 +1,424 @@
+#include "SpatialIndex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <queue>
+
+#include "Frustum.h"
+
+static const size_t leafSize = 8; ///< Maximum items per leaf.
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Get the squared distance from a point to a box.
+static double
+BoxDistanceSqr(const Point3d& _p, const Point3d& _min, const Point3d& _max) {
+  double d = 0;
+  for(size_t i = 0; i < 3; ++i) {
+    double e = max(max(_min[i] - _p[i], _p[i] - _max[i]), 0.);
+    d += e * e;
+  }
+  return d;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Check whether a ray passes through a box.
+static bool
+RayHitsBox(const Point3d& _origin, const Vector3d& _dir, const Point3d& _min,
+    const Point3d& _max) {
+  double t0 = 0, t1 = numeric_limits<double>::max();
+  for(size_t i = 0; i < 3; ++i) {
+    if(fabs(_dir[i]) < numeric_limits<double>::epsilon()) {
+      if(_origin[i] < _min[i] || _origin[i] > _max[i])
+        return false;
+      continue;
+    }
+    double a = (_min[i] - _origin[i]) / _dir[i];
+    double b = (_max[i] - _origin[i]) / _dir[i];
+    t0 = max(t0, min(a, b));
+    t1 = min(t1, max(a, b));
+    if(t0 > t1)
+      return false;
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Check whether two boxes overlap.
+static bool
+BoxesOverlap(const Point3d& _min1, const Point3d& _max1, const Point3d& _min2,
+    const Point3d& _max2) {
+  for(size_t i = 0; i < 3; ++i)
+    if(_max1[i] < _min2[i] || _max2[i] < _min1[i])
+      return false;
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Check whether a segment touches a box.
+static bool
+SegmentHitsBox(const Point3d& _a, const Point3d& _b, const Point3d& _min,
+    const Point3d& _max) {
+  Vector3d dir = _b - _a;
+  double t0 = 0, t1 = 1;
+  for(size_t i = 0; i < 3; ++i) {
+    if(fabs(dir[i]) < numeric_limits<double>::epsilon()) {
+      if(_a[i] < _min[i] || _a[i] > _max[i])
+        return false;
+      continue;
+    }
+    double a = (_min[i] - _a[i]) / dir[i];
+    double b = (_max[i] - _a[i]) / dir[i];
+    t0 = max(t0, min(a, b));
+    t1 = min(t1, max(a, b));
+    if(t0 > t1)
+      return false;
+  }
+  return true;
+}
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief Find the closest approach of a ray to a segment.
+/// \param[out] _t The distance along the ray of the closest point.
+/// \return The distance between the ray and the segment.
+static double
+RaySegmentDistance(const Point3d& _origin, const Vector3d& _dir,
+    const Point3d& _a, const Point3d& _b, double& _t) {
+  Vector3d v = _b - _a, w = _origin - _a;
+  double b = _dir * v, c = v * v, d = _dir * w, e = v * w;
+  double denom = c - b * b;
+
+  //Closest points of the two lines, then clamped to the ray and the segment
+  double s = denom > numeric_limits<double>::epsilon() ?
+      max(0., min(1., (e - b * d) / denom)) : 0;
+  _t = max(0., (_a + s * v - _origin) * _dir);
+  if(c > 0)
+    s = max(0., min(1., (_origin + _t * _dir - _a) * v / c));
+  return (_origin + _t * _dir - (_a + s * v)).norm();
+}
+
+/*------------------------------- Modification -------------------------------*/
+
+void
+SpatialIndex::
+Clear() {
+  m_items.clear();
+  m_order.clear();
+  m_nodes.clear();
+  m_byVID.clear();
+  m_numSorted = 0;
+  m_numRemoved = 0;
+}
+
+
+void
+SpatialIndex::
+AddPoint(VID _v, const Point3d& _p) {
+  Item item;
+  item.m_key = Key(_v, _v);
+  item.m_a = item.m_b = _p;
+  Add(item);
+}
+
+
+void
+SpatialIndex::
+AddEdge(VID _source, VID _target, const vector<Point3d>& _points) {
+  auto range = m_byVID.equal_range(_source);
+  for(auto it = range.first; it != range.second; ++it) {
+    const Item& item = m_items[it->second];
+    if(!item.m_removed && !item.IsPoint() &&
+        (item.m_key == Key(_source, _target) ||
+         item.m_key == Key(_target, _source)))
+      return;
+  }
+
+  Item item;
+  item.m_key = Key(_source, _target);
+  for(size_t i = 1; i < _points.size(); ++i) {
+    item.m_a = _points[i - 1];
+    item.m_b = _points[i];
+    Add(item);
+  }
+}
+
+
+vector<SpatialIndex::VID>
+SpatialIndex::
+Remove(VID _v) {
+  vector<VID> neighbors;
+  auto range = m_byVID.equal_range(_v);
+  for(auto it = range.first; it != range.second; ++it) {
+    Item& item = m_items[it->second];
+    if(item.m_removed)
+      continue;
+    item.m_removed = true;
+    ++m_numRemoved;
+    if(!item.IsPoint())
+      neighbors.push_back(item.m_key.first == _v ? item.m_key.second :
+          item.m_key.first);
+  }
+  m_byVID.erase(_v);
+
+  sort(neighbors.begin(), neighbors.end());
+  neighbors.erase(unique(neighbors.begin(), neighbors.end()), neighbors.end());
+  return neighbors;
+}
+
+
+void
+SpatialIndex::
+Add(const Item& _item) {
+  m_items.push_back(_item);
+  m_byVID.emplace(_item.m_key.first, m_items.size() - 1);
+  if(!_item.IsPoint())
+    m_byVID.emplace(_item.m_key.second, m_items.size() - 1);
+}
+
+
+void
+SpatialIndex::
+Refresh() {
+  size_t pending = m_items.size() - m_numSorted + m_numRemoved;
+  if(pending > 64 && pending > m_numSorted / 8)
+    Rebuild();
+}
+
+
+void
+SpatialIndex::
+Rebuild() {
+  //Compact the live items and re-map the VID lookup
+  vector<Item> items;
+  items.reserve(m_items.size() - m_numRemoved);
+  for(auto& item : m_items)
+    if(!item.m_removed)
+      items.push_back(item);
+  m_items.swap(items);
+
+  m_byVID.clear();
+  for(size_t i = 0; i < m_items.size(); ++i) {
+    m_byVID.emplace(m_items[i].m_key.first, i);
+    if(!m_items[i].IsPoint())
+      m_byVID.emplace(m_items[i].m_key.second, i);
+  }
+  m_numRemoved = 0;
+  m_numSorted = m_items.size();
+
+  m_order.resize(m_items.size());
+  for(size_t i = 0; i < m_order.size(); ++i)
+    m_order[i] = i;
+  m_nodes.clear();
+  if(!m_items.empty()) {
+    m_nodes.reserve(2 * m_items.size() / leafSize + 1);
+    Build(0, m_items.size());
+  }
+}
+
+
+size_t
+SpatialIndex::
+Build(size_t _first, size_t _last) {
+  size_t index = m_nodes.size();
+  m_nodes.push_back(Node());
+
+  Point3d mn(numeric_limits<double>::max(), numeric_limits<double>::max(),
+      numeric_limits<double>::max());
+  Point3d mx = -1 * mn;
+  Point3d cmin = mn, cmax = mx;
+  for(size_t i = _first; i < _last; ++i) {
+    const Item& item = m_items[m_order[i]];
+    Point3d c = item.Center();
+    for(size_t j = 0; j < 3; ++j) {
+      mn[j] = min(mn[j], min(item.m_a[j], item.m_b[j]));
+      mx[j] = max(mx[j], max(item.m_a[j], item.m_b[j]));
+      cmin[j] = min(cmin[j], c[j]);
+      cmax[j] = max(cmax[j], c[j]);
+    }
+  }
+
+  Node& node = m_nodes[index];
+  node.m_min = mn;
+  node.m_max = mx;
+  node.m_first = _first;
+  node.m_last = _last;
+  if(_last - _first <= leafSize)
+    return index;
+
+  //Split at the median center along the widest axis
+  size_t axis = 0;
+  for(size_t j = 1; j < 3; ++j)
+    if(cmax[j] - cmin[j] > cmax[axis] - cmin[axis])
+      axis = j;
+  size_t mid = (_first + _last) / 2;
+  nth_element(m_order.begin() + _first, m_order.begin() + mid,
+      m_order.begin() + _last, [&](size_t _a, size_t _b) {
+        return m_items[_a].Center()[axis] < m_items[_b].Center()[axis];
+      });
+
+  size_t left = Build(_first, mid);
+  size_t right = Build(mid, _last);
+  m_nodes[index].m_left = left;
+  m_nodes[index].m_right = right;
+  return index;
+}
+
+/*--------------------------------- Queries ----------------------------------*/
+
+template <typename Accept>
+void
+SpatialIndex::
+Candidates(const Accept& _accept, vector<size_t>& _items) const {
+  vector<size_t> stack;
+  if(!m_nodes.empty())
+    stack.push_back(0);
+  while(!stack.empty()) {
+    const Node& node = m_nodes[stack.back()];
+    stack.pop_back();
+    if(!_accept(node.m_min, node.m_max))
+      continue;
+    if(node.m_left) {
+      stack.push_back(node.m_left);
+      stack.push_back(node.m_right);
+    }
+    else
+      for(size_t i = node.m_first; i < node.m_last; ++i)
+        _items.push_back(m_order[i]);
+  }
+  for(size_t i = m_numSorted; i < m_items.size(); ++i)
+    _items.push_back(i);
+}
+
+
+bool
+SpatialIndex::
+PickRay(const Point3d& _origin, const Vector3d& _dir, double _radius,
+    double _slope, Key& _hit) const {
+  //Grow each box by the tolerance at its far side before the ray test
+  auto accept = [&](const Point3d& _min, const Point3d& _max) {
+    Point3d center = 0.5 * (_min + _max);
+    double far = (center - _origin).norm() + (_max - center).norm();
+    double r = _radius + _slope * far;
+    Vector3d grow(r, r, r);
+    return RayHitsBox(_origin, _dir, _min - grow, _max + grow);
+  };
+  vector<size_t> candidates;
+  Candidates(accept, candidates);
+
+  bool found = false, foundPoint = false;
+  double best = numeric_limits<double>::max();
+  for(auto i : candidates) {
+    const Item& item = m_items[i];
+    if(item.m_removed || (foundPoint && !item.IsPoint()))
+      continue;
+    double t;
+    double d = RaySegmentDistance(_origin, _dir, item.m_a, item.m_b, t);
+    if(d > _radius + _slope * t)
+      continue;
+    if((item.IsPoint() && !foundPoint) || t < best) {
+      best = t;
+      _hit = item.m_key;
+      found = true;
+      foundPoint = item.IsPoint();
+    }
+  }
+  return found;
+}
+
+
+void
+SpatialIndex::
+PickFrustum(const Frustum& _frustum, vector<Key>& _hits) const {
+  auto accept = [&](const Point3d& _min, const Point3d& _max) {
+    Point3d center = 0.5 * (_min + _max);
+    return !_frustum.IsOutside(center, (_max - center).norm());
+  };
+  vector<size_t> candidates;
+  Candidates(accept, candidates);
+
+  for(auto i : candidates) {
+    const Item& item = m_items[i];
+    if(item.m_removed)
+      continue;
+    if(item.IsPoint() ? !_frustum.IsOutside(item.m_a, 0.) :
+        !_frustum.IsOutside(item.m_a, item.m_b))
+      _hits.push_back(item.m_key);
+  }
+
+  //Edges are indexed in pieces, so report each only once
+  sort(_hits.begin(), _hits.end());
+  _hits.erase(unique(_hits.begin(), _hits.end()), _hits.end());
+}
+
+
+void
+SpatialIndex::
+Overlapping(const Point3d& _min, const Point3d& _max, vector<Key>& _hits)
+    const {
+  auto accept = [&](const Point3d& _nodeMin, const Point3d& _nodeMax) {
+    return BoxesOverlap(_nodeMin, _nodeMax, _min, _max);
+  };
+  vector<size_t> candidates;
+  Candidates(accept, candidates);
+
+  for(auto i : candidates) {
+    const Item& item = m_items[i];
+    if(!item.m_removed && SegmentHitsBox(item.m_a, item.m_b, _min, _max))
+      _hits.push_back(item.m_key);
+  }
+
+  //Edges are indexed in pieces, so report each only once
+  sort(_hits.begin(), _hits.end());
+  _hits.erase(unique(_hits.begin(), _hits.end()), _hits.end());
+}
+
+
+vector<SpatialIndex::VID>
+SpatialIndex::
+Nearest(const Point3d& _p, size_t _k) const {
+  //Max-heap of the best nodes found so far, by squared distance
+  typedef pair<double, VID> Candidate;
+  priority_queue<Candidate> best;
+  auto consider = [&](const Item& _item) {
+    if(_item.m_removed || !_item.IsPoint())
+      return;
+    double d = (_item.m_a - _p).normsqr();
+    if(best.size() < _k)
+      best.emplace(d, _item.m_key.first);
+    else if(d < best.top().first) {
+      best.pop();
+      best.emplace(d, _item.m_key.first);
+    }
+  };
+
+  //Visit tree nodes closest first and stop once none can do better
+  typedef pair<double, size_t> Visit;
+  priority_queue<Visit, vector<Visit>, greater<Visit>> open;
+  if(_k && !m_nodes.empty())
+    open.emplace(BoxDistanceSqr(_p, m_nodes[0].m_min, m_nodes[0].m_max), 0);
+  while(!open.empty()) {
+    Visit v = open.top();
+    open.pop();
+    if(best.size() == _k && v.first >= best.top().first)
+      break;
+    const Node& node = m_nodes[v.second];
+    if(node.m_left) {
+      for(auto c : {node.m_left, node.m_right})
+        open.emplace(BoxDistanceSqr(_p, m_nodes[c].m_min, m_nodes[c].m_max),
+            c);
+    }
+    else
+      for(size_t i = node.m_first; i < node.m_last; ++i)
+        consider(m_items[m_order[i]]);
+  }
+  for(size_t i = m_numSorted; i < m_items.size() && _k; ++i)
+    consider(m_items[i]);
+
+  vector<VID> nearest(best.size());
+  for(size_t i = nearest.size(); i > 0; --i) {
+    nearest[i - 1] = best.top().second;
+    best.pop();
+  }
+  return nearest;
+}
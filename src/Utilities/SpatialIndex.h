@@ -0,0 +1,151 @@
+#ifndef SPATIAL_INDEX_H_
+#define SPATIAL_INDEX_H_
+
+#include <cstddef>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include "Vector.h"
+using namespace mathtool;
+
+class Frustum;
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief   A bounding volume hierarchy over the workspace positions of roadmap
+///          nodes and the line segments of roadmap edges, used to answer pick
+///          and neighbor queries without visiting the whole graph.
+/// \details Items are keyed by VID: a node is keyed by (v, v) and an edge by
+///          (source, target). Changes are kept in a small unsorted list and a
+///          set of removed items until they grow past an eighth of the tree,
+///          at which point Refresh rebuilds the tree.
+////////////////////////////////////////////////////////////////////////////////
+class SpatialIndex {
+
+  public:
+
+    typedef size_t VID;
+    typedef pair<VID, VID> Key;
+
+    ///\name Modification
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Remove everything from the index.
+    void Clear();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Add a node.
+    /// \param[in] _v The node VID.
+    /// \param[in] _p The node position.
+    void AddPoint(VID _v, const Point3d& _p);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Add an edge unless it is already indexed in either direction.
+    /// \param[in] _source The source VID.
+    /// \param[in] _target The target VID.
+    /// \param[in] _points The edge polyline, from source to target.
+    void AddEdge(VID _source, VID _target, const vector<Point3d>& _points);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Remove a node and every edge touching it.
+    /// \param[in] _v The node VID.
+    /// \return The other endpoints of the removed edges.
+    vector<VID> Remove(VID _v);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Rebuild the tree if too many changes are pending. Call this after
+    ///        each batch of changes.
+    void Refresh();
+
+    ///@}
+    ///\name Queries
+    ///@{
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Find the item closest to the origin of a ray among those within
+    ///        a tolerance of it. Nodes take precedence over edges.
+    /// \param[in] _origin The ray origin.
+    /// \param[in] _dir The unit ray direction.
+    /// \param[in] _radius The tolerance at the origin.
+    /// \param[in] _slope The growth of the tolerance per unit along the ray.
+    /// \param[out] _hit The key of the item found.
+    /// \return True if an item was found.
+    bool PickRay(const Point3d& _origin, const Vector3d& _dir, double _radius,
+        double _slope, Key& _hit) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Find every item inside a frustum.
+    /// \param[in] _frustum The query volume.
+    /// \param[out] _hits The keys of the items found.
+    void PickFrustum(const Frustum& _frustum, vector<Key>& _hits) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Find every item touching an axis-aligned box.
+    /// \param[in] _min The box minimum.
+    /// \param[in] _max The box maximum.
+    /// \param[out] _hits The keys of the items found.
+    void Overlapping(const Point3d& _min, const Point3d& _max,
+        vector<Key>& _hits) const;
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Find the nodes closest to a point.
+    /// \param[in] _p The query point.
+    /// \param[in] _k The number of nodes to find.
+    /// \return The node VIDs, nearest first.
+    vector<VID> Nearest(const Point3d& _p, size_t _k) const;
+
+    ///@}
+
+  private:
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief A node position or one line segment of an edge.
+    struct Item {
+      Key m_key;             ///< The item's VIDs.
+      Point3d m_a, m_b;      ///< The segment endpoints, equal for nodes.
+      bool m_removed{false}; ///< Was this item removed since the last build?
+
+      bool IsPoint() const {return m_key.first == m_key.second;}
+      Point3d Center() const {return 0.5 * (m_a + m_b);}
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief A tree node bounding a range of m_order.
+    struct Node {
+      Point3d m_min, m_max;  ///< The bounding box of the node's items.
+      size_t m_first, m_last; ///< The node's range in m_order.
+      size_t m_left{0};      ///< The first child, or 0 for a leaf.
+      size_t m_right{0};     ///< The second child.
+    };
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Append an item to the unsorted list.
+    void Add(const Item& _item);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Drop the removed items and rebuild the tree over the rest.
+    void Rebuild();
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Build the subtree over m_order[_first, _last).
+    /// \return The index of the subtree root in m_nodes.
+    size_t Build(size_t _first, size_t _last);
+
+    ////////////////////////////////////////////////////////////////////////////
+    /// \brief Get the indices of the items to test for a query: those in the
+    ///        tree nodes accepted by a box test, followed by the unsorted ones.
+    /// \param[in] _accept Decides whether to visit a tree node from its box.
+    template <typename Accept>
+    void Candidates(const Accept& _accept, vector<size_t>& _items) const;
+
+    vector<Item> m_items;      ///< All items, the tree's first.
+    vector<size_t> m_order;    ///< Tree items in leaf order.
+    vector<Node> m_nodes;      ///< The tree, rooted at the first node.
+    size_t m_numSorted{0};     ///< Number of items covered by the tree.
+    size_t m_numRemoved{0};    ///< Number of removed items still stored.
+    unordered_multimap<VID, size_t> m_byVID; ///< Item indices by endpoint VID.
+};
+
+#endif
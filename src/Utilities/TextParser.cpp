@@ -0,0 +1,174 @@
+#include "TextParser.h"
+
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace TextParser {
+
+  /*------------------------------- MappedFile -------------------------------*/
+
+  MappedFile::
+  MappedFile(const string& _filename) {
+    int fd = open(_filename.c_str(), O_RDONLY);
+    if(fd < 0)
+      throw ParseException(WHERE, "Cannot open '" + _filename + "'.");
+
+    struct stat info;
+    bool mapped = fstat(fd, &info) == 0;
+    if(mapped && info.st_size > 0) {
+      m_size = info.st_size;
+      void* data = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+      mapped = data != MAP_FAILED;
+      if(mapped) {
+        m_data = static_cast<const char*>(data);
+        madvise(data, m_size, MADV_SEQUENTIAL);
+      }
+    }
+    close(fd);
+    if(!mapped)
+      throw ParseException(WHERE, "Cannot map '" + _filename + "'.");
+  }
+
+
+  MappedFile::
+  ~MappedFile() {
+    if(m_data)
+      munmap(const_cast<char*>(m_data), m_size);
+  }
+
+  /*--------------------------------- Scanning -------------------------------*/
+
+  const char*
+  SkipBlanks(const char* _p, const char* _end) {
+    while(_p < _end && (*_p == ' ' || *_p == '\t' || *_p == '\r'))
+      ++_p;
+    return _p;
+  }
+
+
+  const char*
+  NextLine(const char* _p, const char* _end) {
+    const void* newline = memchr(_p, '\n', _end - _p);
+    return newline ? static_cast<const char*>(newline) + 1 : _end;
+  }
+
+
+  bool
+  ParseUnsigned(const char*& _p, const char* _end, size_t& _value) {
+    const char* p = SkipBlanks(_p, _end);
+    if(p == _end || !isdigit(*p))
+      return false;
+    size_t value = 0;
+    for(; p < _end && isdigit(*p); ++p)
+      value = value * 10 + (*p - '0');
+    _value = value;
+    _p = p;
+    return true;
+  }
+
+
+  bool
+  ParseDouble(const char*& _p, const char* _end, double& _value) {
+    //Powers of ten which are exact in a double
+    static const double powers[] = {1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7,
+        1e8, 1e9, 1e10, 1e11, 1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19,
+        1e20, 1e21, 1e22};
+
+    const char* start = SkipBlanks(_p, _end);
+    const char* p = start;
+    bool negative = false;
+    if(p < _end && (*p == '-' || *p == '+'))
+      negative = *p++ == '-';
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false, exact = true;
+    for(; p < _end && isdigit(*p); ++p) {
+      any = true;
+      if(digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        digits += mantissa != 0;
+      }
+      else {
+        ++exponent;
+        exact &= *p == '0';
+      }
+    }
+    if(p < _end && *p == '.')
+      for(++p; p < _end && isdigit(*p); ++p) {
+        any = true;
+        if(digits < 19) {
+          mantissa = mantissa * 10 + (*p - '0');
+          digits += mantissa != 0;
+          --exponent;
+        }
+        else
+          exact &= *p == '0';
+      }
+    if(any && p < _end && (*p == 'e' || *p == 'E')) {
+      const char* e = p + 1;
+      bool negativeExponent = false;
+      if(e < _end && (*e == '-' || *e == '+'))
+        negativeExponent = *e++ == '-';
+      if(e < _end && isdigit(*e)) {
+        int value = 0;
+        for(; e < _end && isdigit(*e); ++e)
+          value = min(value * 10 + (*e - '0'), 100000);
+        exponent += negativeExponent ? -value : value;
+        p = e;
+      }
+    }
+
+    //Take the exact path when the token ended cleanly and fits
+    bool clean = p == _end || isspace(*p);
+    if(any && clean && exact && mantissa < (uint64_t(1) << 53) &&
+        exponent >= -22 && exponent <= 22) {
+      double value = double(mantissa);
+      value = exponent < 0 ? value / powers[-exponent] :
+          value * powers[exponent];
+      _value = negative ? -value : value;
+      _p = p;
+      return true;
+    }
+
+    //Otherwise let strtod handle the whole token
+    const char* tokenEnd = start;
+    while(tokenEnd < _end && !isspace(*tokenEnd))
+      ++tokenEnd;
+    char buffer[128];
+    size_t length = tokenEnd - start;
+    if(length == 0 || length >= sizeof(buffer))
+      return false;
+    memcpy(buffer, start, length);
+    buffer[length] = '\0';
+    char* parsedEnd;
+    double value = strtod(buffer, &parsedEnd);
+    if(parsedEnd != buffer + length)
+      return false;
+    _value = value;
+    _p = tokenEnd;
+    return true;
+  }
+
+
+  vector<pair<const char*, const char*>>
+  Split(const char* _begin, const char* _end, size_t _n) {
+    vector<pair<const char*, const char*>> ranges;
+    size_t size = _end - _begin;
+    const char* start = _begin;
+    for(size_t i = 1; i <= _n && start < _end; ++i) {
+      const char* stop = i == _n ? _end :
+          max(start, NextLine(_begin + size * i / _n, _end));
+      if(stop > start)
+        ranges.emplace_back(start, stop);
+      start = stop;
+    }
+    return ranges;
+  }
+}
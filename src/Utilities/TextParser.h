@@ -0,0 +1,167 @@
+#ifndef TEXT_PARSER_H_
+#define TEXT_PARSER_H_
+
+#include <algorithm>
+#include <cctype>
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+using namespace std;
+
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include "ParseProgress.h"
+#include "VizmoExceptions.h"
+
+////////////////////////////////////////////////////////////////////////////////
+/// \brief   Parallel ingest of line-oriented text files (.map, .path, .vd).
+/// \details A file is memory mapped, cut into chunks on line boundaries, and
+///          the chunks are parsed on the QtConcurrent thread pool. Results are
+///          handed back on the calling thread in file order. Numbers are read
+///          straight from the mapped bytes without going through iostreams.
+////////////////////////////////////////////////////////////////////////////////
+namespace TextParser {
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief A read-only memory mapping of a whole file.
+  class MappedFile {
+
+    public:
+
+      //////////////////////////////////////////////////////////////////////////
+      /// \throws ParseException if the file cannot be opened or mapped.
+      MappedFile(const string& _filename);
+      ~MappedFile();
+
+      MappedFile(const MappedFile&) = delete;
+      MappedFile& operator=(const MappedFile&) = delete;
+
+      const char* begin() const {return m_data;}
+      const char* end() const {return m_data + m_size;}
+      size_t size() const {return m_size;}
+
+    private:
+
+      const char* m_data{nullptr}; ///< The mapped file.
+      size_t m_size{0};            ///< The mapped size.
+  };
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Skip whitespace other than line breaks.
+  /// \return The first non-blank character, or \c _end.
+  const char* SkipBlanks(const char* _p, const char* _end);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Get the start of the line after the one containing \c _p.
+  const char* NextLine(const char* _p, const char* _end);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Read an unsigned integer and advance past it.
+  /// \return False if no integer starts at \c _p after blanks.
+  bool ParseUnsigned(const char*& _p, const char* _end, size_t& _value);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief   Read a floating point number and advance past it.
+  /// \details Values with at most 19 significant digits and a decimal exponent
+  ///          within 22 are computed exactly from an integer mantissa. Longer
+  ///          values, infinities, and NaNs are handed to strtod.
+  /// \return False if no number starts at \c _p after blanks.
+  bool ParseDouble(const char*& _p, const char* _end, double& _value);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief Cut a range into about \c _n pieces which start and end on line
+  ///        boundaries.
+  vector<pair<const char*, const char*>> Split(const char* _begin,
+      const char* _end, size_t _n);
+
+  //////////////////////////////////////////////////////////////////////////////
+  /// \brief   Parse one record per line in parallel and consume the records in
+  ///          file order.
+  /// \details The range is processed in windows of a few tens of megabytes,
+  ///          so no more than one window of parsed records is held at once.
+  ///          Blank lines are skipped.
+  /// \tparam T The record type, which must be default constructible.
+  /// \param[in] _parse Called as <tt>bool(const char* _line, const char*
+  ///                   _lineEnd, T& _record)</tt> on worker threads. Returns
+  ///                   false for a malformed line.
+  /// \param[in] _consume Called as <tt>void(T& _record)</tt> on the calling
+  ///                     thread, in order.
+  /// \param[in] _progress If given, bytes and records are added to it after
+  ///                      each window, and its cancel flag is checked.
+  /// \throws ParseException on a malformed line or when canceled.
+  template <typename T, typename Parse, typename Consume>
+  void ParseRecords(const char* _begin, const char* _end, const Parse& _parse,
+      const Consume& _consume, ParseProgress* _progress = nullptr);
+
+  /*------------------------------ Implementation ----------------------------*/
+
+  template <typename T, typename Parse, typename Consume>
+  void
+  ParseRecords(const char* _begin, const char* _end, const Parse& _parse,
+      const Consume& _consume, ParseProgress* _progress) {
+    struct Chunk {
+      const char* m_begin;
+      const char* m_end;
+      vector<T> m_records;
+      string m_error;
+    };
+
+    static const size_t windowSize = 32 << 20;
+    const size_t numChunks = 4 * max(QThread::idealThreadCount(), 1);
+
+    vector<Chunk> chunks;
+    for(const char* window = _begin; window < _end; ) {
+      const char* windowEnd = size_t(_end - window) > windowSize ?
+          NextLine(window + windowSize, _end) : _end;
+
+      chunks.clear();
+      for(const auto& range : Split(window, windowEnd, numChunks))
+        chunks.push_back(Chunk{range.first, range.second, vector<T>(),
+            string()});
+
+      QtConcurrent::blockingMap(chunks, [&](Chunk& _c) {
+        try {
+          for(const char* line = _c.m_begin; line < _c.m_end; ) {
+            const char* next = NextLine(line, _c.m_end);
+            const char* lineEnd = next;
+            while(lineEnd > line && isspace(lineEnd[-1]))
+              --lineEnd;
+            if(SkipBlanks(line, lineEnd) != lineEnd) {
+              _c.m_records.emplace_back();
+              if(!_parse(line, lineEnd, _c.m_records.back())) {
+                _c.m_error = "Malformed line '" + string(line,
+                    min<size_t>(lineEnd - line, 80)) + "'.";
+                return;
+              }
+            }
+            line = next;
+          }
+        }
+        catch(PMPLException& _e) {
+          _c.m_error = _e.what();
+        }
+      });
+
+      size_t count = 0;
+      for(auto& chunk : chunks) {
+        if(!chunk.m_error.empty())
+          throw ParseException(WHERE, chunk.m_error);
+        for(auto& record : chunk.m_records)
+          _consume(record);
+        count += chunk.m_records.size();
+      }
+
+      if(_progress) {
+        _progress->m_bytes += windowEnd - window;
+        _progress->m_items += count;
+        if(_progress->m_cancel)
+          throw ParseException(WHERE, "Parsing was canceled.");
+      }
+      window = windowEnd;
+    }
+  }
+}
+
+#endif